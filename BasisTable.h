@@ -0,0 +1,70 @@
+/*
+ * BasisTable.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BASISTABLE_H_
+#define BASISTABLE_H_
+
+#include <vector>
+
+// The Bernstein polynomials of one degree and their derivatives at the parameters i * stepSize (i = 0 ... numberOfSteps)
+// of a uniform tessellation, so that evaluating a grid needs no basis evaluation per point
+class BasisTable {
+	public:
+		int degree, numberOfSteps;
+		float stepSize;
+
+		// values[(degree + 1) * i + k] is the k-th polynomial at i * stepSize (and likewise for derivatives)
+		std::vector<float> values, derivatives;
+
+	BasisTable() {
+		degree = numberOfSteps = 0;
+		stepSize = 0.0f;
+	}
+
+	BasisTable(int degree, int numberOfSteps, float stepSize) {
+		this->degree = degree;
+		this->numberOfSteps = numberOfSteps;
+		this->stepSize = stepSize;
+		values.resize((degree + 1) * (numberOfSteps + 1));
+		derivatives.resize(values.size());
+		for (int i = 0; i <= numberOfSteps; i++) {
+			bernsteinBasis(degree, i * stepSize, &values[(degree + 1) * i], &derivatives[(degree + 1) * i]);
+		}
+	}
+
+	//****************************************************
+	// Computes the degree + 1 Bernstein polynomials of degree 'degree' and their derivatives at t,
+	// by raising the degree one step at a time
+	//***************************************************
+	static void bernsteinBasis(int degree, float t, float* basis, float* derivative) {
+		float s = 1.0f - t;
+		basis[0] = 1.0f;
+		for (int currentDegree = 1; currentDegree <= degree; currentDegree++) {
+			// The derivatives of the degree n polynomials come from the degree n - 1 ones
+			if (currentDegree == degree) {
+				for (int i = 0; i <= degree; i++) {
+					derivative[i] = degree * ((i > 0 ? basis[i - 1] : 0.0f) - (i < degree ? basis[i] : 0.0f));
+				}
+			}
+			basis[currentDegree] = t * basis[currentDegree - 1];
+			for (int i = currentDegree - 1; i > 0; i--) {
+				basis[i] = s * basis[i] + t * basis[i - 1];
+			}
+			basis[0] = s * basis[0];
+		}
+	}
+
+	const float* valuesAt(int i) const {
+		return &values[(degree + 1) * i];
+	}
+
+	const float* derivativesAt(int i) const {
+		return &derivatives[(degree + 1) * i];
+	}
+};
+
+
+#endif /* BASISTABLE_H_ */
@@ -8,44 +8,219 @@
 #ifndef BEZIERPATCH_H_
 #define BEZIERPATCH_H_
 
-#include <queue>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <utility>
+
+// Criteria that adaptive subdivision can use to decide whether a triangle edge has to be split (see edgeNeedsSplit)
+enum AdaptiveSplitMetric {
+	// distance between the surface and the edge at the edge's midpoint (the error is a distance)
+	CHORD_METRIC,
+	// angle the surface normal turns through along the edge (the error is an angle, in degrees)
+	NORMAL_METRIC,
+	// distance between the surface and the edge, estimated from the surface's curvature along the edge
+	// (the error is a distance)
+	CURVATURE_METRIC
+};
 
 class BezierPatch {
 	public:
+		// Control points: listOfCurves[row][column], with degreeV() + 1 rows of degreeU() + 1 points each
 		std::vector<std::vector <Eigen::Vector3f> > listOfCurves;
 
+		// Weights of the control points (same layout as listOfCurves) for rational patches; empty for polynomial ones
+		std::vector<std::vector<float> > weights;
+
+		// Whether this is a triangular patch of degree n over the (u, v) triangle u, v >= 0, u + v <= 1, instead of a
+		// tensor product patch over the unit square. Its control point P(i, j, k) (i + j + k = n, weighted by
+		// u^i v^j (1 - u - v)^k) is listOfCurves[j][i], so row j holds n + 1 - j points.
+		bool triangular;
+
 		// final list of subdivided triangles, ready to feed to OpenGL display system
 		std::vector<Triangle> listOfTriangles;
 
 		// list of differential geometries (i.e. points) that we are evaluating the given patch at
 		std::vector<DifferentialGeometry> listOfDifferentialGeometries;
 
-		// queue of triangles for adaptive triangulation
-		std::queue<Triangle> queueOfTriangles;
+		// Number of steps of the uniform grid listOfDifferentialGeometries holds (see performUniformSubdivision), or 0
+		// if the points are not such a grid
+		int uniformSteps;
 
-	BezierPatch() {
+		// Optional index buffers into listOfDifferentialGeometries, for drawing with vertex arrays: three indices per
+		// triangle of listOfTriangles (in the same order), and triangle strips separated by a restart index (for
+		// uniform grids only). Both are empty unless they were built.
+		std::vector<unsigned int> indices;
+		std::vector<unsigned int> triangleStrips;
+
+		// The patch's points, quantized (see compress). A compressed patch keeps its triangles only as 'indices' into
+		// these vertices, and its listOfTriangles and listOfDifferentialGeometries are empty.
+		QuantizedMesh compressedMesh;
 
+		// Whether control points moved (through setControlPoint) since the tessellation was last brought up to date
+		bool controlPointsChanged;
+
+	BezierPatch() {
+		triangular = false;
+		uniformSteps = 0;
+		controlPointsChanged = false;
 	}
 
+	// A patch owns its (potentially very large) tessellation buffers, so patches may only be moved, never copied.
+	// Any accidental by-value copy in the render or stats paths is now a compile error.
+	BezierPatch(const BezierPatch&) = delete;
+	BezierPatch& operator=(const BezierPatch&) = delete;
+	BezierPatch(BezierPatch&&) = default;
+	BezierPatch& operator=(BezierPatch&&) = default;
+
 	// Adds a curve to the list of curves.
-	// NOTE: A curve, at initialization from the command line, is represented by a length-4 list of Vector3f's.
-	//       That is, a curve is represented by a list of four points.
-	void addCurve(std::vector<Eigen::Vector3f> curve) {
+	// NOTE: A curve, at initialization from the command line, is represented by a list of degreeU() + 1 Vector3f's
+	//       (four points for the usual bicubic patches).
+	void addCurve(const std::vector<Eigen::Vector3f>& curve) {
+		listOfCurves.push_back(curve);
+	}
+
+	// Adds a curve of a rational patch, together with the weights of its points
+	void addCurve(const std::vector<Eigen::Vector3f>& curve, const std::vector<float>& curveWeights) {
 		listOfCurves.push_back(curve);
+		weights.push_back(curveWeights);
 	}
 
-	void addTriangle(DifferentialGeometry vertex1, DifferentialGeometry vertex2, DifferentialGeometry vertex3) {
+	int degreeU() const {
+		return listOfCurves[0].size() - 1;
+	}
+
+	int degreeV() const {
+		return listOfCurves.size() - 1;
+	}
+
+	bool isRational() const {
+		return !weights.empty();
+	}
+
+	// The common case, which has its own (faster) evaluation code
+	bool isPolynomialBicubic() const {
+		return !triangular && listOfCurves.size() == 4 && listOfCurves[0].size() == 4 && weights.empty();
+	}
+
+	// Moves control point listOfCurves[row][column] (the tessellation is only updated by a PatchRetessellator)
+	void setControlPoint(int row, int column, const Eigen::Vector3f& point) {
+		if (listOfCurves[row][column] != point) {
+			listOfCurves[row][column] = point;
+			controlPointsChanged = true;
+		}
+	}
+
+	void addTriangle(const DifferentialGeometry& vertex1, const DifferentialGeometry& vertex2, const DifferentialGeometry& vertex3) {
 		listOfTriangles.push_back(Triangle(vertex1, vertex2, vertex3));
 	}
 
-	void addDifferentialGeometry(Eigen::Vector3f position, Eigen::Vector3f normal, Eigen::Vector2f uvValues) {
+	void addDifferentialGeometry(const Eigen::Vector3f& position, const Eigen::Vector3f& normal, const Eigen::Vector2f& uvValues) {
 		listOfDifferentialGeometries.push_back(DifferentialGeometry(position, normal, uvValues));
 	}
 
+	// Fills 'indices' with three indices into listOfDifferentialGeometries per triangle, matching corners to points
+	// bit for bit (corners that are not in the list yet are added at its end)
+	void buildIndices() {
+		std::unordered_map<std::string, unsigned int> indexOfPoint;
+		for (std::vector<DifferentialGeometry>::size_type i = 0; i < listOfDifferentialGeometries.size(); i++) {
+			indexOfPoint.insert(std::make_pair(pointKey(listOfDifferentialGeometries[i]), i));
+		}
+		indices.clear();
+		indices.reserve(3 * listOfTriangles.size());
+		for (std::vector<Triangle>::size_type i = 0; i < listOfTriangles.size(); i++) {
+			const DifferentialGeometry* corners[3] = { &listOfTriangles[i].point1, &listOfTriangles[i].point2, &listOfTriangles[i].point3 };
+			for (int k = 0; k < 3; k++) {
+				std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> entry =
+						indexOfPoint.insert(std::make_pair(pointKey(*corners[k]), listOfDifferentialGeometries.size()));
+				if (entry.second) {
+					listOfDifferentialGeometries.push_back(*corners[k]);
+				}
+				indices.push_back(entry.first->second);
+			}
+		}
+	}
+
+	// Rebuilds listOfTriangles from 'indices' (after they have been reordered)
+	void trianglesFromIndices() {
+		listOfTriangles.clear();
+		for (std::vector<unsigned int>::size_type i = 0; i + 2 < indices.size(); i += 3) {
+			addTriangle(listOfDifferentialGeometries[indices[i]], listOfDifferentialGeometries[indices[i + 1]],
+					listOfDifferentialGeometries[indices[i + 2]]);
+		}
+	}
+
+	bool isCompressed() const {
+		return !compressedMesh.vertices.empty();
+	}
+
+	//****************************************************
+	// Replaces the tessellation with its quantized form (compressedMesh and 'indices'), releasing the float lists.
+	// Returns the largest differences between the original and the decoded points.
+	//***************************************************
+	QuantizationError compress() {
+		if (isCompressed() || listOfTriangles.empty()) {
+			return QuantizationError();
+		}
+		if (indices.size() != 3 * listOfTriangles.size()) {
+			buildIndices();
+		}
+		compressedMesh.encode(listOfDifferentialGeometries);
+		QuantizationError error = compressedMesh.measureError(listOfDifferentialGeometries);
+		std::vector<Triangle>().swap(listOfTriangles);
+		std::vector<DifferentialGeometry>().swap(listOfDifferentialGeometries);
+		return error;
+	}
+
+	// Gives back the memory the tessellation lists reserved beyond what they hold
+	void shrinkTessellation() {
+		listOfTriangles.shrink_to_fit();
+		listOfDifferentialGeometries.shrink_to_fit();
+	}
+
+	// Frees the tessellation (in any form), leaving the patch as if it had never been tessellated
+	void releaseTessellation() {
+		std::vector<Triangle>().swap(listOfTriangles);
+		std::vector<DifferentialGeometry>().swap(listOfDifferentialGeometries);
+		std::vector<unsigned int>().swap(indices);
+		std::vector<unsigned int>().swap(triangleStrips);
+		std::vector<QuantizedVertex>().swap(compressedMesh.vertices);
+		uniformSteps = 0;
+	}
+
+	// The following read the tessellation whether or not the patch is compressed
+	int numberOfTriangles() const {
+		return isCompressed() ? indices.size() / 3 : listOfTriangles.size();
+	}
+
+	int numberOfPoints() const {
+		return isCompressed() ? compressedMesh.vertices.size() : listOfDifferentialGeometries.size();
+	}
+
+	Triangle triangle(int index) const {
+		if (!isCompressed()) {
+			return listOfTriangles[index];
+		}
+		const std::vector<QuantizedVertex>& vertices = compressedMesh.vertices;
+		return Triangle(compressedMesh.decodeVertex(vertices[indices[3 * index]]),
+				compressedMesh.decodeVertex(vertices[indices[3 * index + 1]]),
+				compressedMesh.decodeVertex(vertices[indices[3 * index + 2]]));
+	}
+
+	// Memory taken by the tessellation (the float lists, or the quantized vertices, plus the index buffers)
+	size_t tessellationMemory() const {
+		return listOfTriangles.capacity() * sizeof(Triangle) + listOfDifferentialGeometries.capacity() * sizeof(DifferentialGeometry)
+				+ (indices.capacity() + triangleStrips.capacity()) * sizeof(unsigned int) + compressedMesh.vertices.capacity() * sizeof(QuantizedVertex);
+	}
+
+	static std::string pointKey(const DifferentialGeometry& point) {
+		float values[8] = { point.position.x(), point.position.y(), point.position.z(),
+				point.normal.x(), point.normal.y(), point.normal.z(), point.uvValues.x(), point.uvValues.y() };
+		return std::string((const char*) values, sizeof(values));
+	}
+
 
 
 
@@ -57,7 +232,7 @@ class BezierPatch {
 	//
 	// NOTE: This method is given in the last slide of CS184 Spring 2015 Lecture 14 (O'Brien)
 	//***************************************************
-	CurveLocalGeometry interpretBezierCurve(std::vector<Eigen::Vector3f> curve, float u) {
+	CurveLocalGeometry interpretBezierCurve(const std::vector<Eigen::Vector3f>& curve, float u) const {
 		// First, split each of the three segments to form two new ones, AB and BC
 		// NOTE: 'curve' is a length-4 list of Vector3f's. Each Vector3f represents a control point of the curve.
 		Eigen::Vector3f A = (curve[0] * (1.0 - u)) + (curve[1] * u);
@@ -84,7 +259,14 @@ class BezierPatch {
 	//
 	// NOTE: This method is given in the last slide of CS184 Spring 2015 Lecture 14 (O'Brien)
 	//***************************************************
-	DifferentialGeometry evaluateDifferentialGeometry(float u, float v) {
+	DifferentialGeometry evaluateDifferentialGeometry(float u, float v) const {
+		// Other degrees and rational patches go through the general tensor product evaluator
+		if (!isPolynomialBicubic()) {
+			Eigen::Vector3f position, dPdu, dPdv;
+			evaluatePartialDerivatives(u, v, position, dPdu, dPdv);
+			return DifferentialGeometry(position, surfaceNormal(u, v, dPdu, dPdv), Eigen::Vector2f(u, v));
+		}
+
 		// listOfCurves[i] returns a list of points that represents one curve
 
 		// Build control points for a Bezier curve in v
@@ -140,139 +322,529 @@ class BezierPatch {
 		CurveLocalGeometry finalUCurve = interpretBezierCurve(uCurve, u);
 
 		// Take cross product of partials to find normal
-		Eigen::Vector3f normal = finalUCurve.derivative.cross(finalVCurve.derivative);
-		normal.normalize();
+		Eigen::Vector3f normal = surfaceNormal(u, v, finalUCurve.derivative, finalVCurve.derivative);
 
 		return DifferentialGeometry(finalUCurve.point, normal, Eigen::Vector2f(u, v));
 	}
 
 
+	// Whether the partial derivatives dPdu and dPdv (and their cross product 'normal') do not determine a normal:
+	// one of them vanishes (compared to the other), or they are parallel
+	static bool isDegenerateNormal(const Eigen::Vector3f& dPdu, const Eigen::Vector3f& dPdv, const Eigen::Vector3f& normal) {
+		return !(normal.norm() > 1e-5f * (dPdu.squaredNorm() + dPdv.squaredNorm()));
+	}
+
+
 	//****************************************************
-	// TODO: Method that populates each BezierPatch's list of DifferentialGeometries
-	// and list of Triangles, based on adaptive subdivision
+	// Returns the unit normal dPdu x dPdv at (u, v), given the partial derivatives there.
+	//
+	// At collapsed edges and corners (like the poles of the teapot's lid and spout, where a whole row of control points
+	// is the same point) one of the derivatives is zero, and so is their cross product. The normal there is the limit of
+	// the normals approaching (u, v) from inside the patch, which we get by stepping a small (growing) fraction of the
+	// way toward the middle of the patch until the derivatives are no longer degenerate. The step follows the surface
+	// continuously, so the normal matches those of the neighbouring vertices and keeps its orientation.
+	//
+	// Returns a zero vector if no normal can be found (e.g. the whole patch collapsed to a curve)
 	//***************************************************
-	void performAdaptiveSubdivision(float error) {
+	Eigen::Vector3f surfaceNormal(float u, float v, const Eigen::Vector3f& dPdu, const Eigen::Vector3f& dPdv) const {
+		Eigen::Vector3f normal = dPdu.cross(dPdv);
+		if (!isDegenerateNormal(dPdu, dPdv, normal)) {
+			normal.normalize();
+			return normal;
+		}
 
-		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(0, 0));
-		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(0, 1));
-		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(1, 0));
-		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(1, 1));
+		float middle = triangular ? 1.0f / 3.0f : 0.5f;
+		Eigen::Vector3f position, nearbyDPdu, nearbyDPdv;
+		for (float step = 1e-3f; step < 0.5f; step *= 4.0f) {
+			float nearbyU = u + step * (middle - u);
+			float nearbyV = v + step * (middle - v);
+			evaluatePartialDerivatives(nearbyU, nearbyV, position, nearbyDPdu, nearbyDPdv);
+			normal = nearbyDPdu.cross(nearbyDPdv);
+			if (!isDegenerateNormal(nearbyDPdu, nearbyDPdv, normal)) {
+				normal.normalize();
+				return normal;
+			}
+		}
+		return Eigen::Vector3f::Zero();
+	}
 
-		queueOfTriangles.push(Triangle(listOfDifferentialGeometries[1], listOfDifferentialGeometries[2], listOfDifferentialGeometries[0]));
-		queueOfTriangles.push(Triangle(listOfDifferentialGeometries[2], listOfDifferentialGeometries[1], listOfDifferentialGeometries[3]));
 
-		DifferentialGeometry midpointInterpolatedValueAB;
-		DifferentialGeometry midpointInterpolatedValueBC;
-		DifferentialGeometry midpointInterpolatedValueAC;
+	//****************************************************
+	// Computes the four cubic Bernstein polynomials and their derivatives at t
+	//***************************************************
+	static void cubicBernstein(float t, float* basis, float* derivative) {
+		float s = 1.0f - t;
+		basis[0] = s * s * s;
+		basis[1] = 3.0f * t * s * s;
+		basis[2] = 3.0f * t * t * s;
+		basis[3] = t * t * t;
+		derivative[0] = -3.0f * s * s;
+		derivative[1] = 3.0f * s * s - 6.0f * t * s;
+		derivative[2] = 6.0f * t * s - 3.0f * t * t;
+		derivative[3] = 3.0f * t * t;
+	}
 
-		while (!queueOfTriangles.empty()) {
 
-			Triangle currentTriangleToTest = queueOfTriangles.front();
-			DifferentialGeometry pointA = currentTriangleToTest.point1;
-			DifferentialGeometry pointB = currentTriangleToTest.point2;
-			DifferentialGeometry pointC = currentTriangleToTest.point3;
-			queueOfTriangles.pop();
+	//****************************************************
+	// Evaluates the position and both partial derivatives of a tensor product patch of degree (DegreeU, DegreeV)
+	// at (u, v). A degree of 0 means "not known at compile time", in which case the patch's own degree is used.
+	// Rational patches are evaluated in homogeneous coordinates and then projected back, using the quotient rule
+	// dP = (dA - P * dw) / w for the derivatives.
+	//***************************************************
+	template<int DegreeU, int DegreeV>
+	void evaluateTensorProduct(float u, float v, Eigen::Vector3f& position, Eigen::Vector3f& dPdu, Eigen::Vector3f& dPdv) const {
+		const int uDegree = DegreeU > 0 ? DegreeU : degreeU();
+		const int vDegree = DegreeV > 0 ? DegreeV : degreeV();
 
-			bool abSplit = false;
-			bool bcSplit = false;
-			bool acSplit = false;
+		// Fixed size storage when the degrees are known, heap storage otherwise
+		float uFixed[2 * (DegreeU > 0 ? DegreeU + 1 : 1)], vFixed[2 * (DegreeV > 0 ? DegreeV + 1 : 1)];
+		std::vector<float> uDynamic, vDynamic;
+		float* uBasis = uFixed;
+		float* vBasis = vFixed;
+		if (DegreeU <= 0) {
+			uDynamic.resize(2 * (uDegree + 1));
+			uBasis = uDynamic.data();
+		}
+		if (DegreeV <= 0) {
+			vDynamic.resize(2 * (vDegree + 1));
+			vBasis = vDynamic.data();
+		}
+		float* uDerivative = uBasis + uDegree + 1;
+		float* vDerivative = vBasis + vDegree + 1;
+		BasisTable::bernsteinBasis(uDegree, u, uBasis, uDerivative);
+		BasisTable::bernsteinBasis(vDegree, v, vBasis, vDerivative);
 
-			// Checking whether A -> B needs to be split
-			Eigen::Vector2f uvValueToInterpolate = (pointA.uvValues + pointB.uvValues)/2.0f;
-			midpointInterpolatedValueAB = evaluateDifferentialGeometry(uvValueToInterpolate.x(), uvValueToInterpolate.y());
+		bool rational = isRational();
+		Eigen::Vector3f point = Eigen::Vector3f::Zero();
+		Eigen::Vector3f pointDu = Eigen::Vector3f::Zero();
+		Eigen::Vector3f pointDv = Eigen::Vector3f::Zero();
+		float weight = 0.0f, weightDu = 0.0f, weightDv = 0.0f;
+		for (int row = 0; row <= vDegree; row++) {
+			Eigen::Vector3f rowPoint = Eigen::Vector3f::Zero();
+			Eigen::Vector3f rowDerivative = Eigen::Vector3f::Zero();
+			float rowWeight = 0.0f, rowWeightDerivative = 0.0f;
+			for (int column = 0; column <= uDegree; column++) {
+				float controlWeight = rational ? weights[row][column] : 1.0f;
+				Eigen::Vector3f controlPoint = controlWeight * listOfCurves[row][column];
+				rowPoint += uBasis[column] * controlPoint;
+				rowDerivative += uDerivative[column] * controlPoint;
+				rowWeight += uBasis[column] * controlWeight;
+				rowWeightDerivative += uDerivative[column] * controlWeight;
+			}
+			point += vBasis[row] * rowPoint;
+			pointDu += vBasis[row] * rowDerivative;
+			pointDv += vDerivative[row] * rowPoint;
+			weight += vBasis[row] * rowWeight;
+			weightDu += vBasis[row] * rowWeightDerivative;
+			weightDv += vDerivative[row] * rowWeight;
+		}
 
-			Eigen::Vector3f midpointApproximatedValue = (pointB.position - pointA.position)/2.0f + (pointA.position);
+		if (!rational) {
+			position = point;
+			dPdu = pointDu;
+			dPdv = pointDv;
+			return;
+		}
+		position = point / weight;
+		dPdu = (pointDu - position * weightDu) / weight;
+		dPdv = (pointDv - position * weightDv) / weight;
+	}
 
-			Eigen::Vector3f errorVector = midpointInterpolatedValueAB.position - midpointApproximatedValue;
-			float errorValue = sqrt(errorVector.dot(errorVector));
 
+	//****************************************************
+	// Evaluates the position and both partial derivatives of a triangular patch at (u, v) with the barycentric
+	// de Casteljau algorithm: every step replaces each triangle of neighbouring control points
+	// P(i + 1, j, k), P(i, j + 1, k), P(i, j, k + 1) by u P(i + 1, j, k) + v P(i, j + 1, k) + w P(i, j, k + 1),
+	// w = 1 - u - v, until a single (linear) triangle b100, b010, b001 is left. Its corner differences give the
+	// derivatives dP/du = n (b100 - b001) and dP/dv = n (b010 - b001).
+	// Rational patches run the same steps on homogeneous points and are projected back at the end.
+	//***************************************************
+	void evaluateTriangular(float u, float v, Eigen::Vector3f& position, Eigen::Vector3f& dPdu, Eigen::Vector3f& dPdv) const {
+		const int degree = degreeV();
+		const int stride = degree + 1;
+		float w = 1.0f - u - v;
+		bool rational = isRational();
 
-			if (errorValue >= error) {
-				abSplit = true;
+		// points[j * stride + i] holds P(i, j, .) (premultiplied by its weight for rational patches), worked on in place
+		const int FIXED_STRIDE = 8;
+		Eigen::Vector3f fixedPoints[FIXED_STRIDE * FIXED_STRIDE];
+		float fixedWeights[FIXED_STRIDE * FIXED_STRIDE];
+		std::vector<Eigen::Vector3f> dynamicPoints;
+		std::vector<float> dynamicWeights;
+		Eigen::Vector3f* points = fixedPoints;
+		float* pointWeights = fixedWeights;
+		if (stride > FIXED_STRIDE) {
+			dynamicPoints.resize(stride * stride);
+			dynamicWeights.resize(stride * stride);
+			points = dynamicPoints.data();
+			pointWeights = dynamicWeights.data();
+		}
+		for (int j = 0; j <= degree; j++) {
+			for (int i = 0; i + j <= degree; i++) {
+				pointWeights[j * stride + i] = rational ? weights[j][i] : 1.0f;
+				points[j * stride + i] = pointWeights[j * stride + i] * listOfCurves[j][i];
 			}
+		}
+
+		// Reduce to degree 1. P(i, j) only reads P(i + 1, j) and P(i, j + 1), which are still untouched
+		// when i and j go up
+		for (int currentDegree = degree; currentDegree > 1; currentDegree--) {
+			for (int j = 0; j < currentDegree; j++) {
+				for (int i = 0; i + j < currentDegree; i++) {
+					int index = j * stride + i;
+					points[index] = u * points[index + 1] + v * points[index + stride] + w * points[index];
+					pointWeights[index] = u * pointWeights[index + 1] + v * pointWeights[index + stride] + w * pointWeights[index];
+				}
+			}
+		}
+
+		const Eigen::Vector3f& b100 = points[1];
+		const Eigen::Vector3f& b010 = points[stride];
+		const Eigen::Vector3f& b001 = points[0];
+		Eigen::Vector3f point = u * b100 + v * b010 + w * b001;
+		Eigen::Vector3f pointDu = degree * (b100 - b001);
+		Eigen::Vector3f pointDv = degree * (b010 - b001);
+
+		if (!rational) {
+			position = point;
+			dPdu = pointDu;
+			dPdv = pointDv;
+			return;
+		}
+		float weight = u * pointWeights[1] + v * pointWeights[stride] + w * pointWeights[0];
+		position = point / weight;
+		dPdu = (pointDu - position * degree * (pointWeights[1] - pointWeights[0])) / weight;
+		dPdv = (pointDv - position * degree * (pointWeights[stride] - pointWeights[0])) / weight;
+	}
 
-			// Checking whether B -> C needs to be split
-			uvValueToInterpolate = (pointB.uvValues + pointC.uvValues)/2.0f;
-			midpointInterpolatedValueBC = evaluateDifferentialGeometry(uvValueToInterpolate.x(), uvValueToInterpolate.y());
 
-			midpointApproximatedValue = (pointC.position - pointB.position)/2.0f + (pointB.position);
+	//****************************************************
+	// Evaluates the position and both partial derivatives of 'this' BezierPatch at (u, v),
+	// straight from the Bernstein polynomials (cheaper than evaluateDifferentialGeometry, and
+	// returns the unnormalized derivatives that root finding needs)
+	//***************************************************
+	void evaluatePartialDerivatives(float u, float v, Eigen::Vector3f& position, Eigen::Vector3f& dPdu, Eigen::Vector3f& dPdv) const {
+		if (triangular) {
+			evaluateTriangular(u, v, position, dPdu, dPdv);
+			return;
+		}
+		if (!isPolynomialBicubic()) {
+			// Low degrees get an evaluator with fixed size loops; anything else uses the runtime degrees
+			int uDegree = degreeU(), vDegree = degreeV();
+			if (uDegree == vDegree && uDegree == 1) {
+				evaluateTensorProduct<1, 1>(u, v, position, dPdu, dPdv);
+			} else if (uDegree == vDegree && uDegree == 2) {
+				evaluateTensorProduct<2, 2>(u, v, position, dPdu, dPdv);
+			} else if (uDegree == vDegree && uDegree == 3) {
+				evaluateTensorProduct<3, 3>(u, v, position, dPdu, dPdv);
+			} else if (uDegree == 2 && vDegree == 1) {
+				evaluateTensorProduct<2, 1>(u, v, position, dPdu, dPdv);
+			} else if (uDegree == 1 && vDegree == 2) {
+				evaluateTensorProduct<1, 2>(u, v, position, dPdu, dPdv);
+			} else {
+				evaluateTensorProduct<0, 0>(u, v, position, dPdu, dPdv);
+			}
+			return;
+		}
 
-			errorVector = midpointInterpolatedValueBC.position - midpointApproximatedValue;
-			errorValue = sqrt(errorVector.dot(errorVector));
+		float uBasis[4], uDerivative[4], vBasis[4], vDerivative[4];
+		cubicBernstein(u, uBasis, uDerivative);
+		cubicBernstein(v, vBasis, vDerivative);
 
-			if (errorValue >= error) {
-				bcSplit = true;
+		position = dPdu = dPdv = Eigen::Vector3f::Zero();
+		for (int row = 0; row < 4; row++) {
+			Eigen::Vector3f rowPoint = Eigen::Vector3f::Zero();
+			Eigen::Vector3f rowDerivative = Eigen::Vector3f::Zero();
+			for (int column = 0; column < 4; column++) {
+				rowPoint += uBasis[column] * listOfCurves[row][column];
+				rowDerivative += uDerivative[column] * listOfCurves[row][column];
 			}
+			position += vBasis[row] * rowPoint;
+			dPdu += vBasis[row] * rowDerivative;
+			dPdv += vDerivative[row] * rowPoint;
+		}
+	}
 
-			// Checking whether A -> C needs to be split
-			uvValueToInterpolate = (pointA.uvValues + pointC.uvValues)/2.0f;
-			midpointInterpolatedValueAC = evaluateDifferentialGeometry(uvValueToInterpolate.x(), uvValueToInterpolate.y());
 
-			midpointApproximatedValue = (pointC.position - pointA.position)/2.0f + (pointA.position);
+	//****************************************************
+	// Computes the second partial derivatives of 'this' BezierPatch at (u, v), along with the first ones.
+	// Polynomial tensor product patches use the second derivatives of their Bernstein polynomials; rational and
+	// triangular patches use central differences of the (exact) first derivatives.
+	//***************************************************
+	void evaluateSecondDerivatives(float u, float v, Eigen::Vector3f& dPdu, Eigen::Vector3f& dPdv,
+			Eigen::Vector3f& dPduu, Eigen::Vector3f& dPduv, Eigen::Vector3f& dPdvv) const {
+		Eigen::Vector3f position;
+		evaluatePartialDerivatives(u, v, position, dPdu, dPdv);
+
+		if (triangular || isRational()) {
+			const float h = 1e-3f;
+			Eigen::Vector3f dPduPlus, dPdvPlus, dPduMinus, dPdvMinus;
+			evaluatePartialDerivatives(u + h, v, position, dPduPlus, dPdvPlus);
+			evaluatePartialDerivatives(u - h, v, position, dPduMinus, dPdvMinus);
+			dPduu = (dPduPlus - dPduMinus) / (2 * h);
+			dPduv = (dPdvPlus - dPdvMinus) / (2 * h);
+			evaluatePartialDerivatives(u, v + h, position, dPduPlus, dPdvPlus);
+			evaluatePartialDerivatives(u, v - h, position, dPduMinus, dPdvMinus);
+			dPdvv = (dPdvPlus - dPdvMinus) / (2 * h);
+			return;
+		}
 
-			errorVector = midpointInterpolatedValueAC.position - midpointApproximatedValue;
-			errorValue = sqrt(errorVector.dot(errorVector));
-			if (errorValue >= error) {
-				acSplit = true;
+		int uDegree = degreeU(), vDegree = degreeV();
+		std::vector<float> uBasis(uDegree + 1), uDerivative(uDegree + 1), uSecond(uDegree + 1);
+		std::vector<float> vBasis(vDegree + 1), vDerivative(vDegree + 1), vSecond(vDegree + 1);
+		BasisTable::bernsteinBasis(uDegree, u, uBasis.data(), uDerivative.data());
+		BasisTable::bernsteinBasis(vDegree, v, vBasis.data(), vDerivative.data());
+		bernsteinSecondDerivative(uDegree, u, uSecond.data());
+		bernsteinSecondDerivative(vDegree, v, vSecond.data());
+
+		dPduu = dPduv = dPdvv = Eigen::Vector3f::Zero();
+		for (int row = 0; row <= vDegree; row++) {
+			Eigen::Vector3f rowPoint = Eigen::Vector3f::Zero();
+			Eigen::Vector3f rowDerivative = Eigen::Vector3f::Zero();
+			Eigen::Vector3f rowSecond = Eigen::Vector3f::Zero();
+			for (int column = 0; column <= uDegree; column++) {
+				rowPoint += uBasis[column] * listOfCurves[row][column];
+				rowDerivative += uDerivative[column] * listOfCurves[row][column];
+				rowSecond += uSecond[column] * listOfCurves[row][column];
 			}
+			dPduu += vBasis[row] * rowSecond;
+			dPduv += vDerivative[row] * rowDerivative;
+			dPdvv += vSecond[row] * rowPoint;
+		}
+	}
+
+
+	//****************************************************
+	// Computes the second derivatives of the degree + 1 Bernstein polynomials of degree 'degree' at t,
+	// from the degree - 2 ones: B''(i, n) = n (n - 1) (B(i - 2, n - 2) - 2 B(i - 1, n - 2) + B(i, n - 2))
+	//***************************************************
+	static void bernsteinSecondDerivative(int degree, float t, float* second) {
+		for (int i = 0; i <= degree; i++) {
+			second[i] = 0.0f;
+		}
+		if (degree < 2) {
+			return;
+		}
+		std::vector<float> lowerBasis(degree - 1), lowerDerivative(degree - 1);
+		BasisTable::bernsteinBasis(degree - 2, t, lowerBasis.data(), lowerDerivative.data());
+		for (int i = 0; i <= degree - 2; i++) {
+			float scaled = degree * (degree - 1) * lowerBasis[i];
+			second[i] += scaled;
+			second[i + 1] -= 2.0f * scaled;
+			second[i + 2] += scaled;
+		}
+	}
+
+
+	//****************************************************
+	// Returns the curvature, at (u, v), of the curve that 'this' BezierPatch traces in the (u, v) direction 'direction':
+	// |C' x C''| / |C'|^3 with C' = dPdu du + dPdv dv and C'' = dPduu du^2 + 2 dPduv du dv + dPdvv dv^2.
+	// This is the surface's normal curvature in that direction (from its second fundamental form) combined with
+	// the curve's bending within the surface, so it also sees edges that follow a curved boundary of a flat region.
+	//
+	// Where the curve has no tangent (at a collapsed edge), the curvature is taken from slightly inside the patch,
+	// as in surfaceNormal.
+	//***************************************************
+	float directionalCurvature(float u, float v, const Eigen::Vector2f& direction) const {
+		float du = direction.x(), dv = direction.y();
+		float middle = triangular ? 1.0f / 3.0f : 0.5f;
+		Eigen::Vector3f dPdu, dPdv, dPduu, dPduv, dPdvv;
+		for (float step = 0.0f; step < 0.5f; step = (step == 0.0f) ? 1e-3f : 4.0f * step) {
+			evaluateSecondDerivatives(u + step * (middle - u), v + step * (middle - v), dPdu, dPdv, dPduu, dPduv, dPdvv);
+			Eigen::Vector3f tangent = du * dPdu + dv * dPdv;
+			Eigen::Vector3f secondDerivative = du * du * dPduu + 2.0f * du * dv * dPduv + dv * dv * dPdvv;
+			float speed = tangent.norm();
+			if (speed > 1e-5f * (fabs(du) * dPdu.norm() + fabs(dv) * dPdv.norm())) {
+				return tangent.cross(secondDerivative).norm() / (speed * speed * speed);
+			}
+		}
+		return 0.0f;
+	}
+
+
+	//****************************************************
+	// Helper for adaptive subdivision: evaluates the surface at the (u, v) midpoint of the edge X -> Y,
+	// stores it in 'midpoint', and returns whether the edge needs to be split according to 'metric':
+	//
+	//   CHORD_METRIC       the evaluated midpoint is at least 'error' away from the straight-line midpoint of the edge
+	//   NORMAL_METRIC      the normal turns by at least 'error' degrees from X to the midpoint and on to Y
+	//   CURVATURE_METRIC   a circular arc with the largest curvature of the surface along the edge (at X, the midpoint
+	//                      or Y) bulges at least 'error' away from the edge, i.e. curvature * length^2 / 8 >= error.
+	//                      Unlike the chord test, this does not miss edges whose midpoint happens to lie on the
+	//                      edge (such as S-shaped ones)
+	//***************************************************
+	bool edgeNeedsSplit(const DifferentialGeometry& pointX, const DifferentialGeometry& pointY, float error,
+			DifferentialGeometry& midpoint, AdaptiveSplitMetric metric) {
+		Eigen::Vector2f uvValueToInterpolate = (pointX.uvValues + pointY.uvValues)/2.0f;
+		midpoint = evaluateDifferentialGeometry(uvValueToInterpolate.x(), uvValueToInterpolate.y());
+
+		if (metric == NORMAL_METRIC) {
+			float turn = acos(fmin(1.0f, fmax(-1.0f, pointX.normal.dot(midpoint.normal))))
+					+ acos(fmin(1.0f, fmax(-1.0f, midpoint.normal.dot(pointY.normal))));
+			return turn * 180.0f / M_PI >= error;
+		}
+
+		if (metric == CURVATURE_METRIC) {
+			Eigen::Vector2f direction = pointY.uvValues - pointX.uvValues;
+			float curvature = fmax(directionalCurvature(pointX.uvValues.x(), pointX.uvValues.y(), direction),
+					fmax(directionalCurvature(uvValueToInterpolate.x(), uvValueToInterpolate.y(), direction),
+					directionalCurvature(pointY.uvValues.x(), pointY.uvValues.y(), direction)));
+			float length = (pointY.position - pointX.position).norm();
+			return curvature * length * length / 8.0f >= error;
+		}
+
+		Eigen::Vector3f midpointApproximatedValue = (pointY.position - pointX.position)/2.0f + (pointX.position);
+
+		Eigen::Vector3f errorVector = midpoint.position - midpointApproximatedValue;
+		float errorValue = sqrt(errorVector.dot(errorVector));
+
+		return errorValue >= error;
+	}
+
+	// Appends a vertex to listOfDifferentialGeometries and returns its index
+	int pushDifferentialGeometry(const DifferentialGeometry& vertex) {
+		listOfDifferentialGeometries.push_back(vertex);
+		return listOfDifferentialGeometries.size() - 1;
+	}
+
+
+	//****************************************************
+	// Method that populates each BezierPatch's list of DifferentialGeometries
+	// and list of Triangles, based on adaptive subdivision.
+	//
+	// Triangles waiting to be tested live in 'arena' as vertex indices into listOfDifferentialGeometries.
+	// The arena is reset at the start of every call, so the caller can share one arena across all patches
+	// and its memory gets reused instead of reallocated.
+	//
+	// By default the triangles are refined breadth-first, which keeps the whole refinement frontier in memory.
+	// With 'depthFirst' the arena is used as an explicit stack instead, so memory is proportional to the depth
+	// of the refinement; both traversals produce the same set of triangles unless 'maxTriangles' cuts the
+	// refinement short (which triangles are left unsplit then depends on the order they are visited in).
+	//
+	// A triangle that is 'maxDepth' splits deep is accepted as is, and triangles stop being split once the
+	// patch would otherwise end up with more than 'maxTriangles' triangles. Returns false if that limit
+	// kept triangles from being split that needed it.
+	//
+	// NOTE: whether an edge is split normally depends on that edge alone, so the triangles on both sides of it
+	//       agree and the mesh has no cracks. A triangle that either limit keeps from being split can leave
+	//       T-junctions (cracks) against neighbours that did split their shared edge.
+	//
+	// 'metric' decides which edges need to be split (see edgeNeedsSplit); 'error' is in that metric's units.
+	//***************************************************
+	bool performAdaptiveSubdivision(float error, SubdivisionArena& arena, bool depthFirst, int maxDepth, int maxTriangles,
+			AdaptiveSplitMetric metric) {
+		arena.reset();
+
+		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(0, 0));
+		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(0, 1));
+		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(1, 0));
+
+		// A triangular patch starts out as a single triangle, 2-3-1 below
+		arena.push(1, 2, 0, 0);
+		if (!triangular) {
+			listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(1, 1));
+			arena.push(2, 1, 3, 0);
+		}
+
+		// number of triangles this patch already had before we started
+		std::vector<Triangle>::size_type initialNumberOfTriangles = listOfTriangles.size();
+		bool cutShort = false;
+
+		DifferentialGeometry midpointInterpolatedValueAB;
+		DifferentialGeometry midpointInterpolatedValueBC;
+		DifferentialGeometry midpointInterpolatedValueAC;
+
+		while (!arena.empty()) {
+
+			SubdivisionWorkItem currentTriangleToTest = depthFirst ? arena.popLast() : arena.pop();
+			int a = currentTriangleToTest.vertex1;
+			int b = currentTriangleToTest.vertex2;
+			int c = currentTriangleToTest.vertex3;
+			int childDepth = currentTriangleToTest.depth + 1;
+
+			// NOTE: these references are only valid until the next push into listOfDifferentialGeometries,
+			// so all three edges are tested before any midpoint gets added
+			const DifferentialGeometry& pointA = listOfDifferentialGeometries[a];
+			const DifferentialGeometry& pointB = listOfDifferentialGeometries[b];
+			const DifferentialGeometry& pointC = listOfDifferentialGeometries[c];
+
+			// Splitting a triangle turns it into (at most) four, i.e. three more triangles than we have now.
+			// Every triangle that is finished or still pending ends up in the output, so stop splitting
+			// once that could overshoot the budget.
+			std::vector<Triangle>::size_type committedTriangles = (listOfTriangles.size() - initialNumberOfTriangles) + arena.pending() + 1;
+			bool overBudget = committedTriangles + 3 > (std::vector<Triangle>::size_type) maxTriangles;
+			if (currentTriangleToTest.depth >= maxDepth || overBudget) {
+				listOfTriangles.push_back(Triangle(pointA, pointB, pointC));
+				cutShort = cutShort || (overBudget && (edgeNeedsSplit(pointA, pointB, error, midpointInterpolatedValueAB, metric)
+						|| edgeNeedsSplit(pointB, pointC, error, midpointInterpolatedValueBC, metric)
+						|| edgeNeedsSplit(pointA, pointC, error, midpointInterpolatedValueAC, metric)));
+				continue;
+			}
+
+			// Checking whether A -> B, B -> C and A -> C need to be split
+			bool abSplit = edgeNeedsSplit(pointA, pointB, error, midpointInterpolatedValueAB, metric);
+			bool bcSplit = edgeNeedsSplit(pointB, pointC, error, midpointInterpolatedValueBC, metric);
+			bool acSplit = edgeNeedsSplit(pointA, pointC, error, midpointInterpolatedValueAC, metric);
 
 			// Case 1
 			if (!abSplit && !bcSplit && !acSplit) {
-				listOfTriangles.push_back(currentTriangleToTest);
+				listOfTriangles.push_back(Triangle(pointA, pointB, pointC));
 			}
 			// Case 2
 			else if (!abSplit && !bcSplit && acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAC);
-				queueOfTriangles.push(Triangle(pointA, pointB, midpointInterpolatedValueAC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, pointB, pointC));
+				int ac = pushDifferentialGeometry(midpointInterpolatedValueAC);
+				arena.push(a, b, ac, childDepth);
+				arena.push(ac, b, c, childDepth);
 			}
 			// Case 3
 			else if (abSplit && !bcSplit && !acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAB);
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueAB, pointC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAB, pointB, pointC));
+				int ab = pushDifferentialGeometry(midpointInterpolatedValueAB);
+				arena.push(a, ab, c, childDepth);
+				arena.push(ab, b, c, childDepth);
 			}
 			// Case 4
 			else if (!abSplit && bcSplit && !acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueBC);
-				queueOfTriangles.push(Triangle(pointA, pointB, midpointInterpolatedValueBC));
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueBC, pointC));
+				int bc = pushDifferentialGeometry(midpointInterpolatedValueBC);
+				arena.push(a, b, bc, childDepth);
+				arena.push(a, bc, c, childDepth);
 			}
 			// Case 5
 			else if (abSplit && !bcSplit && acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAB);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAC);
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueAB, midpointInterpolatedValueAC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, midpointInterpolatedValueAB, pointC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAB, pointB, pointC));
+				int ab = pushDifferentialGeometry(midpointInterpolatedValueAB);
+				int ac = pushDifferentialGeometry(midpointInterpolatedValueAC);
+				arena.push(a, ab, ac, childDepth);
+				arena.push(ac, ab, c, childDepth);
+				arena.push(ab, b, c, childDepth);
 			}
 			// Case 6
 			else if (abSplit && bcSplit && !acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAB);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueBC);
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueBC, pointC));
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueAB, midpointInterpolatedValueBC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAB, pointB, midpointInterpolatedValueBC));
+				int ab = pushDifferentialGeometry(midpointInterpolatedValueAB);
+				int bc = pushDifferentialGeometry(midpointInterpolatedValueBC);
+				arena.push(a, bc, c, childDepth);
+				arena.push(a, ab, bc, childDepth);
+				arena.push(ab, b, bc, childDepth);
 			}
 			// Case 7
 			else if (!abSplit && bcSplit && acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAC);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueBC);
-				queueOfTriangles.push(Triangle(pointA, pointB, midpointInterpolatedValueAC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, pointB, midpointInterpolatedValueBC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, midpointInterpolatedValueBC, pointC));
+				int ac = pushDifferentialGeometry(midpointInterpolatedValueAC);
+				int bc = pushDifferentialGeometry(midpointInterpolatedValueBC);
+				arena.push(a, b, ac, childDepth);
+				arena.push(ac, b, bc, childDepth);
+				arena.push(ac, bc, c, childDepth);
 			}
 			// Case 8
 			else if (abSplit && bcSplit && acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAC);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueBC);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAB);
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueAB, midpointInterpolatedValueAC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAB, pointB, midpointInterpolatedValueBC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, midpointInterpolatedValueBC, pointC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, midpointInterpolatedValueAB, midpointInterpolatedValueBC));
+				int ac = pushDifferentialGeometry(midpointInterpolatedValueAC);
+				int bc = pushDifferentialGeometry(midpointInterpolatedValueBC);
+				int ab = pushDifferentialGeometry(midpointInterpolatedValueAB);
+				arena.push(a, ab, ac, childDepth);
+				arena.push(ab, b, bc, childDepth);
+				arena.push(ac, bc, c, childDepth);
+				arena.push(ac, ab, bc, childDepth);
 			}
 		}
+		return !cutShort;
+
 		// Algorithm:
 		//
 		// First, we add the DifferentialGeometries (u,v) = (0,0) , (0,1) , (1,0) , (1,1)
@@ -282,6 +854,7 @@ class BezierPatch {
 		// 2  4
 		//
 		// Next, we add two triangles to our triangle queue: 1-2-3  &  4-3-2
+		// (triangular patches have no point 4, and only start with 1-2-3)
 		//
 		// while triangle_queue.is_not_empty:
 		//     current_triangle = triangle_queue.pop();
@@ -320,6 +893,78 @@ class BezierPatch {
 	}
 
 
+	//****************************************************
+	// Evaluates the uniform grid (u, v) = (i, j) * stepSize of a polynomial tensor product patch into the points
+	// listOfDifferentialGeometries[i * (numberOfSteps + 1) + j], which must already hold their (u, v), from tables of
+	// the Bernstein polynomials and their derivatives at the grid's parameters.
+	//
+	// For each i, the control point rows are reduced to one curve in v and its u derivative; evaluating those at every
+	// j gives the position and both partial derivatives in the same pass. The normals are then normalized in a second
+	// pass over plain float arrays, which the compiler can vectorize, and only the few points where the derivatives
+	// are degenerate (collapsed edges) go through surfaceNormal.
+	//***************************************************
+	void evaluateUniformGrid(const BasisTable& uTable, const BasisTable& vTable) {
+		int numberOfSteps = uTable.numberOfSteps;
+		int numberOfPoints = (numberOfSteps + 1) * (numberOfSteps + 1);
+		std::vector<Eigen::Vector3f> curve(degreeV() + 1), curveDerivative(degreeV() + 1);
+		std::vector<float> normalX(numberOfPoints), normalY(numberOfPoints), normalZ(numberOfPoints), threshold(numberOfPoints);
+
+		for (int i = 0; i <= numberOfSteps; i++) {
+			const float* uValues = uTable.valuesAt(i);
+			const float* uDerivatives = uTable.derivativesAt(i);
+			for (int row = 0; row <= degreeV(); row++) {
+				const std::vector<Eigen::Vector3f>& controlPoints = listOfCurves[row];
+				curve[row] = uValues[0] * controlPoints[0];
+				curveDerivative[row] = uDerivatives[0] * controlPoints[0];
+				for (int column = 1; column <= degreeU(); column++) {
+					curve[row] += uValues[column] * controlPoints[column];
+					curveDerivative[row] += uDerivatives[column] * controlPoints[column];
+				}
+			}
+
+			for (int j = 0; j <= numberOfSteps; j++) {
+				const float* vValues = vTable.valuesAt(j);
+				const float* vDerivatives = vTable.derivativesAt(j);
+				Eigen::Vector3f position = vValues[0] * curve[0];
+				Eigen::Vector3f dPdu = vValues[0] * curveDerivative[0];
+				Eigen::Vector3f dPdv = vDerivatives[0] * curve[0];
+				for (int row = 1; row <= degreeV(); row++) {
+					position += vValues[row] * curve[row];
+					dPdu += vValues[row] * curveDerivative[row];
+					dPdv += vDerivatives[row] * curve[row];
+				}
+
+				int index = i * (numberOfSteps + 1) + j;
+				listOfDifferentialGeometries[index].position = position;
+				Eigen::Vector3f normal = dPdu.cross(dPdv);
+				normalX[index] = normal.x();
+				normalY[index] = normal.y();
+				normalZ[index] = normal.z();
+				threshold[index] = 1e-5f * (dPdu.squaredNorm() + dPdv.squaredNorm());
+			}
+		}
+
+		// Normalize (as isDegenerateNormal decides, degenerate normals are set to zero)
+		for (int index = 0; index < numberOfPoints; index++) {
+			float length = sqrtf(normalX[index] * normalX[index] + normalY[index] * normalY[index] + normalZ[index] * normalZ[index]);
+			float scale = length > threshold[index] ? 1.0f / length : 0.0f;
+			normalX[index] *= scale;
+			normalY[index] *= scale;
+			normalZ[index] *= scale;
+			threshold[index] = scale;
+		}
+
+		for (int index = 0; index < numberOfPoints; index++) {
+			DifferentialGeometry& point = listOfDifferentialGeometries[index];
+			if (threshold[index] > 0.0f) {
+				point.normal = Eigen::Vector3f(normalX[index], normalY[index], normalZ[index]);
+			} else {
+				point.normal = surfaceNormal(point.uvValues.x(), point.uvValues.y(), Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero());
+			}
+		}
+	}
+
+
 	//****************************************************
 	// Method that populates each BezierPatch's list of DifferentialGeometries
 	// and list of Triangles, based on uniform subdivision
@@ -327,13 +972,29 @@ class BezierPatch {
 	void performUniformSubdivision(float stepSize) {
 		float epsilon = 0.001f;
 		int numberOfSteps = (1.0 + epsilon) / stepSize;
+		if (triangular) {
+			performTriangularUniformSubdivision(numberOfSteps, stepSize);
+			return;
+		}
+		uniformSteps = numberOfSteps;
+		// (the sizes are known, so the lists take no more memory than the grid needs)
+		listOfDifferentialGeometries.reserve(listOfDifferentialGeometries.size() + (numberOfSteps + 1) * (numberOfSteps + 1));
+		listOfTriangles.reserve(listOfTriangles.size() + 2 * numberOfSteps * numberOfSteps);
 		for (int u = 0; u <= numberOfSteps; u++) {
 			for (int v = 0; v <= numberOfSteps; v++) {
 				// Evaluate the differential geometry at (u * stepSize, v * stepSize(
 				// For instance, if stepSize = 0.1, then we would evaluate at (0, 0), (0, 0.1), (0, 0.2), etc
-				listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(u * stepSize, v * stepSize));
+				// (Polynomial patches are evaluated all at once below)
+				if (isRational()) {
+					listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(u * stepSize, v * stepSize));
+				} else {
+					addDifferentialGeometry(Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero(), Eigen::Vector2f(u * stepSize, v * stepSize));
+				}
 			}
 		}
+		if (!isRational()) {
+			evaluateUniformGrid(BasisTable(degreeU(), numberOfSteps, stepSize), BasisTable(degreeV(), numberOfSteps, stepSize));
+		}
 
 		// NOTE: Code confirmed as working (tested)
 		// Populate the list of Triangles, based on the list of points in listOfDifferentialGeometries
@@ -390,6 +1051,139 @@ class BezierPatch {
 		}
 		// We should have (numberOfSteps - 1) * (numberOfSteps - 1) * 2 triangles
 	}
+
+
+	//****************************************************
+	// Uniform subdivision of a triangular patch: the points (a * stepSize, b * stepSize) with a + b <= numberOfSteps,
+	// stored column by column (a = 0 first, each column starting at b = 0), and the triangles between them, using the
+	// same orientation as the triangles of performUniformSubdivision
+	//***************************************************
+	void performTriangularUniformSubdivision(int numberOfSteps, float stepSize) {
+		listOfDifferentialGeometries.reserve(listOfDifferentialGeometries.size() + (numberOfSteps + 1) * (numberOfSteps + 2) / 2);
+		listOfTriangles.reserve(listOfTriangles.size() + numberOfSteps * numberOfSteps);
+		for (int a = 0; a <= numberOfSteps; a++) {
+			for (int b = 0; a + b <= numberOfSteps; b++) {
+				listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(a * stepSize, b * stepSize));
+			}
+		}
+
+		// Column a holds numberOfSteps + 1 - a points
+		int columnStart = 0;
+		for (int a = 0; a < numberOfSteps; a++) {
+			int nextColumnStart = columnStart + numberOfSteps + 1 - a;
+			for (int b = 0; a + b < numberOfSteps; b++) {
+				const DifferentialGeometry& topLeft = listOfDifferentialGeometries[columnStart + b];
+				const DifferentialGeometry& bottomLeft = listOfDifferentialGeometries[columnStart + b + 1];
+				const DifferentialGeometry& topRight = listOfDifferentialGeometries[nextColumnStart + b];
+				listOfTriangles.push_back(Triangle(topRight, topLeft, bottomLeft));
+
+				// The square's other half, unless it lies beyond the diagonal u + v = 1
+				if (a + b + 1 < numberOfSteps) {
+					const DifferentialGeometry& bottomRight = listOfDifferentialGeometries[nextColumnStart + b + 1];
+					listOfTriangles.push_back(Triangle(topRight, bottomLeft, bottomRight));
+				}
+			}
+			columnStart = nextColumnStart;
+		}
+	}
+
+
+	//****************************************************
+	// Helper for flatness subdivision: returns the index in listOfDifferentialGeometries of the point at (u, v),
+	// evaluating and adding it the first time it is asked for.
+	// Subpatch corners are always dyadic (u, v) values (we only ever split in half), so scaling them by 2^24
+	// gives exact integer keys, and neighbouring subpatches share their corner vertices.
+	//***************************************************
+	int flatnessSubdivisionVertex(float u, float v, std::map<std::pair<long, long>, int>& vertexIndexByUV) {
+		std::pair<long, long> key(lround(u * 16777216.0f), lround(v * 16777216.0f));
+		std::map<std::pair<long, long>, int>::iterator found = vertexIndexByUV.find(key);
+		if (found != vertexIndexByUV.end()) {
+			return found->second;
+		}
+		int index = pushDifferentialGeometry(evaluateDifferentialGeometry(u, v));
+		vertexIndexByUV[key] = index;
+		return index;
+	}
+
+
+	//****************************************************
+	// Adds the two triangles (top right, top left, bottom left) and (top right, bottom left, bottom right)
+	// spanned by the corners of 'subpatch' to listOfTriangles. The corners are evaluated on this (original)
+	// patch so that their normals are exact, and follow the same layout as performUniformSubdivision.
+	//***************************************************
+	template<class Subpatch>
+	void addSubpatchTriangles(const Subpatch& subpatch, std::map<std::pair<long, long>, int>& vertexIndexByUV) {
+		const Eigen::Vector2f& uvMin = subpatch.uvMin;
+		const Eigen::Vector2f& uvMax = subpatch.uvMax;
+		int topLeft = flatnessSubdivisionVertex(uvMin.x(), uvMin.y(), vertexIndexByUV);
+		int topRight = flatnessSubdivisionVertex(uvMax.x(), uvMin.y(), vertexIndexByUV);
+		int bottomLeft = flatnessSubdivisionVertex(uvMin.x(), uvMax.y(), vertexIndexByUV);
+		int bottomRight = flatnessSubdivisionVertex(uvMax.x(), uvMax.y(), vertexIndexByUV);
+
+		listOfTriangles.push_back(Triangle(listOfDifferentialGeometries[topRight],
+				listOfDifferentialGeometries[topLeft], listOfDifferentialGeometries[bottomLeft]));
+		listOfTriangles.push_back(Triangle(listOfDifferentialGeometries[topRight],
+				listOfDifferentialGeometries[bottomLeft], listOfDifferentialGeometries[bottomRight]));
+	}
+
+
+	//****************************************************
+	// Method that populates each BezierPatch's list of DifferentialGeometries
+	// and list of Triangles, based on patch-level (flatness) subdivision
+	//
+	// Instead of testing triangle edges, the patch itself is split in half with de Casteljau's algorithm
+	// (along whichever direction bends more) until the control net of every subpatch is flat, i.e. until
+	// BezierSubpatch::flatnessError() is below 'error'. Only then is each subpatch emitted as two triangles.
+	// Since flatnessError() bounds the distance between a subpatch and its triangles, every triangle is
+	// guaranteed to be within 'error' of the surface, including its interior.
+	//
+	// Subpatches stop being split once the patch would otherwise end up with more than 'maxTriangles'
+	// triangles; returns false if that kept a subpatch that was not flat yet from being split.
+	//
+	// NOTE: neighbouring subpatches may be split a different number of times, which leaves T-junctions
+	//       (cracks at most 'error' wide) along their shared edge
+	//***************************************************
+	bool performFlatnessSubdivision(float error, int maxDepth, int maxTriangles) {
+		if (isPolynomialBicubic()) {
+			return performFlatnessSubdivision<BicubicSubpatch>(error, maxDepth, maxTriangles);
+		}
+		return performFlatnessSubdivision<BezierSubpatch>(error, maxDepth, maxTriangles);
+	}
+
+	template<class Subpatch>
+	bool performFlatnessSubdivision(float error, int maxDepth, int maxTriangles) {
+		std::map<std::pair<long, long>, int> vertexIndexByUV;
+		std::vector<Triangle>::size_type initialNumberOfTriangles = listOfTriangles.size();
+		bool cutShort = false;
+
+		// Subpatches still to be tested, processed depth-first
+		std::vector<Subpatch> stackOfSubpatches;
+		stackOfSubpatches.push_back(Subpatch(listOfCurves, weights, 0));
+
+		Subpatch firstHalf, secondHalf;
+
+		while (!stackOfSubpatches.empty()) {
+			Subpatch currentSubpatch = stackOfSubpatches.back();
+			stackOfSubpatches.pop_back();
+
+			if (currentSubpatch.depth < maxDepth && currentSubpatch.canSplit() && currentSubpatch.flatnessError() >= error) {
+				// Every subpatch (finished, pending or this one) ends up as two triangles, and splitting adds two more
+				std::vector<Triangle>::size_type committedTriangles = (listOfTriangles.size() - initialNumberOfTriangles)
+						+ 2 * (stackOfSubpatches.size() + 1);
+				if (committedTriangles + 2 <= (std::vector<Triangle>::size_type) maxTriangles) {
+					currentSubpatch.split(firstHalf, secondHalf);
+					stackOfSubpatches.push_back(secondHalf);
+					stackOfSubpatches.push_back(firstHalf);
+					continue;
+				}
+				cutShort = true;
+			}
+
+			// Flat enough (or out of triangles)
+			addSubpatchTriangles(currentSubpatch, vertexIndexByUV);
+		}
+		return !cutShort;
+	}
 };
 
 #endif /* BEZIERPATCH_H_ */
@@ -0,0 +1,309 @@
+/*
+ * BezierSubpatch.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BEZIERSUBPATCH_H_
+#define BEZIERSUBPATCH_H_
+
+#include <vector>
+#include <cmath>
+
+// A piece of a BezierPatch, covering the (u, v) rectangle [uvMin, uvMax] of the original patch.
+// The piece is itself a Bezier patch of the same degrees, whose control points are found with de Casteljau splitting.
+// Used for patch-level (flatness based) and triangle-budget subdivision, and by the patch ray tracer.
+//
+// 'Degree' fixes the degree in both u and v at compile time, so the loops have fixed bounds and the subpatch only
+// holds (Degree + 1)^2 control points; a degree of 0 means "not known at compile time", i.e. any degree up to
+// MAX_DEGREE in u and v. Only 'Rational' subpatches store weights: for those the control points are kept (and
+// split) in homogeneous form, i.e. premultiplied by their weights. The subpatches of polynomial bicubic patches
+// (BicubicSubpatch) are copied around a lot by triangle-budget subdivision, so they are kept small; all others
+// use BezierSubpatch.
+template<int Degree, bool Rational>
+class GenericBezierSubpatch {
+	public:
+		static const int MAX_DEGREE = 5;
+
+		// Number of control points along each side that there is room for
+		static const int SIZE = Degree > 0 ? Degree + 1 : MAX_DEGREE + 1;
+
+		// Same layout as BezierPatch::listOfCurves: controlPoints[row][column], where moving along a
+		// row changes u and moving between rows changes v. Only [0, degreeV] x [0, degreeU] is used.
+		// For rational subpatches these are the homogeneous points weight * P.
+		Eigen::Vector3f controlPoints[SIZE][SIZE];
+		float weights[Rational ? SIZE : 1][Rational ? SIZE : 1];
+		int degreeU, degreeV;
+
+		// Whether the weights are used (never for subpatches that are not 'Rational')
+		bool rational;
+
+		// (u, v) rectangle of the original patch that this subpatch covers
+		Eigen::Vector2f uvMin, uvMax;
+
+		// number of times the original patch was split to get to this subpatch
+		int depth;
+
+		// index (in the scene's list of patches) of the BezierPatch this subpatch belongs to
+		int patchIndex;
+
+	GenericBezierSubpatch() {
+
+	}
+
+	// The subpatch that covers the whole patch given by 'curves' and 'curveWeights' (i.e. a BezierPatch's
+	// listOfCurves and weights; no weights means a polynomial patch, the only kind that non-'Rational'
+	// subpatches can hold)
+	GenericBezierSubpatch(const std::vector<std::vector<Eigen::Vector3f> >& curves,
+			const std::vector<std::vector<float> >& curveWeights, int patchIndex) {
+		degreeV = curves.size() - 1;
+		degreeU = curves[0].size() - 1;
+		rational = Rational && !curveWeights.empty();
+		for (int row = 0; row <= degreeV; row++) {
+			for (int column = 0; column <= degreeU; column++) {
+				if (rational) {
+					weights[row][column] = curveWeights[row][column];
+					controlPoints[row][column] = weights[row][column] * curves[row][column];
+				} else {
+					controlPoints[row][column] = curves[row][column];
+				}
+			}
+		}
+		uvMin = Eigen::Vector2f(0, 0);
+		uvMax = Eigen::Vector2f(1, 1);
+		depth = 0;
+		this->patchIndex = patchIndex;
+	}
+
+	// Whether a patch with these degrees can be represented
+	static bool supportsDegrees(int degreeU, int degreeV) {
+		if (Degree > 0) {
+			return degreeU == Degree && degreeV == Degree;
+		}
+		return degreeU >= 1 && degreeV >= 1 && degreeU <= MAX_DEGREE && degreeV <= MAX_DEGREE;
+	}
+
+	// The degrees, as compile time constants when they are known
+	int uDegree() const {
+		return Degree > 0 ? Degree : degreeU;
+	}
+
+	int vDegree() const {
+		return Degree > 0 ? Degree : degreeV;
+	}
+
+	// The (Euclidean) control point in 'row' and 'column'
+	Eigen::Vector3f point(int row, int column) const {
+		if (Rational && rational) {
+			return controlPoints[row][column] / weights[row][column];
+		}
+		return controlPoints[row][column];
+	}
+
+	// Smallest (u, v) extent that we are still willing to split, which keeps the corners exact dyadic values
+	static float minimumExtent() {
+		return 1.0f / (1 << 20);
+	}
+
+	bool canSplitU() const {
+		return uvMax.x() - uvMin.x() > minimumExtent();
+	}
+
+	bool canSplitV() const {
+		return uvMax.y() - uvMin.y() > minimumExtent();
+	}
+
+	bool canSplit() const {
+		return canSplitU() || canSplitV();
+	}
+
+
+	//****************************************************
+	// Returns an upper bound on the distance between this subpatch and the two triangles
+	// (top right, top left, bottom left) and (top right, bottom left, bottom right) spanned by its corners,
+	// i.e. the triangles that would be drawn for it.
+	//
+	// The bound has two parts:
+	//   - the surface lies in the convex hull of its control points, so its distance to the bilinear patch through
+	//     its four corners is at most the largest distance between a control point P(i, j) and the point of that
+	//     bilinear patch at (j / degreeU, i / degreeV)
+	//   - a bilinear patch differs from its two triangles by at most a quarter of its twist vector
+	//
+	// NOTE: for rational subpatches with unequal weights the first part is only an estimate, which becomes exact
+	//       as the weights even out under splitting
+	//***************************************************
+	float flatnessError() const {
+		const int uLast = uDegree(), vLast = vDegree();
+		Eigen::Vector3f p00 = point(0, 0);
+		Eigen::Vector3f p03 = point(0, uLast);
+		Eigen::Vector3f p30 = point(vLast, 0);
+		Eigen::Vector3f p33 = point(vLast, uLast);
+
+		float maximumDeviation = 0.0f;
+		for (int row = 0; row <= vLast; row++) {
+			float v = row / (float) vLast;
+			for (int column = 0; column <= uLast; column++) {
+				float u = column / (float) uLast;
+				Eigen::Vector3f bilinearPoint = (1 - v) * ((1 - u) * p00 + u * p03) + v * ((1 - u) * p30 + u * p33);
+				maximumDeviation = fmax(maximumDeviation, (point(row, column) - bilinearPoint).norm());
+			}
+		}
+
+		Eigen::Vector3f twist = p00 - p03 - p30 + p33;
+		return maximumDeviation + twist.norm() / 4.0f;
+	}
+
+
+	// Axis-aligned box around the control points, which (by the convex hull property) also contains the surface
+	void boundingBox(Eigen::Vector3f& boxMin, Eigen::Vector3f& boxMax) const {
+		boxMin = boxMax = point(0, 0);
+		for (int row = 0; row <= vDegree(); row++) {
+			for (int column = 0; column <= uDegree(); column++) {
+				Eigen::Vector3f controlPoint = point(row, column);
+				boxMin = boxMin.cwiseMin(controlPoint);
+				boxMax = boxMax.cwiseMax(controlPoint);
+			}
+		}
+	}
+
+
+	//****************************************************
+	// Returns true if the control polygons bend more in the u direction than in the v direction,
+	// i.e. if splitting in u is the better way to flatten this subpatch
+	//***************************************************
+	bool bendsMoreInU() const {
+		const int uLast = uDegree(), vLast = vDegree();
+		float uBend = 0.0f;
+		float vBend = 0.0f;
+		for (int row = 0; row <= vLast; row++) {
+			for (int k = 0; k + 2 <= uLast; k++) {
+				uBend = fmax(uBend, (point(row, k) - 2 * point(row, k + 1) + point(row, k + 2)).norm());
+			}
+		}
+		for (int column = 0; column <= uLast; column++) {
+			for (int k = 0; k + 2 <= vLast; k++) {
+				vBend = fmax(vBend, (point(k, column) - 2 * point(k + 1, column) + point(k + 2, column)).norm());
+			}
+		}
+
+		// A subpatch that is only twisted does not bend at all; split its longer side instead
+		if (uBend == vBend) {
+			return (point(0, uLast) - point(0, 0)).norm() >= (point(vLast, 0) - point(0, 0)).norm();
+		}
+		return uBend > vBend;
+	}
+
+
+	//****************************************************
+	// Splits the degree 'degree' curve points[0 .. degree] in half with de Casteljau's algorithm.
+	// 'weights' (if not NULL) are split the same way, alongside the (homogeneous) points.
+	//***************************************************
+	static void splitCurve(int degree, Eigen::Vector3f* points, float* weights,
+			Eigen::Vector3f* firstHalf, float* firstWeights, Eigen::Vector3f* secondHalf, float* secondWeights) {
+		// Every pass averages neighbouring points in place; after pass k, points[degree - k] is the
+		// last point of the first half, and points[degree] is the k-th to last point of the second half
+		firstHalf[0] = points[0];
+		secondHalf[degree] = points[degree];
+		if (weights != NULL) {
+			firstWeights[0] = weights[0];
+			secondWeights[degree] = weights[degree];
+		}
+		for (int pass = 1; pass <= degree; pass++) {
+			for (int k = 0; k <= degree - pass; k++) {
+				points[k] = (points[k] + points[k + 1]) * 0.5f;
+				if (weights != NULL) {
+					weights[k] = (weights[k] + weights[k + 1]) * 0.5f;
+				}
+			}
+			firstHalf[pass] = points[0];
+			secondHalf[degree - pass] = points[degree - pass];
+			if (weights != NULL) {
+				firstWeights[pass] = weights[0];
+				secondWeights[degree - pass] = weights[degree - pass];
+			}
+		}
+	}
+
+
+	//****************************************************
+	// Splits this subpatch in half along u (or along v), into the half closer to uvMin and the half closer to uvMax
+	//***************************************************
+	void split(bool alongU, GenericBezierSubpatch& firstHalf, GenericBezierSubpatch& secondHalf) const {
+		Eigen::Vector3f curve[SIZE], firstCurve[SIZE], secondCurve[SIZE];
+		float curveWeights[SIZE], firstWeights[SIZE], secondWeights[SIZE];
+		bool splitWeights = Rational && rational;
+
+		int numberOfCurves = alongU ? vDegree() + 1 : uDegree() + 1;
+		int curveDegree = alongU ? uDegree() : vDegree();
+		for (int i = 0; i < numberOfCurves; i++) {
+			for (int k = 0; k <= curveDegree; k++) {
+				curve[k] = alongU ? controlPoints[i][k] : controlPoints[k][i];
+				if (splitWeights) {
+					curveWeights[k] = alongU ? weights[i][k] : weights[k][i];
+				}
+			}
+			splitCurve(curveDegree, curve, splitWeights ? curveWeights : NULL, firstCurve, firstWeights, secondCurve, secondWeights);
+			for (int k = 0; k <= curveDegree; k++) {
+				if (alongU) {
+					firstHalf.controlPoints[i][k] = firstCurve[k];
+					secondHalf.controlPoints[i][k] = secondCurve[k];
+				} else {
+					firstHalf.controlPoints[k][i] = firstCurve[k];
+					secondHalf.controlPoints[k][i] = secondCurve[k];
+				}
+				if (splitWeights) {
+					(alongU ? firstHalf.weights[i][k] : firstHalf.weights[k][i]) = firstWeights[k];
+					(alongU ? secondHalf.weights[i][k] : secondHalf.weights[k][i]) = secondWeights[k];
+				}
+			}
+		}
+
+		Eigen::Vector2f uvMiddle = (uvMin + uvMax) * 0.5f;
+		firstHalf.uvMin = uvMin;
+		firstHalf.uvMax = alongU ? Eigen::Vector2f(uvMiddle.x(), uvMax.y()) : Eigen::Vector2f(uvMax.x(), uvMiddle.y());
+		secondHalf.uvMin = alongU ? Eigen::Vector2f(uvMiddle.x(), uvMin.y()) : Eigen::Vector2f(uvMin.x(), uvMiddle.y());
+		secondHalf.uvMax = uvMax;
+		firstHalf.degreeU = secondHalf.degreeU = degreeU;
+		firstHalf.degreeV = secondHalf.degreeV = degreeV;
+		firstHalf.rational = secondHalf.rational = rational;
+		firstHalf.depth = secondHalf.depth = depth + 1;
+		firstHalf.patchIndex = secondHalf.patchIndex = patchIndex;
+	}
+
+	// Splits this subpatch in half along the direction that flattens it the most (as long as that direction can be split)
+	void split(GenericBezierSubpatch& firstHalf, GenericBezierSubpatch& secondHalf) const {
+		bool alongU = canSplitU() && (!canSplitV() || bendsMoreInU());
+		split(alongU, firstHalf, secondHalf);
+	}
+};
+
+// Subpatches of polynomial bicubic patches, and of any other patch
+typedef GenericBezierSubpatch<3, false> BicubicSubpatch;
+typedef GenericBezierSubpatch<0, true> BezierSubpatch;
+
+
+// A subpatch together with its flatness error, ordered by that error so that a std::priority_queue
+// hands out the worst approximated subpatch first. Used for triangle-budget subdivision.
+template<class Subpatch>
+class PrioritizedSubpatch {
+	public:
+		Subpatch subpatch;
+		float error;
+
+	PrioritizedSubpatch() {
+
+	}
+
+	// Subpatches that cannot be split any further get a negative error, so they are never picked
+	PrioritizedSubpatch(const Subpatch& subpatch) {
+		this->subpatch = subpatch;
+		this->error = subpatch.canSplit() ? subpatch.flatnessError() : -1.0f;
+	}
+
+	bool operator<(const PrioritizedSubpatch& other) const {
+		return error < other.error;
+	}
+};
+
+
+#endif /* BEZIERSUBPATCH_H_ */
@@ -0,0 +1,487 @@
+/*
+ * BezierSurfaceFitter.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BEZIERSURFACEFITTER_H_
+#define BEZIERSURFACEFITTER_H_
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+//****************************************************
+// Converts triangle meshes (such as .obj files) into bicubic Bezier patches.
+//
+// The mesh is first segmented into regions that are close to flat: starting from every triangle that is not in a
+// region yet, neighboring triangles (across shared edges, after welding vertices at the same position) are added for
+// as long as their normals are within maxNormalAngle of the first triangle's; regions much smaller than a patch are
+// then merged into a neighbor. Every region is projected onto the plane perpendicular to its average normal, where
+// it is covered by a grid of square cells of about patchSize, and fitted with one uniform bicubic B-spline surface
+// over that grid: its control points are the least-squares solution (with Eigen's sparse Cholesky solver) of passing
+// through the region's vertices and triangle centers, plus a small penalty on the second differences of the control
+// points (scaled by 'smoothing'), which keeps the surface smooth where there is little data. Every cell that the
+// region's triangles overlap becomes one Bezier patch, converted from the B-spline and cut down to the part of the
+// cell they cover, so the patches of a region join with continuous curvature. Neighboring regions are fitted to the
+// same vertices along their common border, so they meet closely but not exactly.
+//
+// Regions are fitted in parallel, each into its own list, and the lists are concatenated in region order, so the
+// result does not depend on the number of threads.
+//***************************************************
+class BezierSurfaceFitter {
+	public:
+		// Largest angle (in degrees) between the normals of the first triangle of a region and any other of its triangles
+		float maxNormalAngle;
+
+		// Side length of the cells (and so, roughly, of the fitted patches)
+		float patchSize;
+
+		// Weight of the smoothness penalty relative to the data (per control point)
+		float smoothing;
+
+		// Control points of the fitted bicubic patches, as in BezierPatch::listOfCurves (4 rows of 4 points)
+		std::vector<std::vector<std::vector<Eigen::Vector3f> > > patches;
+
+		// Largest angle (in degrees) between the average normals of a small region and the region it is merged into
+		static const int MAX_MERGE_ANGLE = 75;
+
+		// Number of regions the mesh was segmented into, and the largest and root mean square distances between the
+		// fitted points and the mesh's vertices and triangle centers
+		int numberOfRegions;
+		float maxError, rmsError;
+
+	BezierSurfaceFitter() {
+		maxNormalAngle = 35.0f;
+		patchSize = 1.0f;
+		smoothing = 0.01f;
+		numberOfRegions = 0;
+		maxError = rmsError = 0.0f;
+	}
+
+	// Fits patches to the 'numberOfTriangles' triangles 'triangles' (three indices into 'positions' each)
+	void fit(const std::vector<Eigen::Vector3f>& positions, const unsigned int* triangles, int numberOfTriangles) {
+		patches.clear();
+		maxError = rmsError = 0.0f;
+
+		// Weld vertices at the same position (files may repeat a position for every normal it has), and drop triangles
+		// that have no area
+		std::vector<int> weldedVertex;
+		weldVertices(positions, weldedVertex);
+		std::vector<int> corners;
+		std::vector<Eigen::Vector3f> normals;
+		for (int t = 0; t < numberOfTriangles; t++) {
+			int a = weldedVertex[triangles[3 * t]], b = weldedVertex[triangles[3 * t + 1]], c = weldedVertex[triangles[3 * t + 2]];
+			Eigen::Vector3f normal = (positions[b] - positions[a]).cross(positions[c] - positions[a]);
+			if (a == b || b == c || c == a || normal.squaredNorm() == 0.0f) {
+				continue;
+			}
+			corners.push_back(a);
+			corners.push_back(b);
+			corners.push_back(c);
+			normals.push_back(normal);
+		}
+
+		std::vector<std::vector<int> > regions;
+		segment(corners, normals, regions);
+		numberOfRegions = regions.size();
+
+		std::vector<RegionFit> fits(regions.size());
+		parallelForEach(regions.size(), [&](int r) {
+			fitRegion(positions, corners, normals, regions[r], fits[r]);
+		});
+
+		double squaredErrorSum = 0.0;
+		long numberOfDataPoints = 0;
+		for (std::vector<RegionFit>::size_type r = 0; r < fits.size(); r++) {
+			patches.insert(patches.end(), fits[r].patches.begin(), fits[r].patches.end());
+			maxError = std::max(maxError, fits[r].maxError);
+			squaredErrorSum += fits[r].squaredErrorSum;
+			numberOfDataPoints += fits[r].numberOfDataPoints;
+		}
+		rmsError = numberOfDataPoints > 0 ? (float) sqrt(squaredErrorSum / numberOfDataPoints) : 0.0f;
+	}
+
+
+	private:
+
+	// Patches and errors of one region
+	struct RegionFit {
+		std::vector<std::vector<std::vector<Eigen::Vector3f> > > patches;
+		float maxError;
+		double squaredErrorSum;
+		long numberOfDataPoints;
+
+		RegionFit() {
+			maxError = 0.0f;
+			squaredErrorSum = 0.0;
+			numberOfDataPoints = 0;
+		}
+	};
+
+	// weldedVertex[i] is the lowest index of a vertex at the same position as vertex i
+	static void weldVertices(const std::vector<Eigen::Vector3f>& positions, std::vector<int>& weldedVertex) {
+		std::vector<int> order(positions.size());
+		for (std::vector<int>::size_type i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [&](int a, int b) {
+			const Eigen::Vector3f& p = positions[a];
+			const Eigen::Vector3f& q = positions[b];
+			if (p.x() != q.x()) return p.x() < q.x();
+			if (p.y() != q.y()) return p.y() < q.y();
+			if (p.z() != q.z()) return p.z() < q.z();
+			return a < b;
+		});
+		weldedVertex.resize(positions.size());
+		for (std::vector<int>::size_type k = 0; k < order.size(); k++) {
+			bool sameAsPrevious = k > 0 && positions[order[k]] == positions[order[k - 1]];
+			weldedVertex[order[k]] = sameAsPrevious ? weldedVertex[order[k - 1]] : order[k];
+		}
+	}
+
+	// Splits the triangles (three 'corners' each, with area-weighted 'normals') into regions, as lists of triangles
+	void segment(const std::vector<int>& corners, const std::vector<Eigen::Vector3f>& normals,
+			std::vector<std::vector<int> >& regions) const {
+		int numberOfTriangles = normals.size();
+
+		// Triangles across every edge: sort all edges by their (smaller, larger) vertex pair, and link the triangles
+		// within each run of equal edges
+		std::vector<std::pair<std::pair<int, int>, int> > edges;
+		edges.reserve(3 * numberOfTriangles);
+		for (int t = 0; t < numberOfTriangles; t++) {
+			for (int k = 0; k < 3; k++) {
+				int a = corners[3 * t + k], b = corners[3 * t + (k + 1) % 3];
+				edges.push_back(std::make_pair(std::make_pair(std::min(a, b), std::max(a, b)), t));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		std::vector<std::vector<int> > neighbors(numberOfTriangles);
+		for (std::vector<std::pair<std::pair<int, int>, int> >::size_type begin = 0, end; begin < edges.size(); begin = end) {
+			for (end = begin + 1; end < edges.size() && edges[end].first == edges[begin].first; end++) {
+			}
+			for (std::vector<std::pair<std::pair<int, int>, int> >::size_type i = begin; i < end; i++) {
+				for (std::vector<std::pair<std::pair<int, int>, int> >::size_type j = begin; j < end; j++) {
+					if (i != j) {
+						neighbors[edges[i].second].push_back(edges[j].second);
+					}
+				}
+			}
+		}
+
+		float minimumCosine = cos(maxNormalAngle * M_PI / 180.0);
+		std::vector<int> regionOf(numberOfTriangles, -1);
+		for (int seed = 0; seed < numberOfTriangles; seed++) {
+			if (regionOf[seed] >= 0) {
+				continue;
+			}
+			Eigen::Vector3f seedNormal = normals[seed].normalized();
+			regions.push_back(std::vector<int>(1, seed));
+			std::vector<int>& region = regions.back();
+			regionOf[seed] = regions.size() - 1;
+
+			// Breadth-first, so regions grow evenly in all directions
+			for (std::vector<int>::size_type next = 0; next < region.size(); next++) {
+				const std::vector<int>& around = neighbors[region[next]];
+				for (std::vector<int>::size_type k = 0; k < around.size(); k++) {
+					int t = around[k];
+					if (regionOf[t] < 0 && normals[t].normalized().dot(seedNormal) >= minimumCosine) {
+						regionOf[t] = regions.size() - 1;
+						region.push_back(t);
+					}
+				}
+			}
+		}
+
+		// Noise and the leftovers between regions make many regions that are much smaller than a patch, and would
+		// each still take a whole patch: merge those (smallest first) into the neighboring region whose average normal
+		// is closest to theirs, as long as that is within MAX_MERGE_ANGLE
+		std::vector<Eigen::Vector3f> regionNormals(regions.size(), Eigen::Vector3f::Zero());
+		std::vector<float> regionAreas(regions.size(), 0.0f);
+		std::vector<int> order(regions.size());
+		for (int t = 0; t < numberOfTriangles; t++) {
+			regionNormals[regionOf[t]] += normals[t];
+			regionAreas[regionOf[t]] += 0.5f * normals[t].norm();
+		}
+		for (std::vector<int>::size_type r = 0; r < order.size(); r++) {
+			order[r] = r;
+		}
+		std::sort(order.begin(), order.end(), [&](int a, int b) { return regionAreas[a] < regionAreas[b]; });
+
+		float smallArea = 0.25f * patchSize * patchSize;
+		float minimumMergeCosine = cos(MAX_MERGE_ANGLE * M_PI / 180.0);
+		for (std::vector<int>::size_type k = 0; k < order.size(); k++) {
+			int r = order[k];
+			if (regions[r].empty() || regionAreas[r] >= smallArea) {
+				continue;
+			}
+			Eigen::Vector3f normal = regionNormals[r].normalized();
+			int closest = -1;
+			float closestCosine = minimumMergeCosine;
+			for (std::vector<int>::size_type i = 0; i < regions[r].size(); i++) {
+				const std::vector<int>& around = neighbors[regions[r][i]];
+				for (std::vector<int>::size_type j = 0; j < around.size(); j++) {
+					int other = regionOf[around[j]];
+					float cosine = regionNormals[other].normalized().dot(normal);
+					if (other != r && cosine > closestCosine) {
+						closest = other;
+						closestCosine = cosine;
+					}
+				}
+			}
+			if (closest < 0) {
+				continue;
+			}
+			for (std::vector<int>::size_type i = 0; i < regions[r].size(); i++) {
+				regionOf[regions[r][i]] = closest;
+			}
+			regions[closest].insert(regions[closest].end(), regions[r].begin(), regions[r].end());
+			regionNormals[closest] += regionNormals[r];
+			regionAreas[closest] += regionAreas[r];
+			regions[r].clear();
+		}
+		regions.erase(std::remove_if(regions.begin(), regions.end(),
+				[](const std::vector<int>& region) { return region.empty(); }), regions.end());
+	}
+
+	// Values of the four uniform cubic B-spline basis functions that are nonzero at 'parameter' in [0, 1] of a cell
+	static void bSplineBasis(double parameter, double* basis) {
+		double t = parameter, s = 1.0 - parameter;
+		basis[0] = s * s * s / 6.0;
+		basis[1] = (3.0 * t * t * t - 6.0 * t * t + 4.0) / 6.0;
+		basis[2] = (-3.0 * t * t * t + 3.0 * t * t + 3.0 * t + 1.0) / 6.0;
+		basis[3] = t * t * t / 6.0;
+	}
+
+	void fitRegion(const std::vector<Eigen::Vector3f>& positions, const std::vector<int>& corners,
+			const std::vector<Eigen::Vector3f>& normals, const std::vector<int>& region, RegionFit& fit) const {
+		// Data: the region's vertices (once each) and the centers of its triangles
+		Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+		std::vector<int> vertices;
+		for (std::vector<int>::size_type k = 0; k < region.size(); k++) {
+			normal += normals[region[k]];
+			vertices.insert(vertices.end(), &corners[3 * region[k]], &corners[3 * region[k]] + 3);
+		}
+		std::sort(vertices.begin(), vertices.end());
+		vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+		std::vector<Eigen::Vector3f> data;
+		for (std::vector<int>::size_type k = 0; k < vertices.size(); k++) {
+			data.push_back(positions[vertices[k]]);
+		}
+		for (std::vector<int>::size_type k = 0; k < region.size(); k++) {
+			const int* triangle = &corners[3 * region[k]];
+			data.push_back((positions[triangle[0]] + positions[triangle[1]] + positions[triangle[2]]) / 3.0f);
+		}
+		normal = normal.squaredNorm() > 0.0f ? Eigen::Vector3f(normal.normalized()) : Eigen::Vector3f(normals[region[0]].normalized());
+
+		// The plane's axes: the principal directions of the projected data, ordered so that axisU x axisV = normal
+		// (which makes the patches face the same way as the triangles)
+		Eigen::Vector3f center = Eigen::Vector3f::Zero();
+		for (std::vector<Eigen::Vector3f>::size_type k = 0; k < data.size(); k++) {
+			center += data[k];
+		}
+		center /= data.size();
+		Eigen::Vector3f axisU = normal.unitOrthogonal();
+		Eigen::Vector3f axisV = normal.cross(axisU);
+		Eigen::Matrix2f covariance = Eigen::Matrix2f::Zero();
+		for (std::vector<Eigen::Vector3f>::size_type k = 0; k < data.size(); k++) {
+			Eigen::Vector2f projected((data[k] - center).dot(axisU), (data[k] - center).dot(axisV));
+			covariance += projected * projected.transpose();
+		}
+		Eigen::SelfAdjointEigenSolver<Eigen::Matrix2f> principal(covariance);
+		Eigen::Vector2f direction = principal.eigenvectors().col(1);
+		axisU = (direction.x() * axisU + direction.y() * axisV).normalized();
+		axisV = normal.cross(axisU);
+
+		// The grid of cells over the projected data
+		std::vector<Eigen::Vector2f> projected(data.size());
+		Eigen::Vector2f lowest = Eigen::Vector2f::Constant(HUGE_VALF), highest = Eigen::Vector2f::Constant(-HUGE_VALF);
+		for (std::vector<Eigen::Vector3f>::size_type k = 0; k < data.size(); k++) {
+			projected[k] = Eigen::Vector2f((data[k] - center).dot(axisU), (data[k] - center).dot(axisV));
+			lowest = lowest.cwiseMin(projected[k]);
+			highest = highest.cwiseMax(projected[k]);
+		}
+		int cellsU = std::max(1, (int) ceil((highest.x() - lowest.x()) / patchSize));
+		int cellsV = std::max(1, (int) ceil((highest.y() - lowest.y()) / patchSize));
+		Eigen::Vector2f cellSize((highest.x() - lowest.x()) / cellsU, (highest.y() - lowest.y()) / cellsV);
+		cellSize = cellSize.cwiseMax(Eigen::Vector2f::Constant(1e-6f * patchSize));
+
+		// Control point (i, j) of the B-spline, for i in [0, cellsU + 3) and j in [0, cellsV + 3), is unknown
+		// i * (cellsV + 3) + j; cell (i, j) depends on control points [i, i + 4) x [j, j + 4)
+		int controlPointsV = cellsV + 3;
+		int numberOfControlPoints = (cellsU + 3) * controlPointsV;
+
+		// Rows of the data term (16 basis function values each)
+		std::vector<Eigen::Triplet<double> > dataTerms;
+		dataTerms.reserve(16 * data.size());
+		for (std::vector<Eigen::Vector2f>::size_type k = 0; k < projected.size(); k++) {
+			int i, j;
+			double basisU[4], basisV[4];
+			cellOf(projected[k], lowest, cellSize, cellsU, cellsV, i, j, basisU, basisV);
+			for (int a = 0; a < 4; a++) {
+				for (int b = 0; b < 4; b++) {
+					dataTerms.push_back(Eigen::Triplet<double>(k, (i + a) * controlPointsV + j + b, basisU[a] * basisV[b]));
+				}
+			}
+		}
+		Eigen::SparseMatrix<double> dataMatrix(data.size(), numberOfControlPoints);
+		dataMatrix.setFromTriplets(dataTerms.begin(), dataTerms.end());
+
+		// Second differences along u, along v and across (the discrete thin plate energy of the control net)
+		std::vector<Eigen::Triplet<double> > smoothnessTerms;
+		int row = 0;
+		for (int i = 0; i < cellsU + 3; i++) {
+			for (int j = 0; j < controlPointsV; j++) {
+				int point = i * controlPointsV + j;
+				if (i + 2 < cellsU + 3) {
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row, point, 1.0));
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row, point + controlPointsV, -2.0));
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row++, point + 2 * controlPointsV, 1.0));
+				}
+				if (j + 2 < controlPointsV) {
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row, point, 1.0));
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row, point + 1, -2.0));
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row++, point + 2, 1.0));
+				}
+				if (i + 1 < cellsU + 3 && j + 1 < controlPointsV) {
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row, point, M_SQRT2));
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row, point + 1, -M_SQRT2));
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row, point + controlPointsV, -M_SQRT2));
+					smoothnessTerms.push_back(Eigen::Triplet<double>(row++, point + controlPointsV + 1, M_SQRT2));
+				}
+			}
+		}
+		Eigen::SparseMatrix<double> smoothnessMatrix(row, numberOfControlPoints);
+		smoothnessMatrix.setFromTriplets(smoothnessTerms.begin(), smoothnessTerms.end());
+
+		// Normal equations of the least-squares problem, solved for x, y and z at once
+		double weight = smoothing * data.size() / numberOfControlPoints;
+		Eigen::SparseMatrix<double> normalMatrix = Eigen::SparseMatrix<double>(dataMatrix.transpose() * dataMatrix)
+				+ weight * Eigen::SparseMatrix<double>(smoothnessMatrix.transpose() * smoothnessMatrix);
+		Eigen::MatrixXd targets(data.size(), 3);
+		for (std::vector<Eigen::Vector3f>::size_type k = 0; k < data.size(); k++) {
+			targets.row(k) = data[k].cast<double>().transpose();
+		}
+		Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > solver(normalMatrix);
+		if (solver.info() != Eigen::Success) {
+			return;
+		}
+		Eigen::MatrixXd controlPoints = solver.solve(dataMatrix.transpose() * targets);
+
+		Eigen::MatrixXd residuals = dataMatrix * controlPoints - targets;
+		for (int k = 0; k < residuals.rows(); k++) {
+			double squaredError = residuals.row(k).squaredNorm();
+			fit.maxError = std::max(fit.maxError, (float) sqrt(squaredError));
+			fit.squaredErrorSum += squaredError;
+		}
+		fit.numberOfDataPoints = data.size();
+
+		// The part of every cell that the region covers (the union of the bounding boxes of its triangles, in units of
+		// cells, relative to the cell's corner), so that patches on the border of the region do not reach far beyond it
+		std::vector<Eigen::Vector4d> coveredRanges(cellsU * cellsV, Eigen::Vector4d(1.0, 1.0, 0.0, 0.0));
+		for (std::vector<int>::size_type k = 0; k < region.size(); k++) {
+			const int* triangle = &corners[3 * region[k]];
+			Eigen::Vector2d low = Eigen::Vector2d::Constant(HUGE_VAL), high = Eigen::Vector2d::Constant(-HUGE_VAL);
+			for (int corner = 0; corner < 3; corner++) {
+				Eigen::Vector3f offset = positions[triangle[corner]] - center;
+				Eigen::Vector2d point((offset.dot(axisU) - lowest.x()) / cellSize.x(), (offset.dot(axisV) - lowest.y()) / cellSize.y());
+				low = low.cwiseMin(point);
+				high = high.cwiseMax(point);
+			}
+			low = low.cwiseMax(Eigen::Vector2d::Zero());
+			high = high.cwiseMin(Eigen::Vector2d(cellsU, cellsV));
+			for (int i = std::min((int) low.x(), cellsU - 1); i <= std::min((int) high.x(), cellsU - 1); i++) {
+				for (int j = std::min((int) low.y(), cellsV - 1); j <= std::min((int) high.y(), cellsV - 1); j++) {
+					Eigen::Vector4d& range = coveredRanges[i * cellsV + j];
+					range.head<2>() = range.head<2>().cwiseMin((low - Eigen::Vector2d(i, j)).cwiseMax(Eigen::Vector2d::Zero()));
+					range.tail<2>() = range.tail<2>().cwiseMax((high - Eigen::Vector2d(i, j)).cwiseMin(Eigen::Vector2d::Ones()));
+				}
+			}
+		}
+
+		// Every covered cell becomes a Bezier patch over its covered part. Per direction, the Bezier points of a
+		// uniform cubic B-spline segment are fixed combinations of its four control points.
+		static const double toBezier[4][4] = {{1.0 / 6.0, 4.0 / 6.0, 1.0 / 6.0, 0.0}, {0.0, 4.0 / 6.0, 2.0 / 6.0, 0.0},
+				{0.0, 2.0 / 6.0, 4.0 / 6.0, 0.0}, {0.0, 1.0 / 6.0, 4.0 / 6.0, 1.0 / 6.0}};
+		for (int i = 0; i < cellsU; i++) {
+			for (int j = 0; j < cellsV; j++) {
+				const Eigen::Vector4d& range = coveredRanges[i * cellsV + j];
+				// (ranges of almost no width only come from triangles seen edge-on, and would make degenerate patches)
+				if (range.z() - range.x() < 1e-3 || range.w() - range.y() < 1e-3) {
+					continue;
+				}
+				// bezier[a][b] is the point a along u and b along v
+				Eigen::Vector3d bezier[4][4];
+				for (int a = 0; a < 4; a++) {
+					for (int b = 0; b < 4; b++) {
+						bezier[a][b] = Eigen::Vector3d::Zero();
+						for (int k = 0; k < 4; k++) {
+							for (int l = 0; l < 4; l++) {
+								double factor = toBezier[a][k] * toBezier[b][l];
+								if (factor != 0.0) {
+									bezier[a][b] += factor * controlPoints.row((i + k) * controlPointsV + j + l).transpose();
+								}
+							}
+						}
+					}
+				}
+
+				// Restrict the patch to the covered range, first along u, then along v
+				std::vector<std::vector<Eigen::Vector3f> > patch(4, std::vector<Eigen::Vector3f>(4));
+				for (int b = 0; b < 4; b++) {
+					Eigen::Vector3d column[4] = {bezier[0][b], bezier[1][b], bezier[2][b], bezier[3][b]};
+					restrict(column, range.x(), range.z());
+					for (int a = 0; a < 4; a++) {
+						bezier[a][b] = column[a];
+					}
+				}
+				for (int a = 0; a < 4; a++) {
+					restrict(bezier[a], range.y(), range.w());
+					for (int b = 0; b < 4; b++) {
+						// Rows of listOfCurves run along u, and follow each other along v
+						patch[b][a] = bezier[a][b].cast<float>();
+					}
+				}
+				fit.patches.push_back(patch);
+			}
+		}
+	}
+
+	// Replaces the control points of a cubic Bezier curve with those of its piece over [from, to]: the values of its
+	// blossom at (from, from, from), (from, from, to), (from, to, to) and (to, to, to)
+	static void restrict(Eigen::Vector3d* points, double from, double to) {
+		if (from == 0.0 && to == 1.0) {
+			return;
+		}
+		Eigen::Vector3d restricted[4];
+		for (int k = 0; k < 4; k++) {
+			// De Casteljau's algorithm, with parameter 'to' in the first k steps and 'from' in the others
+			Eigen::Vector3d level[4] = {points[0], points[1], points[2], points[3]};
+			for (int step = 0; step < 3; step++) {
+				double t = step < k ? to : from;
+				for (int m = 0; m < 3 - step; m++) {
+					level[m] = (1.0 - t) * level[m] + t * level[m + 1];
+				}
+			}
+			restricted[k] = level[0];
+		}
+		for (int k = 0; k < 4; k++) {
+			points[k] = restricted[k];
+		}
+	}
+
+	// The cell (i, j) that the projected point 'point' falls into, and the B-spline basis functions there
+	static void cellOf(const Eigen::Vector2f& point, const Eigen::Vector2f& lowest, const Eigen::Vector2f& cellSize,
+			int cellsU, int cellsV, int& i, int& j, double* basisU, double* basisV) {
+		double u = (point.x() - lowest.x()) / cellSize.x();
+		double v = (point.y() - lowest.y()) / cellSize.y();
+		i = std::max(0, std::min(cellsU - 1, (int) floor(u)));
+		j = std::max(0, std::min(cellsV - 1, (int) floor(v)));
+		bSplineBasis(std::max(0.0, std::min(1.0, u - i)), basisU);
+		bSplineBasis(std::max(0.0, std::min(1.0, v - j)), basisV);
+	}
+};
+
+
+#endif /* BEZIERSURFACEFITTER_H_ */
@@ -117,6 +117,42 @@ class Camera {
 		Z_TRANSLATION_AMOUNT -= TRANSLATION_DELTA;
 	}
 
+	// Model-view matrix equivalent to the gluLookAt(), glRotatef() and glTranslatef() calls made by myDisplay()
+	Eigen::Matrix4f modelViewMatrix() const {
+		Eigen::Vector3f forward = (lookAt - position).normalized();
+		Eigen::Vector3f side = forward.cross(up).normalized();
+		Eigen::Vector3f trueUp = side.cross(forward);
+
+		Eigen::Matrix4f lookAtMatrix = Eigen::Matrix4f::Identity();
+		lookAtMatrix.block<1, 3>(0, 0) = side.transpose();
+		lookAtMatrix.block<1, 3>(1, 0) = trueUp.transpose();
+		lookAtMatrix.block<1, 3>(2, 0) = -forward.transpose();
+		lookAtMatrix.block<3, 1>(0, 3) = -(lookAtMatrix.block<3, 3>(0, 0) * position);
+
+		float degreesToRadians = (float) M_PI / 180.0f;
+		Eigen::Affine3f rotationAndTranslation = Eigen::Affine3f::Identity();
+		rotationAndTranslation.rotate(Eigen::AngleAxisf(X_ROTATION_AMOUNT * degreesToRadians, Eigen::Vector3f::UnitX()));
+		rotationAndTranslation.rotate(Eigen::AngleAxisf(Y_ROTATION_AMOUNT * degreesToRadians, Eigen::Vector3f::UnitY()));
+		rotationAndTranslation.rotate(Eigen::AngleAxisf(Z_ROTATION_AMOUNT * degreesToRadians, Eigen::Vector3f::UnitZ()));
+		rotationAndTranslation.translate(Eigen::Vector3f(X_TRANSLATION_AMOUNT, Y_TRANSLATION_AMOUNT, Z_TRANSLATION_AMOUNT));
+
+		return lookAtMatrix * rotationAndTranslation.matrix();
+	}
+
+	// Projection matrix equivalent to the gluPerspective() call made by myDisplay()
+	Eigen::Matrix4f projectionMatrix(float aspectRatio) const {
+		float fieldOfViewInRadians = FIELD_OF_VIEW * ZOOM_AMOUNT * (float) M_PI / 180.0f;
+		float f = 1.0f / tan(fieldOfViewInRadians / 2.0f);
+
+		Eigen::Matrix4f projection = Eigen::Matrix4f::Zero();
+		projection(0, 0) = f / aspectRatio;
+		projection(1, 1) = f;
+		projection(2, 2) = (zFar + zNear) / (zNear - zFar);
+		projection(2, 3) = (2.0f * zFar * zNear) / (zNear - zFar);
+		projection(3, 2) = -1.0f;
+		return projection;
+	}
+
 
 };
 
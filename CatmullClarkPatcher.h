@@ -0,0 +1,326 @@
+/*
+ * CatmullClarkPatcher.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef CATMULLCLARKPATCHER_H_
+#define CATMULLCLARKPATCHER_H_
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+//****************************************************
+// Approximates the Catmull-Clark limit surface of a polygon mesh with one bicubic Bezier patch per quad (Loop and
+// Schaefer, "Approximating Catmull-Clark Subdivision Surfaces with Bicubic Patches", 2008, without their tangent
+// patches).
+//
+// Meshes that are not made of quads only are first subdivided once with the Catmull-Clark rules, which makes them so.
+// Every corner of a quad then gets an interior control point, a weighted average of its vertex (weight n, its valence),
+// the two neighbors along the quad (2 each) and the opposite corner (1). The edge control points next to a vertex
+// are the averages of the interior points on both sides of the edge, and the corner control point is the average of
+// all interior points around the vertex, which is exactly where the limit surface passes through it. Where all
+// vertices of a quad have valence 4, this is the exact conversion of the bicubic B-spline to Bezier form; around
+// extraordinary vertices, neighboring patches share their edges (so the surface has no cracks), but only
+// approximately their tangent planes.
+//
+// Boundaries follow the cubic B-spline curve through their vertices; vertices with only one quad are kept as
+// corners, and edges shared by more than two faces are treated as boundaries.
+//***************************************************
+class CatmullClarkPatcher {
+	public:
+		std::vector<Eigen::Vector3f> vertices;
+
+		// Corners of every face (indices into 'vertices'), counterclockwise seen from the outside
+		std::vector<std::vector<int> > faces;
+
+		// Number of extraordinary vertices (not on the boundary, and not of valence 4) of the quad mesh
+		int numberOfExtraordinaryVertices;
+
+	CatmullClarkPatcher() {
+		numberOfExtraordinaryVertices = 0;
+	}
+
+	// Sets the mesh from a list of polygons, welding corners at the same position into one vertex
+	void setPolygons(const std::vector<std::vector<Eigen::Vector3f> >& polygons) {
+		std::vector<std::pair<std::pair<float, std::pair<float, float> >, int> > corners;
+		for (std::vector<std::vector<Eigen::Vector3f> >::size_type f = 0; f < polygons.size(); f++) {
+			for (std::vector<Eigen::Vector3f>::size_type k = 0; k < polygons[f].size(); k++) {
+				const Eigen::Vector3f& p = polygons[f][k];
+				corners.push_back(std::make_pair(std::make_pair(p.x(), std::make_pair(p.y(), p.z())), (int) corners.size()));
+			}
+		}
+		std::sort(corners.begin(), corners.end());
+
+		std::vector<int> vertexOfCorner(corners.size());
+		vertices.clear();
+		for (std::vector<int>::size_type k = 0; k < corners.size(); k++) {
+			if (k == 0 || corners[k].first != corners[k - 1].first) {
+				const std::pair<float, std::pair<float, float> >& p = corners[k].first;
+				vertices.push_back(Eigen::Vector3f(p.first, p.second.first, p.second.second));
+			}
+			vertexOfCorner[corners[k].second] = vertices.size() - 1;
+		}
+
+		faces.clear();
+		int corner = 0;
+		for (std::vector<std::vector<Eigen::Vector3f> >::size_type f = 0; f < polygons.size(); f++) {
+			std::vector<int> face;
+			for (std::vector<Eigen::Vector3f>::size_type k = 0; k < polygons[f].size(); k++, corner++) {
+				// (faces that revisit a vertex right away have a degenerate edge, which is dropped)
+				if (face.empty() || face.back() != vertexOfCorner[corner]) {
+					face.push_back(vertexOfCorner[corner]);
+				}
+			}
+			while (face.size() > 1 && face.back() == face.front()) {
+				face.pop_back();
+			}
+			if (face.size() >= 3) {
+				faces.push_back(face);
+			}
+		}
+	}
+
+	// Appends the control points of one bicubic patch per quad of the mesh (as BezierPatch::listOfCurves: 4 rows of
+	// 4 points) to 'patches', subdividing the mesh once first if it has faces that are not quads
+	void buildPatches(std::vector<std::vector<std::vector<Eigen::Vector3f> > >& patches) {
+		for (std::vector<std::vector<int> >::size_type f = 0; f < faces.size(); f++) {
+			if (faces[f].size() != 4) {
+				subdivide();
+				break;
+			}
+		}
+
+		Connectivity mesh(faces, vertices.size());
+
+		// Interior control point of every corner of every quad (corner k of face f is half edge 4 * f + k)
+		std::vector<Eigen::Vector3f> interior(4 * faces.size());
+		std::vector<Eigen::Vector3f> corner(vertices.size(), Eigen::Vector3f::Zero());
+		numberOfExtraordinaryVertices = 0;
+		for (int v = 0; v < (int) vertices.size(); v++) {
+			numberOfExtraordinaryVertices += !mesh.isBoundary(v) && mesh.valence[v] > 0 && mesh.valence[v] != 4;
+		}
+		for (std::vector<std::vector<int> >::size_type f = 0; f < faces.size(); f++) {
+			const std::vector<int>& face = faces[f];
+			for (int k = 0; k < 4; k++) {
+				int v = face[k];
+				// Boundary vertices use the weights of the regular case
+				float n = mesh.isBoundary(v) ? 4.0f : (float) mesh.valence[v];
+				interior[4 * f + k] = (n * vertices[v] + 2.0f * (vertices[face[(k + 1) % 4]] + vertices[face[(k + 3) % 4]])
+						+ vertices[face[(k + 2) % 4]]) / (n + 5.0f);
+				corner[v] += interior[4 * f + k];
+			}
+		}
+		for (int v = 0; v < (int) vertices.size(); v++) {
+			if (mesh.isBoundary(v)) {
+				corner[v] = mesh.valence[v] == 1 || mesh.boundaryNeighbors[v].size() != 2 ? vertices[v]
+						: Eigen::Vector3f((vertices[mesh.boundaryNeighbors[v][0]] + 4.0f * vertices[v]
+								+ vertices[mesh.boundaryNeighbors[v][1]]) / 6.0f);
+			} else if (mesh.valence[v] > 0) {
+				corner[v] /= mesh.valence[v];
+			}
+		}
+
+		for (std::vector<std::vector<int> >::size_type f = 0; f < faces.size(); f++) {
+			const std::vector<int>& face = faces[f];
+			// points[a][b] is the control point a along u (from corner 0 to corner 1) and b along v (to corner 3)
+			Eigen::Vector3f points[4][4];
+			static const int cornerU[4] = {0, 3, 3, 0}, cornerV[4] = {0, 0, 3, 3};
+			for (int k = 0; k < 4; k++) {
+				int h = 4 * f + k;
+				int u = cornerU[k], v = cornerV[k];
+				// One step from the corner into the patch, along u and along v
+				int stepU = u == 0 ? 1 : -1, stepV = v == 0 ? 1 : -1;
+				points[u][v] = corner[face[k]];
+				points[u + stepU][v + stepV] = interior[h];
+
+				// The edges to the next corner and from the previous one; corners 0 and 2 reach the next corner along u,
+				// corners 1 and 3 along v
+				Eigen::Vector3f toNext = edgePoint(mesh, interior, h, true);
+				Eigen::Vector3f toPrevious = edgePoint(mesh, interior, h, false);
+				if (k % 2 == 0) {
+					points[u + stepU][v] = toNext;
+					points[u][v + stepV] = toPrevious;
+				} else {
+					points[u][v + stepV] = toNext;
+					points[u + stepU][v] = toPrevious;
+				}
+			}
+
+			std::vector<std::vector<Eigen::Vector3f> > patch(4, std::vector<Eigen::Vector3f>(4));
+			for (int a = 0; a < 4; a++) {
+				for (int b = 0; b < 4; b++) {
+					// Rows of listOfCurves run along u, and follow each other along v
+					patch[b][a] = points[a][b];
+				}
+			}
+			patches.push_back(patch);
+		}
+	}
+
+	// Replaces the mesh with one step of Catmull-Clark subdivision of it, in which every face of n corners becomes
+	// n quads
+	void subdivide() {
+		Connectivity mesh(faces, vertices.size());
+		int numberOfVertices = vertices.size(), numberOfFaces = faces.size();
+
+		// New vertices: the moved old vertices, then one per face, then one per edge
+		std::vector<Eigen::Vector3f> facePoints(numberOfFaces, Eigen::Vector3f::Zero());
+		for (int f = 0; f < numberOfFaces; f++) {
+			for (std::vector<int>::size_type k = 0; k < faces[f].size(); k++) {
+				facePoints[f] += vertices[faces[f][k]];
+			}
+			facePoints[f] /= faces[f].size();
+		}
+
+		std::vector<Eigen::Vector3f> edgePoints(mesh.numberOfEdges);
+		std::vector<Eigen::Vector3f> faceSums(numberOfVertices, Eigen::Vector3f::Zero());
+		std::vector<Eigen::Vector3f> edgeSums(numberOfVertices, Eigen::Vector3f::Zero());
+		for (int h = 0; h < (int) mesh.halfEdgeFace.size(); h++) {
+			int from = mesh.from(h), to = mesh.to(h);
+			int twin = mesh.twin[h];
+			Eigen::Vector3f middle = 0.5f * (vertices[from] + vertices[to]);
+			if (twin < 0) {
+				edgePoints[mesh.edge[h]] = middle;
+			} else if (h < twin) {
+				edgePoints[mesh.edge[h]] = 0.5f * middle
+						+ 0.25f * (facePoints[mesh.halfEdgeFace[h]] + facePoints[mesh.halfEdgeFace[twin]]);
+			}
+			// Every corner is one face and one outgoing edge around its vertex
+			faceSums[from] += facePoints[mesh.halfEdgeFace[h]];
+			edgeSums[from] += middle;
+		}
+
+		std::vector<Eigen::Vector3f> newVertices(numberOfVertices);
+		for (int v = 0; v < numberOfVertices; v++) {
+			float n = mesh.valence[v];
+			if (mesh.isBoundary(v)) {
+				newVertices[v] = mesh.boundaryNeighbors[v].size() != 2 || mesh.valence[v] == 1 ? vertices[v]
+						: Eigen::Vector3f((vertices[mesh.boundaryNeighbors[v][0]] + 6.0f * vertices[v]
+								+ vertices[mesh.boundaryNeighbors[v][1]]) / 8.0f);
+			} else if (n > 0) {
+				newVertices[v] = (faceSums[v] / n + 2.0f * edgeSums[v] / n + (n - 3.0f) * vertices[v]) / n;
+			} else {
+				newVertices[v] = vertices[v];
+			}
+		}
+		newVertices.insert(newVertices.end(), facePoints.begin(), facePoints.end());
+		newVertices.insert(newVertices.end(), edgePoints.begin(), edgePoints.end());
+
+		std::vector<std::vector<int> > newFaces;
+		newFaces.reserve(mesh.halfEdgeFace.size());
+		for (int h = 0; h < (int) mesh.halfEdgeFace.size(); h++) {
+			std::vector<int> quad(4);
+			quad[0] = mesh.from(h);
+			quad[1] = numberOfVertices + numberOfFaces + mesh.edge[h];
+			quad[2] = numberOfVertices + mesh.halfEdgeFace[h];
+			quad[3] = numberOfVertices + numberOfFaces + mesh.edge[mesh.previous(h)];
+			newFaces.push_back(quad);
+		}
+
+		vertices.swap(newVertices);
+		faces.swap(newFaces);
+	}
+
+
+	private:
+
+	// Half edges of a polygon mesh: corner k of face f is half edge firstHalfEdge[f] + k, which leads from that corner
+	// to the next one
+	struct Connectivity {
+		const std::vector<std::vector<int> >& faces;
+		std::vector<int> firstHalfEdge, halfEdgeFace;
+
+		// The half edge of the neighboring face along the same edge (-1 on boundaries), and the index of the edge
+		std::vector<int> twin, edge;
+		int numberOfEdges;
+
+		// Number of faces around every vertex, and the vertices it shares boundary edges with
+		std::vector<int> valence;
+		std::vector<std::vector<int> > boundaryNeighbors;
+
+		Connectivity(const std::vector<std::vector<int> >& faces, int numberOfVertices) : faces(faces) {
+			for (std::vector<std::vector<int> >::size_type f = 0; f < faces.size(); f++) {
+				firstHalfEdge.push_back(halfEdgeFace.size());
+				halfEdgeFace.insert(halfEdgeFace.end(), faces[f].size(), (int) f);
+			}
+
+			// Pair up the half edges by sorting them by their (smaller, larger) vertex pair
+			int numberOfHalfEdges = halfEdgeFace.size();
+			std::vector<std::pair<std::pair<int, int>, int> > sorted(numberOfHalfEdges);
+			for (int h = 0; h < numberOfHalfEdges; h++) {
+				sorted[h] = std::make_pair(std::make_pair(std::min(from(h), to(h)), std::max(from(h), to(h))), h);
+			}
+			std::sort(sorted.begin(), sorted.end());
+			twin.assign(numberOfHalfEdges, -1);
+			edge.assign(numberOfHalfEdges, -1);
+			numberOfEdges = 0;
+			for (int begin = 0, end; begin < numberOfHalfEdges; begin = end) {
+				for (end = begin + 1; end < numberOfHalfEdges && sorted[end].first == sorted[begin].first; end++) {
+				}
+				// Only two opposite half edges make an interior edge; anything else is boundary
+				if (end - begin == 2 && from(sorted[begin].second) != from(sorted[begin + 1].second)) {
+					twin[sorted[begin].second] = sorted[begin + 1].second;
+					twin[sorted[begin + 1].second] = sorted[begin].second;
+				}
+				for (int k = begin; k < end; k++) {
+					edge[sorted[k].second] = numberOfEdges;
+				}
+				numberOfEdges++;
+			}
+
+			valence.assign(numberOfVertices, 0);
+			boundaryNeighbors.resize(numberOfVertices);
+			for (int h = 0; h < numberOfHalfEdges; h++) {
+				valence[from(h)]++;
+				if (twin[h] < 0) {
+					boundaryNeighbors[from(h)].push_back(to(h));
+					boundaryNeighbors[to(h)].push_back(from(h));
+				}
+			}
+		}
+
+		int from(int h) const {
+			return faces[halfEdgeFace[h]][h - firstHalfEdge[halfEdgeFace[h]]];
+		}
+
+		int to(int h) const {
+			return from(next(h));
+		}
+
+		int next(int h) const {
+			int f = halfEdgeFace[h];
+			return h + 1 < firstHalfEdge[f] + (int) faces[f].size() ? h + 1 : firstHalfEdge[f];
+		}
+
+		int previous(int h) const {
+			int f = halfEdgeFace[h];
+			return h > firstHalfEdge[f] ? h - 1 : firstHalfEdge[f] + faces[f].size() - 1;
+		}
+
+		bool isBoundary(int v) const {
+			return !boundaryNeighbors[v].empty();
+		}
+	};
+
+	// Edge control point next to the corner of half edge h (of a quad), on the edge to the next corner of the quad
+	// (or from the previous one)
+	Eigen::Vector3f edgePoint(const Connectivity& mesh, const std::vector<Eigen::Vector3f>& interior, int h, bool toNext) const {
+		int v = mesh.from(h);
+		int edgeHalfEdge = toNext ? h : mesh.previous(h);
+		int twin = mesh.twin[edgeHalfEdge];
+		if (twin < 0) {
+			int neighbor = toNext ? mesh.to(h) : mesh.from(edgeHalfEdge);
+			return (2.0f * vertices[v] + vertices[neighbor]) / 3.0f;
+		}
+		// The corner of the other face at the same vertex: right after the twin when the edge leaves v, the twin
+		// itself when it arrives at v
+		int otherCorner = toNext ? mesh.next(twin) : twin;
+		return 0.5f * (interior[h] + interior[otherCorner]);
+	}
+};
+
+
+#endif /* CATMULLCLARKPATCHER_H_ */
@@ -0,0 +1,151 @@
+/*
+ * ControlPointAnimation.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef CONTROLPOINTANIMATION_H_
+#define CONTROLPOINTANIMATION_H_
+
+#include <vector>
+#include <cmath>
+
+// Offsets of every control point of an animated range of patches at one point in time
+class ControlPointKeyframe {
+	public:
+		float time;
+
+		// One offset per control point, patch by patch and row by row (the order of ControlPointAnimation::restPose)
+		std::vector<Eigen::Vector3f> offsets;
+
+	ControlPointKeyframe(float time, const std::vector<Eigen::Vector3f>& offsets) {
+		this->time = time;
+		this->offsets = offsets;
+	}
+};
+
+
+//****************************************************
+// Deforms the patches [begin, end) of a list over time by moving their control points away from a rest pose:
+// first by keyframed offsets (interpolated linearly, and repeated after the last keyframe), then by a twist about
+// an axis through the middle of the rest pose (growing linearly along the axis), then by scaling about that middle.
+// The twist and the scale swing back and forth once every 'period' seconds.
+//
+// apply() only sets the control points (through BezierPatch::setControlPoint, which flags the patches that actually
+// changed); a PatchRetessellator then updates their tessellations.
+//***************************************************
+class ControlPointAnimation {
+	public:
+		int begin, end;
+
+		// Rest positions of the control points of patches [begin, end), patch by patch and row by row
+		std::vector<Eigen::Vector3f> restPose;
+
+		// Keyframes, in increasing time order (none: no offsets)
+		std::vector<ControlPointKeyframe> keyframes;
+
+		// Largest twist (in degrees, between the two ends of the rest pose along twistAxis) and relative change of size
+		float twistDegrees, scaleAmount;
+		Eigen::Vector3f twistAxis;
+		float period;
+
+	ControlPointAnimation() {
+		begin = end = 0;
+		twistDegrees = scaleAmount = 0.0f;
+		twistAxis = Eigen::Vector3f(0.0f, 0.0f, 1.0f);
+		period = 2.0f;
+		lowest = highest = 0.0f;
+		middle = Eigen::Vector3f::Zero();
+	}
+
+	// Records the current control points of patches [begin, end) as the rest pose
+	void setRestPose(const std::vector<BezierPatch>& patches, int begin, int end) {
+		this->begin = begin;
+		this->end = end;
+		restPose.clear();
+		for (int i = begin; i < end; i++) {
+			for (std::vector<std::vector<Eigen::Vector3f> >::size_type row = 0; row < patches[i].listOfCurves.size(); row++) {
+				restPose.insert(restPose.end(), patches[i].listOfCurves[row].begin(), patches[i].listOfCurves[row].end());
+			}
+		}
+
+		Eigen::Vector3f minimum = Eigen::Vector3f::Constant(HUGE_VALF), maximum = Eigen::Vector3f::Constant(-HUGE_VALF);
+		for (std::vector<Eigen::Vector3f>::size_type k = 0; k < restPose.size(); k++) {
+			minimum = minimum.cwiseMin(restPose[k]);
+			maximum = maximum.cwiseMax(restPose[k]);
+		}
+		middle = restPose.empty() ? Eigen::Vector3f::Zero() : Eigen::Vector3f(0.5f * (minimum + maximum));
+		updateAxisRange();
+	}
+
+	void setTwistAxis(const Eigen::Vector3f& axis) {
+		twistAxis = axis.normalized();
+		updateAxisRange();
+	}
+
+	// Adds a keyframe; 'offsets' has one entry per control point of the rest pose
+	void addKeyframe(float time, const std::vector<Eigen::Vector3f>& offsets) {
+		keyframes.push_back(ControlPointKeyframe(time, offsets));
+	}
+
+	// Moves the control points to where they are 'time' seconds into the animation
+	void apply(std::vector<BezierPatch>& patches, float time) const {
+		float swing = sin(2.0 * M_PI * time / period);
+		float scale = 1.0f + scaleAmount * swing;
+		float twistPerLength = highest > lowest ? (float) (twistDegrees * swing * M_PI / 180.0 / (highest - lowest)) : 0.0f;
+
+		// The two keyframes around 'time', and how far along from the first to the second it is
+		const ControlPointKeyframe* before = NULL;
+		const ControlPointKeyframe* after = NULL;
+		float fraction = 0.0f;
+		if (!keyframes.empty()) {
+			float keyframeTime = keyframes.back().time > 0.0f ? fmod(time, keyframes.back().time) : 0.0f;
+			std::vector<ControlPointKeyframe>::size_type next = 0;
+			while (next < keyframes.size() && keyframes[next].time <= keyframeTime) {
+				next++;
+			}
+			before = &keyframes[next > 0 ? next - 1 : 0];
+			after = &keyframes[next < keyframes.size() ? next : keyframes.size() - 1];
+			if (after->time > before->time) {
+				fraction = (keyframeTime - before->time) / (after->time - before->time);
+			}
+		}
+
+		std::vector<Eigen::Vector3f>::size_type k = 0;
+		for (int i = begin; i < end; i++) {
+			BezierPatch& patch = patches[i];
+			for (std::vector<std::vector<Eigen::Vector3f> >::size_type row = 0; row < patch.listOfCurves.size(); row++) {
+				for (std::vector<Eigen::Vector3f>::size_type column = 0; column < patch.listOfCurves[row].size(); column++, k++) {
+					Eigen::Vector3f point = restPose[k];
+					if (before != NULL) {
+						point += (1.0f - fraction) * before->offsets[k] + fraction * after->offsets[k];
+					}
+					if (twistPerLength != 0.0f) {
+						float angle = twistPerLength * (twistAxis.dot(point - middle) - lowest);
+						point = middle + Eigen::AngleAxisf(angle, twistAxis) * (point - middle);
+					}
+					patch.setControlPoint(row, column, middle + scale * (point - middle));
+				}
+			}
+		}
+	}
+
+
+	private:
+		// Middle of the rest pose's bounding box, and its extent along twistAxis (relative to the middle)
+		Eigen::Vector3f middle;
+		float lowest, highest;
+
+	void updateAxisRange() {
+		lowest = HUGE_VALF;
+		highest = -HUGE_VALF;
+		for (std::vector<Eigen::Vector3f>::size_type k = 0; k < restPose.size(); k++) {
+			float height = twistAxis.dot(restPose[k] - middle);
+			lowest = std::min(lowest, height);
+			highest = std::max(highest, height);
+		}
+	}
+};
+
+
+#endif /* CONTROLPOINTANIMATION_H_ */
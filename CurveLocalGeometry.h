@@ -19,7 +19,7 @@ class CurveLocalGeometry {
 
 	}
 
-	CurveLocalGeometry(Eigen::Vector3f point, Eigen::Vector3f derivative) {
+	CurveLocalGeometry(const Eigen::Vector3f& point, const Eigen::Vector3f& derivative) {
 		this->point = point;
 		this->derivative = derivative;
 	}
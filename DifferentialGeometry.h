@@ -25,13 +25,13 @@ class DifferentialGeometry {
 
 	}
 
-	DifferentialGeometry(Eigen::Vector3f position, Eigen::Vector3f normal, Eigen::Vector2f uvValues) {
+	DifferentialGeometry(const Eigen::Vector3f& position, const Eigen::Vector3f& normal, const Eigen::Vector2f& uvValues) {
 		this->position = position;
 		this->normal = normal;
 		this->uvValues = uvValues;
 	}
 
-	DifferentialGeometry(Eigen::Vector3f position) {
+	DifferentialGeometry(const Eigen::Vector3f& position) {
 		this->position = position;
 	}
 };
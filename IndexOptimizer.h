@@ -0,0 +1,164 @@
+/*
+ * IndexOptimizer.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INDEXOPTIMIZER_H_
+#define INDEXOPTIMIZER_H_
+
+#include <vector>
+
+// Reorders triangle index buffers for the GPU's post-transform vertex cache, measures how well an order uses that
+// cache, and builds triangle strips for uniform grids
+class IndexOptimizer {
+	public:
+		// Size of the (FIFO) post-transform vertex cache that orders are optimized for and measured with
+		static const int CACHE_SIZE = 16;
+
+		// Index that ends one triangle strip and starts the next (with GL_PRIMITIVE_RESTART)
+		static const unsigned int RESTART_INDEX = 0xFFFFFFFFu;
+
+
+	//****************************************************
+	// Average cache miss ratio (ACMR) of drawing 'indices' (three per triangle) through a FIFO vertex cache of
+	// 'cacheSize' vertices: the number of vertices that have to be transformed per triangle. Between 0.5 (for the
+	// best orders of large grids) and 3 (no reuse at all).
+	//***************************************************
+	static double averageCacheMissRatio(const std::vector<unsigned int>& indices, int numberOfVertices, int cacheSize = CACHE_SIZE) {
+		if (indices.empty()) {
+			return 0.0;
+		}
+		// A vertex is in the cache if it was loaded within the last 'cacheSize' misses
+		std::vector<long> loadedAt(numberOfVertices, -1);
+		long misses = 0;
+		for (std::vector<unsigned int>::size_type i = 0; i < indices.size(); i++) {
+			unsigned int vertex = indices[i];
+			if (loadedAt[vertex] < 0 || misses - loadedAt[vertex] >= cacheSize) {
+				loadedAt[vertex] = misses;
+				misses++;
+			}
+		}
+		return (double) misses / (indices.size() / 3);
+	}
+
+
+	//****************************************************
+	// Reorders the triangles of 'indices' (three per triangle) with Tipsify (Sander, Nehab and Barczak, "Fast
+	// Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007), in time linear in the mesh size.
+	//
+	// Triangles are emitted as fans around one vertex at a time. The next fanning vertex is picked among the vertices
+	// of the last fan that still have triangles left and will still be in the cache when their fan is emitted, the
+	// one that entered the cache earliest first; when there is none, the most recently used vertex with triangles left
+	// (or, failing that, the next such vertex in index order) is used.
+	//***************************************************
+	static void tipsify(std::vector<unsigned int>& indices, int numberOfVertices, int cacheSize = CACHE_SIZE) {
+		int numberOfTriangles = indices.size() / 3;
+
+		// Triangles around every vertex, as offsets into one array
+		std::vector<int> liveTriangles(numberOfVertices, 0);
+		for (std::vector<unsigned int>::size_type i = 0; i < indices.size(); i++) {
+			liveTriangles[indices[i]]++;
+		}
+		std::vector<int> firstAdjacent(numberOfVertices + 1, 0);
+		for (int v = 0; v < numberOfVertices; v++) {
+			firstAdjacent[v + 1] = firstAdjacent[v] + liveTriangles[v];
+		}
+		std::vector<int> adjacentTriangles(indices.size());
+		std::vector<int> filled(firstAdjacent.begin(), firstAdjacent.end() - 1);
+		for (int t = 0; t < numberOfTriangles; t++) {
+			for (int k = 0; k < 3; k++) {
+				adjacentTriangles[filled[indices[3 * t + k]]++] = t;
+			}
+		}
+
+		std::vector<int> cacheTime(numberOfVertices, 0);
+		std::vector<bool> emitted(numberOfTriangles, false);
+		std::vector<int> deadEnds;
+		std::vector<int> candidates;
+		std::vector<unsigned int> output;
+		output.reserve(indices.size());
+
+		int time = cacheSize + 1;
+		int cursor = 0;
+		int fanningVertex = numberOfTriangles > 0 ? (int) indices[0] : -1;
+		while (fanningVertex >= 0) {
+			candidates.clear();
+			for (int a = firstAdjacent[fanningVertex]; a < firstAdjacent[fanningVertex + 1]; a++) {
+				int t = adjacentTriangles[a];
+				if (emitted[t]) {
+					continue;
+				}
+				for (int k = 0; k < 3; k++) {
+					int vertex = indices[3 * t + k];
+					output.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+					if (time - cacheTime[vertex] > cacheSize) {
+						cacheTime[vertex] = time;
+						time++;
+					}
+				}
+				emitted[t] = true;
+			}
+
+			// Next fanning vertex: the candidate that stays in the cache and entered it earliest
+			fanningVertex = -1;
+			int bestPriority = -1;
+			for (std::vector<int>::size_type i = 0; i < candidates.size(); i++) {
+				int vertex = candidates[i];
+				if (liveTriangles[vertex] <= 0) {
+					continue;
+				}
+				int priority = 0;
+				if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+					priority = time - cacheTime[vertex];
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					fanningVertex = vertex;
+				}
+			}
+
+			// Dead end: go back to a recently used vertex, or on to the next unfinished one
+			while (fanningVertex < 0 && !deadEnds.empty()) {
+				int vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[vertex] > 0) {
+					fanningVertex = vertex;
+				}
+			}
+			while (fanningVertex < 0 && cursor < numberOfVertices) {
+				if (liveTriangles[cursor] > 0) {
+					fanningVertex = cursor;
+				}
+				cursor++;
+			}
+		}
+		indices.swap(output);
+	}
+
+
+	//****************************************************
+	// Triangle strips covering the uniform grid of performUniformSubdivision with 'numberOfSteps' steps (vertex (u, v)
+	// is at index u * (numberOfSteps + 1) + v), with the same triangles and orientation: one strip per row of cells,
+	// alternating between the row's two sides, separated by RESTART_INDEX
+	//***************************************************
+	static void gridStrips(int numberOfSteps, std::vector<unsigned int>& strips) {
+		unsigned int restartIndex = RESTART_INDEX;
+		strips.clear();
+		for (int v = 0; v < numberOfSteps; v++) {
+			if (v > 0) {
+				strips.push_back(restartIndex);
+			}
+			for (int u = 0; u <= numberOfSteps; u++) {
+				strips.push_back(u * (numberOfSteps + 1) + v);
+				strips.push_back(u * (numberOfSteps + 1) + v + 1);
+			}
+		}
+	}
+};
+
+
+#endif /* INDEXOPTIMIZER_H_ */
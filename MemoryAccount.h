@@ -0,0 +1,71 @@
+/*
+ * MemoryAccount.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef MEMORYACCOUNT_H_
+#define MEMORYACCOUNT_H_
+
+#include <cstddef>
+#include <algorithm>
+
+//****************************************************
+// Keeps count of the memory held by a kind of data (such as the tessellations of all patches), the most it has
+// held so far, and whether that is more than an optional limit. Callers report what they allocate and free (or
+// recount the total); nothing is measured behind their backs. Not thread safe: parallel loops should report their
+// totals afterwards.
+//***************************************************
+class MemoryAccount {
+	public:
+		// Most memory (in bytes) the data is supposed to take, 0 for no limit
+		size_t limit;
+
+	MemoryAccount() {
+		limit = 0;
+		current = peak = 0;
+	}
+
+	void add(size_t bytes) {
+		current += bytes;
+		peak = std::max(peak, current);
+	}
+
+	void release(size_t bytes) {
+		current -= std::min(bytes, current);
+	}
+
+	// Replaces the count with a new total
+	void set(size_t bytes) {
+		current = bytes;
+		peak = std::max(peak, current);
+	}
+
+	bool isLimited() const {
+		return limit > 0;
+	}
+
+	bool isOverLimit() const {
+		return limit > 0 && current > limit;
+	}
+
+	// Whether 'bytes' more would still be within the limit
+	bool fits(size_t bytes) const {
+		return limit == 0 || current + bytes <= limit;
+	}
+
+	size_t currentBytes() const {
+		return current;
+	}
+
+	size_t peakBytes() const {
+		return peak;
+	}
+
+
+	private:
+		size_t current, peak;
+};
+
+
+#endif /* MEMORYACCOUNT_H_ */
@@ -0,0 +1,382 @@
+/*
+ * MeshDecimator.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef MESHDECIMATOR_H_
+#define MESHDECIMATOR_H_
+
+#include <vector>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+// Symmetric 4 x 4 matrix Q of a quadric error metric: the error of a point p is (p, 1)^T Q (p, 1), the sum of the
+// squared distances from p to the planes that were added to Q. Only the 10 distinct entries are stored.
+class Quadric {
+	public:
+		double entries[10];
+
+	Quadric() {
+		for (int i = 0; i < 10; i++) {
+			entries[i] = 0.0;
+		}
+	}
+
+	// Adds the plane through 'point' with unit normal 'normal'
+	void addPlane(const Eigen::Vector3f& normal, const Eigen::Vector3f& point) {
+		double a = normal.x(), b = normal.y(), c = normal.z();
+		double d = -(a * point.x() + b * point.y() + c * point.z());
+		entries[0] += a * a; entries[1] += a * b; entries[2] += a * c; entries[3] += a * d;
+		entries[4] += b * b; entries[5] += b * c; entries[6] += b * d;
+		entries[7] += c * c; entries[8] += c * d;
+		entries[9] += d * d;
+	}
+
+	void add(const Quadric& other) {
+		for (int i = 0; i < 10; i++) {
+			entries[i] += other.entries[i];
+		}
+	}
+
+	double error(const Eigen::Vector3f& point) const {
+		double x = point.x(), y = point.y(), z = point.z();
+		const double* q = entries;
+		return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+				+ q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+				+ q[7] * z * z + 2 * q[8] * z
+				+ q[9];
+	}
+};
+
+
+// A possible collapse of vertex 'from' into vertex 'to', ordered so that a std::priority_queue hands out the cheapest one
+// first. The versions tell whether either vertex changed since the collapse was queued (which makes it stale).
+class EdgeCollapse {
+	public:
+		double cost;
+		int from, to;
+		int fromVersion, toVersion;
+
+	EdgeCollapse() {
+
+	}
+
+	EdgeCollapse(double cost, int from, int to, int fromVersion, int toVersion) {
+		this->cost = cost;
+		this->from = from;
+		this->to = to;
+		this->fromVersion = fromVersion;
+		this->toVersion = toVersion;
+	}
+
+	bool operator<(const EdgeCollapse& other) const {
+		return cost > other.cost;
+	}
+};
+
+
+//****************************************************
+// Simplifies a tessellated patch with quadric error metric decimation (Garland and Heckbert).
+//
+// The patch's triangles are turned into an indexed mesh, and edges are collapsed cheapest first, where the cost of
+// a collapse is the quadric error (the summed squared distances to the planes of the original triangles around both
+// vertices) at the vertex that is kept. Collapses always move one vertex onto the other (half-edge collapses), so
+// every vertex that is left is an exact sample of the surface and keeps its exact normal and (u, v) value.
+//
+// Vertices on the boundary of the patch never move, so the patch keeps exactly the same boundary and neighbouring
+// patches still fit together without cracks. Collapses that would flip a triangle or make the mesh non-manifold
+// are skipped.
+//***************************************************
+class MeshDecimator {
+	public:
+		std::vector<DifferentialGeometry> vertices;
+
+		// three vertex indices per triangle
+		std::vector<int> triangles;
+
+	MeshDecimator() {
+
+	}
+
+
+	//****************************************************
+	// Simplifies 'patch' in place until it has at most 'targetTriangles' triangles, or until the next collapse would
+	// cost more than maxError^2 (i.e. move the surface by more than about maxError), whichever comes first.
+	// Returns the number of triangles that were removed.
+	//***************************************************
+	int decimate(BezierPatch& patch, int targetTriangles, float maxError) {
+		buildIndexedMesh(patch);
+		int removedTriangles = collapseEdges(targetTriangles, (double) maxError * maxError);
+		writeBack(patch);
+		return removedTriangles;
+	}
+
+
+	private:
+		std::vector<std::vector<int> > trianglesOfVertex;
+		std::vector<Quadric> quadrics;
+		std::vector<int> versions;
+		std::vector<bool> onBoundary;
+		std::vector<bool> triangleRemoved;
+		std::priority_queue<EdgeCollapse> queueOfCollapses;
+
+
+	// Turns the patch's triangles into 'vertices' and 'triangles', merging corners that are the same vertex (bit for bit)
+	void buildIndexedMesh(const BezierPatch& patch) {
+		vertices.clear();
+		triangles.clear();
+		std::unordered_map<std::string, int> vertexIndices;
+		for (std::vector<Triangle>::size_type i = 0; i < patch.listOfTriangles.size(); i++) {
+			const Triangle& triangle = patch.listOfTriangles[i];
+			triangles.push_back(vertexIndex(triangle.point1, vertexIndices));
+			triangles.push_back(vertexIndex(triangle.point2, vertexIndices));
+			triangles.push_back(vertexIndex(triangle.point3, vertexIndices));
+		}
+	}
+
+	int vertexIndex(const DifferentialGeometry& point, std::unordered_map<std::string, int>& vertexIndices) {
+		std::string vertexBytes = BezierPatch::pointKey(point);
+		std::unordered_map<std::string, int>::iterator existing = vertexIndices.find(vertexBytes);
+		if (existing != vertexIndices.end()) {
+			return existing->second;
+		}
+		vertices.push_back(point);
+		vertexIndices[vertexBytes] = vertices.size() - 1;
+		return vertices.size() - 1;
+	}
+
+	const Eigen::Vector3f& position(int vertex) const {
+		return vertices[vertex].position;
+	}
+
+	// Unnormalized normal of triangle 'triangle' if its corner 'replaced' were at 'replacement' instead
+	Eigen::Vector3f triangleNormal(int triangle, int replaced, int replacement) const {
+		Eigen::Vector3f corners[3];
+		for (int k = 0; k < 3; k++) {
+			int vertex = triangles[3 * triangle + k];
+			corners[k] = position(vertex == replaced ? replacement : vertex);
+		}
+		return (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+	}
+
+
+	//****************************************************
+	// Sets up adjacency, boundary flags and quadrics, then collapses edges until the target or the error bound is reached.
+	// Returns the number of triangles that were removed.
+	//***************************************************
+	int collapseEdges(int targetTriangles, double maxCost) {
+		int numberOfVertices = vertices.size();
+		int numberOfTriangles = triangles.size() / 3;
+		trianglesOfVertex.assign(numberOfVertices, std::vector<int>());
+		quadrics.assign(numberOfVertices, Quadric());
+		versions.assign(numberOfVertices, 0);
+		onBoundary.assign(numberOfVertices, false);
+		triangleRemoved.assign(numberOfTriangles, false);
+		queueOfCollapses = std::priority_queue<EdgeCollapse>();
+
+		// Edges used by anything but exactly two triangles are boundary (or non-manifold) edges; their vertices stay put
+		std::unordered_map<long long, int> edgeUses;
+		for (int t = 0; t < numberOfTriangles; t++) {
+			for (int k = 0; k < 3; k++) {
+				int vertex = triangles[3 * t + k];
+				trianglesOfVertex[vertex].push_back(t);
+				edgeUses[edgeKey(vertex, triangles[3 * t + (k + 1) % 3])]++;
+			}
+
+			// Triangles without area (e.g. at the collapsed edges of a patch) have no plane
+			Eigen::Vector3f normal = triangleNormal(t, -1, -1);
+			if (normal.norm() > 0.0f) {
+				normal.normalize();
+				for (int k = 0; k < 3; k++) {
+					quadrics[triangles[3 * t + k]].addPlane(normal, position(triangles[3 * t]));
+				}
+			}
+		}
+		for (int t = 0; t < numberOfTriangles; t++) {
+			for (int k = 0; k < 3; k++) {
+				int vertex = triangles[3 * t + k];
+				int next = triangles[3 * t + (k + 1) % 3];
+				if (edgeUses[edgeKey(vertex, next)] != 2) {
+					onBoundary[vertex] = onBoundary[next] = true;
+				}
+			}
+		}
+
+		for (int t = 0; t < numberOfTriangles; t++) {
+			for (int k = 0; k < 3; k++) {
+				int vertex = triangles[3 * t + k];
+				int next = triangles[3 * t + (k + 1) % 3];
+				// every interior edge is in two triangles; queue it only from one of them
+				if (vertex < next || edgeUses[edgeKey(vertex, next)] != 2) {
+					queueEdge(vertex, next);
+				}
+			}
+		}
+
+		int liveTriangles = numberOfTriangles;
+		while (liveTriangles > targetTriangles && !queueOfCollapses.empty()) {
+			EdgeCollapse collapse = queueOfCollapses.top();
+			queueOfCollapses.pop();
+			if (collapse.cost > maxCost) {
+				break;
+			}
+			if (collapse.fromVersion != versions[collapse.from] || collapse.toVersion != versions[collapse.to]
+					|| !canCollapse(collapse.from, collapse.to)) {
+				continue;
+			}
+			liveTriangles -= performCollapse(collapse.from, collapse.to);
+		}
+		return numberOfTriangles - liveTriangles;
+	}
+
+	static long long edgeKey(int first, int second) {
+		return first < second ? ((long long) first << 32) | (unsigned int) second : ((long long) second << 32) | (unsigned int) first;
+	}
+
+	// Queues the cheaper of the two collapses of the edge first - second (if either vertex may move at all)
+	void queueEdge(int first, int second) {
+		Quadric combined = quadrics[first];
+		combined.add(quadrics[second]);
+		bool firstMovable = !onBoundary[first];
+		bool secondMovable = !onBoundary[second];
+		if (!firstMovable && !secondMovable) {
+			return;
+		}
+		double firstIntoSecond = firstMovable ? combined.error(position(second)) : HUGE_VAL;
+		double secondIntoFirst = secondMovable ? combined.error(position(first)) : HUGE_VAL;
+		if (firstIntoSecond <= secondIntoFirst) {
+			queueOfCollapses.push(EdgeCollapse(fmax(firstIntoSecond, 0.0), first, second, versions[first], versions[second]));
+		} else {
+			queueOfCollapses.push(EdgeCollapse(fmax(secondIntoFirst, 0.0), second, first, versions[second], versions[first]));
+		}
+	}
+
+	// Vertices that share a live triangle with 'vertex'
+	void neighbours(int vertex, std::vector<int>& result) const {
+		result.clear();
+		for (std::vector<int>::size_type i = 0; i < trianglesOfVertex[vertex].size(); i++) {
+			int t = trianglesOfVertex[vertex][i];
+			for (int k = 0; k < 3; k++) {
+				int other = triangles[3 * t + k];
+				if (other != vertex && std::find(result.begin(), result.end(), other) == result.end()) {
+					result.push_back(other);
+				}
+			}
+		}
+	}
+
+
+	//****************************************************
+	// Whether 'from' can be moved onto 'to' without making the mesh non-manifold (the vertices the two have in common
+	// must be exactly the third corners of the triangles on their edge) or flipping (or flattening) any triangle
+	//***************************************************
+	bool canCollapse(int from, int to) const {
+		std::vector<int> fromNeighbours, toNeighbours;
+		neighbours(from, fromNeighbours);
+		neighbours(to, toNeighbours);
+
+		int sharedTriangles = 0;
+		for (std::vector<int>::size_type i = 0; i < trianglesOfVertex[from].size(); i++) {
+			int t = trianglesOfVertex[from][i];
+			if (triangles[3 * t] == to || triangles[3 * t + 1] == to || triangles[3 * t + 2] == to) {
+				sharedTriangles++;
+			}
+		}
+		int sharedNeighbours = 0;
+		for (std::vector<int>::size_type i = 0; i < fromNeighbours.size(); i++) {
+			if (std::find(toNeighbours.begin(), toNeighbours.end(), fromNeighbours[i]) != toNeighbours.end()) {
+				sharedNeighbours++;
+			}
+		}
+		if (sharedTriangles == 0 || sharedNeighbours != sharedTriangles) {
+			return false;
+		}
+
+		for (std::vector<int>::size_type i = 0; i < trianglesOfVertex[from].size(); i++) {
+			int t = trianglesOfVertex[from][i];
+			if (triangles[3 * t] == to || triangles[3 * t + 1] == to || triangles[3 * t + 2] == to) {
+				continue;
+			}
+			Eigen::Vector3f oldNormal = triangleNormal(t, -1, -1);
+			Eigen::Vector3f newNormal = triangleNormal(t, from, to);
+			float oldArea = oldNormal.norm();
+			if (oldArea == 0.0f) {
+				continue;
+			}
+			if (newNormal.dot(oldNormal) <= 0.2f * oldArea * newNormal.norm() || newNormal.norm() <= 1e-4f * oldArea) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	//****************************************************
+	// Moves 'from' onto 'to', removing the triangles on their edge, and requeues the edges around 'to'.
+	// Returns the number of triangles that were removed.
+	//***************************************************
+	int performCollapse(int from, int to) {
+		int removed = 0;
+		std::vector<int> fromTriangles = trianglesOfVertex[from];
+		for (std::vector<int>::size_type i = 0; i < fromTriangles.size(); i++) {
+			int t = fromTriangles[i];
+			bool onEdge = triangles[3 * t] == to || triangles[3 * t + 1] == to || triangles[3 * t + 2] == to;
+			if (onEdge) {
+				triangleRemoved[t] = true;
+				removed++;
+				for (int k = 0; k < 3; k++) {
+					std::vector<int>& list = trianglesOfVertex[triangles[3 * t + k]];
+					list.erase(std::remove(list.begin(), list.end(), t), list.end());
+				}
+			} else {
+				for (int k = 0; k < 3; k++) {
+					if (triangles[3 * t + k] == from) {
+						triangles[3 * t + k] = to;
+					}
+				}
+				trianglesOfVertex[to].push_back(t);
+			}
+		}
+		trianglesOfVertex[from].clear();
+		quadrics[to].add(quadrics[from]);
+
+		// Only the costs of the edges at 'to' changed (its quadric grew); everything else is checked again when popped
+		versions[from]++;
+		versions[to]++;
+		std::vector<int> toNeighbours;
+		neighbours(to, toNeighbours);
+		for (std::vector<int>::size_type i = 0; i < toNeighbours.size(); i++) {
+			queueEdge(to, toNeighbours[i]);
+		}
+		return removed;
+	}
+
+
+	// Replaces the patch's tessellation with the surviving vertices and triangles
+	void writeBack(BezierPatch& patch) {
+		std::vector<int> newIndex(vertices.size(), -1);
+		patch.listOfDifferentialGeometries.clear();
+		patch.listOfTriangles.clear();
+		patch.uniformSteps = 0;
+		for (std::vector<bool>::size_type t = 0; t < triangleRemoved.size(); t++) {
+			if (triangleRemoved[t]) {
+				continue;
+			}
+			for (int k = 0; k < 3; k++) {
+				int vertex = triangles[3 * t + k];
+				if (newIndex[vertex] < 0) {
+					newIndex[vertex] = patch.listOfDifferentialGeometries.size();
+					patch.listOfDifferentialGeometries.push_back(vertices[vertex]);
+				}
+			}
+			patch.addTriangle(vertices[triangles[3 * t]], vertices[triangles[3 * t + 1]], vertices[triangles[3 * t + 2]]);
+		}
+	}
+};
+
+
+#endif /* MESHDECIMATOR_H_ */
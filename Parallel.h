@@ -0,0 +1,70 @@
+/*
+ * Parallel.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <thread>
+#include <atomic>
+#include <vector>
+
+// Number of threads that parallel loops are spread over (at least 1)
+inline int numberOfWorkerThreads() {
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads == 0 ? 1 : (int) hardwareThreads;
+}
+
+
+//****************************************************
+// Splits [0, count) into 'numberOfChunks' contiguous chunks of (almost) equal size and calls
+// body(chunk, begin, end) for each of them, one thread per chunk.
+// Chunks are numbered in order, so results that are written per chunk can be concatenated in order afterwards.
+//***************************************************
+template <typename Body>
+void parallelForChunks(int count, int numberOfChunks, Body body) {
+	if (numberOfChunks <= 1 || count <= 1) {
+		for (int chunk = 0; chunk < numberOfChunks; chunk++) {
+			body(chunk, (int) ((long) count * chunk / numberOfChunks), (int) ((long) count * (chunk + 1) / numberOfChunks));
+		}
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	for (int chunk = 1; chunk < numberOfChunks; chunk++) {
+		threads.push_back(std::thread(body, chunk, (int) ((long) count * chunk / numberOfChunks),
+				(int) ((long) count * (chunk + 1) / numberOfChunks)));
+	}
+	// The calling thread works on the first chunk itself
+	body(0, 0, (int) ((long) count / numberOfChunks));
+
+	for (std::vector<std::thread>::size_type i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+}
+
+
+//****************************************************
+// Calls body(i) for every i in [0, count), spread over all worker threads.
+// Indices are handed out one at a time, so this balances well when iterations take very different amounts of time
+// (e.g. one iteration per patch or per image tile).
+//***************************************************
+template <typename Body>
+void parallelForEach(int count, Body body) {
+	std::atomic<int> nextIndex(0);
+	int numberOfThreads = numberOfWorkerThreads();
+	if (numberOfThreads > count) {
+		numberOfThreads = count;
+	}
+
+	parallelForChunks(numberOfThreads, numberOfThreads, [&](int, int, int) {
+		for (int i = nextIndex++; i < count; i = nextIndex++) {
+			body(i);
+		}
+	});
+}
+
+
+#endif /* PARALLEL_H_ */
@@ -0,0 +1,327 @@
+/*
+ * PatchRayTracer.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef PATCHRAYTRACER_H_
+#define PATCHRAYTRACER_H_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Result of intersecting a ray with the exact surface of a BezierPatch
+class PatchIntersection {
+	public:
+		// Ray parameter of the hit
+		float t;
+
+		// Index of the hit patch in the list of patches the tracer was built from
+		int patchIndex;
+
+		// Position, normal and (u, v) of the hit point
+		DifferentialGeometry differentialGeometry;
+};
+
+
+// Node of the ray tracing hierarchy. The top of the hierarchy groups whole patches; below the node that covers
+// a single patch, the hierarchy continues with that patch's subpatches (each split in half with de Casteljau),
+// so the whole thing is one binary BVH.
+class RayTracingNode {
+	public:
+		Eigen::Vector3f boxMin, boxMax;
+
+		// Index of the first child (the second child directly follows it), or -1 for a leaf subpatch
+		int firstChild;
+
+		// Patch that this node is a part of, or -1 for nodes that group several patches
+		int patchIndex;
+
+		// (u, v) rectangle covered by this node, if it is part of a patch
+		Eigen::Vector2f uvMin, uvMax;
+};
+
+
+//****************************************************
+// Intersects rays with the exact surfaces of a list of BezierPatches (not with their triangles): tensor product
+// patches, polynomial or rational, of degree up to BezierSubpatch::MAX_DEGREE in u and v. Triangular patches are not
+// supported (callers check with requireSubpatchDegrees).
+//
+// Candidate patches are found with a BVH over the patches' bounding boxes (which contain the surfaces, since every
+// patch lies in the convex hull of its control points). Inside a patch, the same BVH continues with a precomputed
+// tree of ever smaller subpatches, down to subpatches that are nearly flat. Each leaf subpatch that the ray reaches
+// is then solved exactly with Newton iteration on P(u, v) = position + t * direction, starting from the middle of the
+// subpatch. Where Newton cannot converge (at collapsed edges the derivatives vanish), the leaf's two triangles are used.
+//***************************************************
+class PatchRayTracer {
+	public:
+		const std::vector<BezierPatch>* patches;
+		std::vector<RayTracingNode> nodes;
+
+		// Most levels any leaf is below the root, which sizes the traversal stack
+		int depth;
+
+		// Leaf subpatches are flat to within this fraction of their size
+		float leafFlatness;
+		int maxSubpatchDepth;
+
+	PatchRayTracer() {
+		patches = NULL;
+		depth = 0;
+		leafFlatness = 0.05f;
+		maxSubpatchDepth = 12;
+	}
+
+
+	//****************************************************
+	// Builds the hierarchy for 'listOfPatches', which must outlive the tracer
+	//***************************************************
+	void build(const std::vector<BezierPatch>& listOfPatches) {
+		patches = &listOfPatches;
+		nodes.clear();
+		depth = 0;
+		if (listOfPatches.empty()) {
+			return;
+		}
+
+		std::vector<BezierSubpatch> roots;
+		std::vector<int> patchIndices;
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfPatches.size(); i++) {
+			roots.push_back(BezierSubpatch(listOfPatches[i].listOfCurves, listOfPatches[i].weights, i));
+			patchIndices.push_back(i);
+		}
+
+		nodes.push_back(RayTracingNode());
+		depth = buildPatchLevel(0, 0, roots, patchIndices, 0, patchIndices.size());
+	}
+
+
+	//****************************************************
+	// Fills in node 'nodeIndex', which is 'level' levels below the root, so that it covers the patches
+	// patchIndices[begin, end), splitting them in two halves (by the median of their box centers along the longest
+	// axis) until a node covers a single patch. Returns the level of the deepest leaf below it.
+	//***************************************************
+	int buildPatchLevel(int nodeIndex, int level, const std::vector<BezierSubpatch>& roots, std::vector<int>& patchIndices,
+			int begin, int end) {
+		if (end - begin == 1) {
+			return buildSubpatchLevel(nodeIndex, level, roots[patchIndices[begin]]);
+		}
+
+		Eigen::Vector3f boxMin, boxMax, patchMin, patchMax;
+		roots[patchIndices[begin]].boundingBox(boxMin, boxMax);
+		for (int i = begin + 1; i < end; i++) {
+			roots[patchIndices[i]].boundingBox(patchMin, patchMax);
+			boxMin = boxMin.cwiseMin(patchMin);
+			boxMax = boxMax.cwiseMax(patchMax);
+		}
+
+		int axis;
+		(boxMax - boxMin).maxCoeff(&axis);
+		int middle = (begin + end) / 2;
+		std::nth_element(patchIndices.begin() + begin, patchIndices.begin() + middle, patchIndices.begin() + end,
+				[&](int first, int second) {
+					const BezierSubpatch& firstRoot = roots[first];
+					const BezierSubpatch& secondRoot = roots[second];
+					return (firstRoot.point(0, 0)[axis] + firstRoot.point(firstRoot.degreeV, firstRoot.degreeU)[axis])
+							< (secondRoot.point(0, 0)[axis] + secondRoot.point(secondRoot.degreeV, secondRoot.degreeU)[axis]);
+				});
+
+		int firstChild = nodes.size();
+		nodes.push_back(RayTracingNode());
+		nodes.push_back(RayTracingNode());
+		int firstDepth = buildPatchLevel(firstChild, level + 1, roots, patchIndices, begin, middle);
+		int secondDepth = buildPatchLevel(firstChild + 1, level + 1, roots, patchIndices, middle, end);
+
+		RayTracingNode& node = nodes[nodeIndex];
+		node.boxMin = nodes[firstChild].boxMin.cwiseMin(nodes[firstChild + 1].boxMin);
+		node.boxMax = nodes[firstChild].boxMax.cwiseMax(nodes[firstChild + 1].boxMax);
+		node.firstChild = firstChild;
+		node.patchIndex = -1;
+		return std::max(firstDepth, secondDepth);
+	}
+
+
+	//****************************************************
+	// Fills in node 'nodeIndex', which is 'level' levels below the root, for 'subpatch', splitting it until it is
+	// nearly flat. Returns the level of the deepest leaf below it.
+	//***************************************************
+	int buildSubpatchLevel(int nodeIndex, int level, const BezierSubpatch& subpatch) {
+		Eigen::Vector3f boxMin, boxMax;
+		subpatch.boundingBox(boxMin, boxMax);
+
+		int firstChild = -1;
+		int deepestLevel = level;
+		if (subpatch.depth < maxSubpatchDepth && subpatch.canSplit()
+				&& subpatch.flatnessError() > leafFlatness * (boxMax - boxMin).norm()) {
+			BezierSubpatch firstHalf, secondHalf;
+			subpatch.split(firstHalf, secondHalf);
+			firstChild = nodes.size();
+			nodes.push_back(RayTracingNode());
+			nodes.push_back(RayTracingNode());
+			deepestLevel = std::max(buildSubpatchLevel(firstChild, level + 1, firstHalf),
+					buildSubpatchLevel(firstChild + 1, level + 1, secondHalf));
+		}
+
+		RayTracingNode& node = nodes[nodeIndex];
+		node.boxMin = boxMin;
+		node.boxMax = boxMax;
+		node.firstChild = firstChild;
+		node.patchIndex = subpatch.patchIndex;
+		node.uvMin = subpatch.uvMin;
+		node.uvMax = subpatch.uvMax;
+		return deepestLevel;
+	}
+
+
+	//****************************************************
+	// Finds the closest intersection of 'ray' with the patches. Returns false if there is none.
+	//***************************************************
+	bool intersect(const Ray& ray, PatchIntersection& closestHit) const {
+		if (nodes.empty()) {
+			return false;
+		}
+
+		Ray searchRay = ray;
+		Eigen::Vector3f inverseDirection = ray.direction.cwiseInverse();
+		bool hitSomething = false;
+		float tEntry;
+
+		TraversalStack stack(depth);
+		stack.push(0);
+
+		while (!stack.empty()) {
+			const RayTracingNode& node = nodes[stack.pop()];
+			if (!searchRay.hitsBox(node.boxMin, node.boxMax, inverseDirection, tEntry)) {
+				continue;
+			}
+
+			if (node.firstChild >= 0) {
+				stack.push(node.firstChild + 1);
+				stack.push(node.firstChild);
+				continue;
+			}
+
+			float t;
+			Eigen::Vector2f uv;
+			if (intersectLeaf(searchRay, node, t, uv)) {
+				hitSomething = true;
+				closestHit.t = t;
+				closestHit.patchIndex = node.patchIndex;
+				closestHit.differentialGeometry = (*patches)[node.patchIndex].evaluateDifferentialGeometry(uv.x(), uv.y());
+
+				// Only closer hits matter from now on
+				searchRay.t_max = t;
+			}
+		}
+		return hitSomething;
+	}
+
+
+	//****************************************************
+	// Intersects 'ray' with the part of a patch covered by leaf 'node' using Newton iteration on
+	// F(u, v, t) = P(u, v) - (position + t * direction). Falls back to the leaf's two triangles whenever that does not
+	// converge to a root inside the leaf.
+	//***************************************************
+	bool intersectLeaf(const Ray& ray, const RayTracingNode& node, float& t, Eigen::Vector2f& uv) const {
+		const BezierPatch& patch = (*patches)[node.patchIndex];
+		Eigen::Vector2f uvExtent = node.uvMax - node.uvMin;
+		// Close enough to the ray for this leaf's size, but not below what float positions can resolve
+		float tolerance = 1e-4f * (node.boxMax - node.boxMin).norm()
+				+ 8.0f * std::numeric_limits<float>::epsilon() * node.boxMax.cwiseAbs().cwiseMax(node.boxMin.cwiseAbs()).maxCoeff();
+
+		uv = (node.uvMin + node.uvMax) * 0.5f;
+		Eigen::Vector3f position, dPdu, dPdv;
+		patch.evaluatePartialDerivatives(uv.x(), uv.y(), position, dPdu, dPdv);
+		t = (position - ray.position).dot(ray.direction) / ray.direction.dot(ray.direction);
+
+		for (int iteration = 0; iteration < 8; iteration++) {
+			Eigen::Vector3f residual = position - ray.pointAt(t);
+			if (residual.norm() < tolerance) {
+				// Accept the root only if it lies in this leaf (give or take a little, so that no ray slips between leaves)
+				Eigen::Vector2f slack = 1e-3f * uvExtent;
+				if ((uv.array() >= (node.uvMin - slack).array()).all() && (uv.array() <= (node.uvMax + slack).array()).all()
+						&& t >= ray.t_min && t <= ray.t_max) {
+					uv = uv.cwiseMax(Eigen::Vector2f::Zero()).cwiseMin(Eigen::Vector2f::Ones());
+					return true;
+				}
+				// Converged outside the leaf (or the ray's range), which near silhouettes does not rule out a hit inside it
+				break;
+			}
+
+			Eigen::Matrix3f jacobian;
+			jacobian.col(0) = dPdu;
+			jacobian.col(1) = dPdv;
+			jacobian.col(2) = -ray.direction;
+			float determinant = jacobian.determinant();
+			if (fabs(determinant) < 1e-12f) {
+				break;
+			}
+
+			Eigen::Vector3f step = jacobian.inverse() * residual;
+			uv -= step.head<2>();
+			t -= step.z();
+
+			// Heading this far outside the leaf, Newton will not find a root inside it; let the triangles decide
+			if ((uv.array() < (node.uvMin - uvExtent).array()).any() || (uv.array() > (node.uvMax + uvExtent).array()).any()) {
+				break;
+			}
+			patch.evaluatePartialDerivatives(uv.x(), uv.y(), position, dPdu, dPdv);
+		}
+
+		return intersectLeafTriangles(ray, node, t, uv);
+	}
+
+
+	//****************************************************
+	// Intersects 'ray' with the triangles (top right, top left, bottom left) and (top right, bottom left, bottom right)
+	// spanned by the corners of leaf 'node', which is nearly flat, and reports the (u, v) of the hit
+	//***************************************************
+	bool intersectLeafTriangles(const Ray& ray, const RayTracingNode& node, float& t, Eigen::Vector2f& uv) const {
+		const BezierPatch& patch = (*patches)[node.patchIndex];
+		Eigen::Vector2f cornerUVs[4] = {
+				Eigen::Vector2f(node.uvMax.x(), node.uvMin.y()),	// top right
+				node.uvMin,											// top left
+				Eigen::Vector2f(node.uvMin.x(), node.uvMax.y()),	// bottom left
+				node.uvMax };										// bottom right
+		Eigen::Vector3f corners[4], dPdu, dPdv;
+		for (int i = 0; i < 4; i++) {
+			patch.evaluatePartialDerivatives(cornerUVs[i].x(), cornerUVs[i].y(), corners[i], dPdu, dPdv);
+		}
+
+		int triangles[2][3] = {{0, 1, 2}, {0, 2, 3}};
+		bool hit = false;
+		float closestT = ray.t_max;
+		for (int i = 0; i < 2; i++) {
+			const Eigen::Vector3f& a = corners[triangles[i][0]];
+			const Eigen::Vector3f& b = corners[triangles[i][1]];
+			const Eigen::Vector3f& c = corners[triangles[i][2]];
+
+			// Moller-Trumbore
+			Eigen::Vector3f edge1 = b - a, edge2 = c - a;
+			Eigen::Vector3f p = ray.direction.cross(edge2);
+			float determinant = edge1.dot(p);
+			if (fabs(determinant) < 1e-20f) {
+				continue;
+			}
+			Eigen::Vector3f fromA = ray.position - a;
+			float beta = fromA.dot(p) / determinant;
+			Eigen::Vector3f q = fromA.cross(edge1);
+			float gamma = ray.direction.dot(q) / determinant;
+			float triangleT = edge2.dot(q) / determinant;
+			if (beta < 0.0f || gamma < 0.0f || beta + gamma > 1.0f || triangleT < ray.t_min || triangleT > closestT) {
+				continue;
+			}
+
+			hit = true;
+			closestT = triangleT;
+			uv = (1.0f - beta - gamma) * cornerUVs[triangles[i][0]] + beta * cornerUVs[triangles[i][1]] + gamma * cornerUVs[triangles[i][2]];
+		}
+		t = closestT;
+		return hit;
+	}
+};
+
+
+#endif /* PATCHRAYTRACER_H_ */
@@ -0,0 +1,92 @@
+/*
+ * PatchRetessellator.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef PATCHRETESSELLATOR_H_
+#define PATCHRETESSELLATOR_H_
+
+#include <vector>
+#include <map>
+#include <utility>
+
+//****************************************************
+// Brings tessellations up to date after their patches' control points moved, without changing their topology: every
+// point of a patch is re-evaluated at its own (u, v), and the triangles are rebuilt from the patch's index buffer, so
+// only positions and normals change.
+//
+// Uniform grids of polynomial tensor product patches are evaluated from BasisTable's, shared by all patches with the
+// same degree and grid. prepare() builds the tables a patch needs (and its index buffer); after that, retessellate()
+// only reads the tables, so it may run for many patches in parallel.
+//***************************************************
+class PatchRetessellator {
+	public:
+
+	PatchRetessellator() {
+
+	}
+
+	// Builds what retessellate() will need for 'patch' (not thread safe)
+	void prepare(BezierPatch& patch) {
+		if (patch.indices.size() != 3 * patch.listOfTriangles.size()) {
+			patch.buildIndices();
+		}
+		float stepSize;
+		if (usesGrid(patch, stepSize)) {
+			table(patch.degreeU(), patch.uniformSteps, stepSize);
+			table(patch.degreeV(), patch.uniformSteps, stepSize);
+		}
+	}
+
+	// Re-evaluates the positions and normals of the patch's tessellation (prepare() must have been called for it)
+	void retessellate(BezierPatch& patch) const {
+		std::vector<DifferentialGeometry>& points = patch.listOfDifferentialGeometries;
+		std::vector<DifferentialGeometry>::size_type firstOtherPoint = 0;
+
+		float stepSize;
+		if (usesGrid(patch, stepSize)) {
+			patch.evaluateUniformGrid(findTable(patch.degreeU(), patch.uniformSteps, stepSize),
+					findTable(patch.degreeV(), patch.uniformSteps, stepSize));
+			firstOtherPoint = (patch.uniformSteps + 1) * (patch.uniformSteps + 1);
+		}
+
+		// Points that are not part of a grid (adaptive or decimated tessellations, rational and triangular patches)
+		for (std::vector<DifferentialGeometry>::size_type i = firstOtherPoint; i < points.size(); i++) {
+			points[i] = patch.evaluateDifferentialGeometry(points[i].uvValues.x(), points[i].uvValues.y());
+		}
+		patch.trianglesFromIndices();
+	}
+
+
+	private:
+		std::map<std::pair<int, std::pair<int, float> >, BasisTable> tables;
+
+	// Whether the patch's first points are a uniform grid that BasisTable's can evaluate, and its step size
+	static bool usesGrid(const BezierPatch& patch, float& stepSize) {
+		int numberOfSteps = patch.uniformSteps;
+		if (numberOfSteps <= 0 || patch.triangular || patch.isRational()
+				|| patch.listOfDifferentialGeometries.size() < (size_t) ((numberOfSteps + 1) * (numberOfSteps + 1))) {
+			return false;
+		}
+		// Point (1, 0) of the grid sits at (u, v) = (stepSize, 0)
+		stepSize = patch.listOfDifferentialGeometries[numberOfSteps + 1].uvValues.x();
+		return true;
+	}
+
+	const BasisTable& table(int degree, int numberOfSteps, float stepSize) {
+		std::pair<int, std::pair<int, float> > key(degree, std::make_pair(numberOfSteps, stepSize));
+		std::map<std::pair<int, std::pair<int, float> >, BasisTable>::iterator existing = tables.find(key);
+		if (existing == tables.end()) {
+			existing = tables.insert(std::make_pair(key, BasisTable(degree, numberOfSteps, stepSize))).first;
+		}
+		return existing->second;
+	}
+
+	const BasisTable& findTable(int degree, int numberOfSteps, float stepSize) const {
+		return tables.find(std::make_pair(degree, std::make_pair(numberOfSteps, stepSize)))->second;
+	}
+};
+
+
+#endif /* PATCHRETESSELLATOR_H_ */
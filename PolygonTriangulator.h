@@ -0,0 +1,119 @@
+/*
+ * PolygonTriangulator.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef POLYGONTRIANGULATOR_H_
+#define POLYGONTRIANGULATOR_H_
+
+#include <vector>
+#include <cmath>
+
+//****************************************************
+// Splits simple polygons (convex or not, such as the faces of .obj files) into triangles by ear clipping.
+//
+// The polygon is projected onto the coordinate plane most parallel to it (the one its Newell normal is most
+// perpendicular to). A corner is an ear when it turns the same way as the polygon as a whole and no other remaining
+// corner lies inside the triangle it forms with its two neighbors; ears are cut off one at a time until a single
+// triangle is left. O(n^2) for n corners, but faces rarely have more than a handful, and triangles are passed
+// through as they are. Degenerate polygons (where no ear can be found) fall back to cutting off any corner.
+//***************************************************
+class PolygonTriangulator {
+	public:
+
+	// Appends the triangles of 'polygon' to 'triangles', as three indices into 'polygon' each, with the
+	// polygon's winding
+	static void triangulate(const std::vector<Eigen::Vector3f>& polygon, std::vector<int>& triangles) {
+		int numberOfCorners = polygon.size();
+		if (numberOfCorners < 3) {
+			return;
+		}
+		if (numberOfCorners == 3) {
+			triangles.push_back(0);
+			triangles.push_back(1);
+			triangles.push_back(2);
+			return;
+		}
+
+		// Newell normal of the polygon, and the two axes of the plane it is projected onto
+		Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+		for (int i = 0; i < numberOfCorners; i++) {
+			const Eigen::Vector3f& current = polygon[i];
+			const Eigen::Vector3f& next = polygon[(i + 1) % numberOfCorners];
+			normal += Eigen::Vector3f((current.y() - next.y()) * (current.z() + next.z()),
+					(current.z() - next.z()) * (current.x() + next.x()), (current.x() - next.x()) * (current.y() + next.y()));
+		}
+		int dropped;
+		normal.cwiseAbs().maxCoeff(&dropped);
+		int axisX = (dropped + 1) % 3, axisY = (dropped + 2) % 3;
+
+		// Seen from the side the projection looks at, counterclockwise polygons have a positive normal component
+		float orientation = normal[dropped] < 0.0f ? -1.0f : 1.0f;
+		std::vector<Eigen::Vector2f> points(numberOfCorners);
+		for (int i = 0; i < numberOfCorners; i++) {
+			points[i] = Eigen::Vector2f(polygon[i][axisX], orientation * polygon[i][axisY]);
+		}
+
+		// Remaining corners, as a circular doubly linked list
+		std::vector<int> previous(numberOfCorners), next(numberOfCorners);
+		for (int i = 0; i < numberOfCorners; i++) {
+			previous[i] = (i + numberOfCorners - 1) % numberOfCorners;
+			next[i] = (i + 1) % numberOfCorners;
+		}
+
+		int corner = 0, remaining = numberOfCorners, cornersTried = 0;
+		while (remaining > 3) {
+			bool ear = isEar(points, previous, next, corner, remaining);
+			if (ear || cornersTried >= remaining) {
+				triangles.push_back(previous[corner]);
+				triangles.push_back(corner);
+				triangles.push_back(next[corner]);
+				next[previous[corner]] = next[corner];
+				previous[next[corner]] = previous[corner];
+				remaining--;
+				cornersTried = 0;
+				corner = previous[corner];
+			} else {
+				cornersTried++;
+				corner = next[corner];
+			}
+		}
+		triangles.push_back(previous[corner]);
+		triangles.push_back(corner);
+		triangles.push_back(next[corner]);
+	}
+
+
+	private:
+
+	// Twice the signed area of triangle (a, b, c): positive if it is counterclockwise
+	static float signedArea(const Eigen::Vector2f& a, const Eigen::Vector2f& b, const Eigen::Vector2f& c) {
+		return (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+	}
+
+	static bool isEar(const std::vector<Eigen::Vector2f>& points, const std::vector<int>& previous,
+			const std::vector<int>& next, int corner, int remaining) {
+		const Eigen::Vector2f& a = points[previous[corner]];
+		const Eigen::Vector2f& b = points[corner];
+		const Eigen::Vector2f& c = points[next[corner]];
+		if (signedArea(a, b, c) <= 0.0f) {
+			return false;
+		}
+
+		// No other corner may lie inside (or on the border of) the ear
+		for (int other = next[next[corner]], k = 0; k < remaining - 3; other = next[other], k++) {
+			const Eigen::Vector2f& p = points[other];
+			if (p == a || p == b || p == c) {
+				continue;
+			}
+			if (signedArea(a, b, p) >= 0.0f && signedArea(b, c, p) >= 0.0f && signedArea(c, a, p) >= 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+
+#endif /* POLYGONTRIANGULATOR_H_ */
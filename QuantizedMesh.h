@@ -0,0 +1,176 @@
+/*
+ * QuantizedMesh.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef QUANTIZEDMESH_H_
+#define QUANTIZEDMESH_H_
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// One vertex of a QuantizedMesh: 14 bytes instead of the 32 of a DifferentialGeometry
+struct QuantizedVertex {
+	// Position within the mesh's bounding box, in 1/65535ths of its extent along each axis
+	unsigned short position[3];
+
+	// Octahedral encoding of the unit normal (see QuantizedMesh::encodeNormal), as 16-bit signed fractions
+	short normal[2];
+
+	// (u, v) in 1/65535ths (patch parameters lie in [0, 1])
+	unsigned short uvValues[2];
+};
+
+
+// Largest differences between a mesh's points and what its quantized vertices decode to
+struct QuantizationError {
+	float position, normalDegrees, uv;
+
+	QuantizationError() {
+		position = normalDegrees = uv = 0.0f;
+	}
+
+	void add(const QuantizationError& other) {
+		position = std::max(position, other.position);
+		normalDegrees = std::max(normalDegrees, other.normalDegrees);
+		uv = std::max(uv, other.uv);
+	}
+};
+
+
+// A table of points (DifferentialGeometries) stored as QuantizedVertex's relative to the table's bounding box
+class QuantizedMesh {
+	public:
+		// Corner and size of the bounding box of the encoded positions
+		float origin[3], extent[3];
+
+		std::vector<QuantizedVertex> vertices;
+
+	QuantizedMesh() {
+		for (int axis = 0; axis < 3; axis++) {
+			origin[axis] = extent[axis] = 0.0f;
+		}
+	}
+
+	// Replaces the table with 'points', quantized relative to their bounding box
+	void encode(const std::vector<DifferentialGeometry>& points) {
+		setBounds(points);
+		vertices.resize(points.size());
+		for (std::vector<DifferentialGeometry>::size_type i = 0; i < points.size(); i++) {
+			vertices[i] = encodeVertex(points[i]);
+		}
+	}
+
+	// Decodes the whole table into 'points'
+	void decode(std::vector<DifferentialGeometry>& points) const {
+		points.resize(vertices.size());
+		for (std::vector<QuantizedVertex>::size_type i = 0; i < vertices.size(); i++) {
+			points[i] = decodeVertex(vertices[i]);
+		}
+	}
+
+	void setBounds(const std::vector<DifferentialGeometry>& points) {
+		for (int axis = 0; axis < 3; axis++) {
+			float lowest = HUGE_VALF, highest = -HUGE_VALF;
+			for (std::vector<DifferentialGeometry>::size_type i = 0; i < points.size(); i++) {
+				lowest = std::min(lowest, points[i].position[axis]);
+				highest = std::max(highest, points[i].position[axis]);
+			}
+			origin[axis] = points.empty() ? 0.0f : lowest;
+			extent[axis] = points.empty() ? 0.0f : highest - lowest;
+		}
+	}
+
+	QuantizedVertex encodeVertex(const DifferentialGeometry& point) const {
+		QuantizedVertex vertex;
+		for (int axis = 0; axis < 3; axis++) {
+			float fraction = extent[axis] > 0.0f ? (point.position[axis] - origin[axis]) / extent[axis] : 0.0f;
+			vertex.position[axis] = encodeUnsigned(fraction);
+		}
+		encodeNormal(point.normal, vertex.normal);
+		vertex.uvValues[0] = encodeUnsigned(point.uvValues.x());
+		vertex.uvValues[1] = encodeUnsigned(point.uvValues.y());
+		return vertex;
+	}
+
+	DifferentialGeometry decodeVertex(const QuantizedVertex& vertex) const {
+		const float scale = 1.0f / 65535.0f;
+		Eigen::Vector3f position(origin[0] + extent[0] * (vertex.position[0] * scale),
+				origin[1] + extent[1] * (vertex.position[1] * scale), origin[2] + extent[2] * (vertex.position[2] * scale));
+		return DifferentialGeometry(position, decodeNormal(vertex.normal),
+				Eigen::Vector2f(vertex.uvValues[0] * scale, vertex.uvValues[1] * scale));
+	}
+
+	// Largest differences between 'points' and the decoded vertices (the table must have been encoded from them)
+	QuantizationError measureError(const std::vector<DifferentialGeometry>& points) const {
+		QuantizationError error;
+		for (std::vector<DifferentialGeometry>::size_type i = 0; i < points.size(); i++) {
+			DifferentialGeometry decoded = decodeVertex(vertices[i]);
+			error.position = std::max(error.position, (decoded.position - points[i].position).norm());
+			error.uv = std::max(error.uv, (decoded.uvValues - points[i].uvValues).cwiseAbs().maxCoeff());
+			if (points[i].normal.squaredNorm() > 0.0f) {
+				// (atan2 stays accurate for tiny angles, where acos of a float cosine does not)
+				Eigen::Vector3f normal = points[i].normal.normalized();
+				float angle = atan2(decoded.normal.cross(normal).norm(), decoded.normal.dot(normal));
+				error.normalDegrees = std::max(error.normalDegrees, (float) (angle * 180.0 / M_PI));
+			}
+		}
+		return error;
+	}
+
+
+	//****************************************************
+	// Octahedral normal encoding (Cigolle et al., "A Survey of Efficient Representations for Independent Unit
+	// Vectors", 2014): the unit normal is projected onto the octahedron |x| + |y| + |z| = 1, whose lower half is
+	// folded over the upper one, and the resulting point of the square [-1, 1]^2 is stored as two 16-bit fractions.
+	// The largest error is about 0.005 degrees. Zero normals decode to (0, 0, 1).
+	//***************************************************
+	static void encodeNormal(const Eigen::Vector3f& normal, short* encoded) {
+		float length = fabs(normal.x()) + fabs(normal.y()) + fabs(normal.z());
+		float x = 0.0f, y = 0.0f;
+		if (length > 0.0f) {
+			x = normal.x() / length;
+			y = normal.y() / length;
+			if (normal.z() < 0.0f) {
+				float foldedX = (1.0f - fabs(y)) * signNotZero(x);
+				y = (1.0f - fabs(x)) * signNotZero(y);
+				x = foldedX;
+			}
+		}
+		encoded[0] = encodeSigned(x);
+		encoded[1] = encodeSigned(y);
+	}
+
+	static Eigen::Vector3f decodeNormal(const short* encoded) {
+		float x = std::max(encoded[0] / 32767.0f, -1.0f);
+		float y = std::max(encoded[1] / 32767.0f, -1.0f);
+		float z = 1.0f - fabs(x) - fabs(y);
+		if (z < 0.0f) {
+			float unfoldedX = (1.0f - fabs(y)) * signNotZero(x);
+			y = (1.0f - fabs(x)) * signNotZero(y);
+			x = unfoldedX;
+		}
+		return Eigen::Vector3f(x, y, z).normalized();
+	}
+
+
+	private:
+
+	static float signNotZero(float value) {
+		return value < 0.0f ? -1.0f : 1.0f;
+	}
+
+	// [0, 1] -> [0, 65535] and [-1, 1] -> [-32767, 32767], rounding to the nearest step
+	static unsigned short encodeUnsigned(float value) {
+		return (unsigned short) floor(std::max(0.0f, std::min(1.0f, value)) * 65535.0f + 0.5f);
+	}
+
+	static short encodeSigned(float value) {
+		return (short) floor(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f + 0.5f);
+	}
+};
+
+
+#endif /* QUANTIZEDMESH_H_ */
@@ -0,0 +1,44 @@
+/*
+ * Ray.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef RAY_H_
+#define RAY_H_
+
+// A ray position + t * direction, for t between t_min and t_max
+class Ray {
+	public:
+		Eigen::Vector3f position, direction;
+		float t_min, t_max;
+
+	Ray() {
+
+	}
+
+	Ray(const Eigen::Vector3f& position, const Eigen::Vector3f& direction, float t_min, float t_max) {
+		this->position = position;
+		this->direction = direction;
+		this->t_min = t_min;
+		this->t_max = t_max;
+	}
+
+	Eigen::Vector3f pointAt(float t) const {
+		return position + t * direction;
+	}
+
+	// Slab test against an axis-aligned box; 'inverseDirection' is 1 / direction, computed once per ray.
+	// Returns whether the ray enters the box before t_max, and if so where ('tEntry').
+	bool hitsBox(const Eigen::Vector3f& boxMin, const Eigen::Vector3f& boxMax, const Eigen::Vector3f& inverseDirection, float& tEntry) const {
+		Eigen::Vector3f t1 = (boxMin - position).cwiseProduct(inverseDirection);
+		Eigen::Vector3f t2 = (boxMax - position).cwiseProduct(inverseDirection);
+		float tNear = fmax(t_min, t1.cwiseMin(t2).maxCoeff());
+		float tFar = fmin(t_max, t1.cwiseMax(t2).minCoeff());
+		tEntry = tNear;
+		return tNear <= tFar;
+	}
+};
+
+
+#endif /* RAY_H_ */
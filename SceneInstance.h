@@ -0,0 +1,112 @@
+/*
+ * SceneInstance.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SCENEINSTANCE_H_
+#define SCENEINSTANCE_H_
+
+#include <string>
+#include <cmath>
+
+// One input file (.bez or .obj) of the scene. Its geometry is loaded and tessellated only once, into a contiguous
+// range of the scene's list of Bezier patches (or of .obj polygons), no matter how many instances use it.
+class SceneAsset {
+	public:
+		std::string filename;
+		bool objMode;
+
+		// Range [firstPatch, firstPatch + numberOfPatches) of listOfBezierPatches, for .bez files
+		int firstPatch, numberOfPatches;
+
+		// Range [firstPolygon, firstPolygon + numberOfPolygons) of objFilePolygonStarts (the faces), for .obj files, the range of
+		// their triangles in objFileTriangles (three indices each), the range of their outlines in objFileOutlines, and the
+		// range of their vertices in objFileVertices (and objFileNormals)
+		int firstPolygon, numberOfPolygons;
+		int firstObjTriangle, numberOfObjTriangles;
+		int firstOutlineIndex, numberOfOutlineIndices;
+		int firstObjVertex, numberOfObjVertices;
+
+		// Key of the asset's tessellation in the on-disk tessellation cache (empty if it is not cached),
+		// and whether the tessellation was loaded from there (so the patches are already tessellated)
+		std::string cacheKey;
+		bool loadedFromCache;
+
+	SceneAsset() {
+		objMode = false;
+		firstPatch = numberOfPatches = firstPolygon = numberOfPolygons = 0;
+		firstObjTriangle = numberOfObjTriangles = firstOutlineIndex = numberOfOutlineIndices = 0;
+		firstObjVertex = numberOfObjVertices = 0;
+		loadedFromCache = false;
+	}
+};
+
+
+// One placement of a SceneAsset in the scene: the asset's geometry, transformed by (linear, translation)
+class SceneInstance {
+	public:
+		int assetIndex;
+
+		// The affine transformation p -> linear * p + translation
+		Eigen::Matrix3f linear;
+		Eigen::Vector3f translation;
+
+		// Transforms normals (the inverse transpose of 'linear')
+		Eigen::Matrix3f normalMatrix;
+
+	// An instance that places the asset as it is
+	SceneInstance(int assetIndex) {
+		this->assetIndex = assetIndex;
+		linear = normalMatrix = Eigen::Matrix3f::Identity();
+		translation = Eigen::Vector3f::Zero();
+	}
+
+	// The following apply one more transformation after the ones that are already there
+	void translate(const Eigen::Vector3f& offset) {
+		translation += offset;
+	}
+
+	// Rotates by 'angle' degrees around 'axis' (like glRotatef)
+	void rotate(float angle, const Eigen::Vector3f& axis) {
+		Eigen::Matrix3f rotation = Eigen::AngleAxisf(angle * M_PI / 180.0f, axis.normalized()).toRotationMatrix();
+		linear = rotation * linear;
+		translation = rotation * translation;
+		normalMatrix = linear.inverse().transpose();
+	}
+
+	void scale(const Eigen::Vector3f& factors) {
+		linear = factors.asDiagonal() * linear;
+		translation = translation.cwiseProduct(factors);
+		normalMatrix = linear.inverse().transpose();
+	}
+
+	bool isIdentity() const {
+		return linear.isIdentity() && translation.isZero();
+	}
+
+	Eigen::Vector3f transformPoint(const Eigen::Vector3f& point) const {
+		return linear * point + translation;
+	}
+
+	Eigen::Vector3f transformNormal(const Eigen::Vector3f& normal) const {
+		return (normalMatrix * normal).normalized();
+	}
+
+	// The transformation as a column-major 4 x 4 matrix, for glMultMatrixf
+	void openGLMatrix(float* matrix) const {
+		for (int column = 0; column < 3; column++) {
+			for (int row = 0; row < 3; row++) {
+				matrix[4 * column + row] = linear(row, column);
+			}
+			matrix[4 * column + 3] = 0.0f;
+		}
+		for (int row = 0; row < 3; row++) {
+			matrix[12 + row] = translation[row];
+		}
+		matrix[15] = 1.0f;
+	}
+};
+
+
+#endif /* SCENEINSTANCE_H_ */
@@ -0,0 +1,525 @@
+/*
+ * SoftwareRasterizer.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SOFTWARERASTERIZER_H_
+#define SOFTWARERASTERIZER_H_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+// One triangle handed to the SoftwareRasterizer, in object coordinates
+class RasterTriangle {
+	public:
+		Eigen::Vector3f positions[3];
+		Eigen::Vector3f normals[3];
+
+		// Bit i is set if the edge from vertex i to vertex (i + 1) % 3 is drawn in wireframe and hidden-line mode.
+		// Triangles that were cut out of a larger polygon clear the bits of their interior edges, like glEdgeFlag().
+		int edgeFlags;
+
+	RasterTriangle() {
+
+	}
+
+	RasterTriangle(const DifferentialGeometry& point1, const DifferentialGeometry& point2, const DifferentialGeometry& point3) {
+		positions[0] = point1.position;
+		positions[1] = point2.position;
+		positions[2] = point3.position;
+		normals[0] = point1.normal;
+		normals[1] = point2.normal;
+		normals[2] = point3.normal;
+		edgeFlags = 7;
+	}
+};
+
+
+// A triangle after lighting, clipping and projection: x and y in pixels (y pointing down), z is window depth in [0, 1]
+class ScreenTriangle {
+	public:
+		Eigen::Vector3f positions[3];
+
+		// 1 / w of each vertex, for perspective-correct color interpolation
+		float inverseW[3];
+
+		Eigen::Vector3f colors[3];
+
+		// Color used in flat shading mode (that of the polygon's first vertex, which is what OpenGL uses for GL_POLYGON)
+		Eigen::Vector3f flatColor;
+
+		int edgeFlags;
+
+		// Pixel bounding box
+		int minX, minY, maxX, maxY;
+};
+
+
+//****************************************************
+// CPU-only renderer that reproduces what myDisplay() draws with OpenGL (z-buffer, the lights set up in initScene(),
+// flat / smooth shading, wireframe and hidden-line modes), so images can be rendered without a window.
+//
+// The image is cut into square tiles. Triangles are first lit and projected in parallel, then binned into the tiles
+// they overlap, and finally every tile is rasterized on its own by whichever worker thread picks it up.
+//***************************************************
+class SoftwareRasterizer {
+	public:
+		int width, height;
+
+		// RGB, 8 bits per channel, top row first
+		std::vector<unsigned char> colorBuffer;
+		std::vector<float> depthBuffer;
+
+		// Same meaning as the global display flags in scene.cpp
+		bool SMOOTH_SHADING;
+		bool WIREFRAME_MODE;
+		bool HIDDEN_LINE_MODE;
+
+		Eigen::Matrix4f modelView, projection;
+
+		// Fixed-function lighting: global ambient light and up to two lights, given in eye coordinates
+		// (position w = 0 means a directional light)
+		Eigen::Vector3f globalAmbientColor;
+		Eigen::Vector3f lightColors[2];
+		Eigen::Vector4f lightPositions[2];
+		int numberOfLights;
+
+		// OpenGL's default material, which is what the viewer uses
+		Eigen::Vector3f materialAmbient, materialDiffuse;
+
+		std::vector<RasterTriangle> triangles;
+
+		static const int TILE_SIZE = 32;
+
+	SoftwareRasterizer(int width, int height) {
+		this->width = width;
+		this->height = height;
+		SMOOTH_SHADING = true;
+		WIREFRAME_MODE = true;
+		HIDDEN_LINE_MODE = false;
+		modelView = projection = Eigen::Matrix4f::Identity();
+		globalAmbientColor = Eigen::Vector3f(0.2f, 0.2f, 0.2f);
+		numberOfLights = 0;
+		materialAmbient = Eigen::Vector3f(0.2f, 0.2f, 0.2f);
+		materialDiffuse = Eigen::Vector3f(0.8f, 0.8f, 0.8f);
+	}
+
+	void setGlobalAmbientColor(const float* color) {
+		globalAmbientColor = Eigen::Vector3f(color[0], color[1], color[2]);
+	}
+
+	void addLight(const float* color, const float* position) {
+		if (numberOfLights < 2) {
+			lightColors[numberOfLights] = Eigen::Vector3f(color[0], color[1], color[2]);
+			lightPositions[numberOfLights] = Eigen::Vector4f(position[0], position[1], position[2], position[3]);
+			numberOfLights++;
+		}
+	}
+
+	void addTriangle(const RasterTriangle& triangle) {
+		triangles.push_back(triangle);
+	}
+
+
+	//****************************************************
+	// Fixed-function (per-vertex) lighting of an eye-space point
+	//***************************************************
+	Eigen::Vector3f shade(const Eigen::Vector3f& eyePosition, const Eigen::Vector3f& eyeNormal) const {
+		Eigen::Vector3f color = globalAmbientColor.cwiseProduct(materialAmbient);
+		for (int i = 0; i < numberOfLights; i++) {
+			Eigen::Vector3f toLight = (lightPositions[i].w() == 0.0f) ? Eigen::Vector3f(lightPositions[i].head<3>())
+					: Eigen::Vector3f(lightPositions[i].head<3>() - eyePosition);
+			toLight.normalize();
+			float diffuseFactor = eyeNormal.dot(toLight);
+			if (diffuseFactor > 0.0f) {
+				color += diffuseFactor * lightColors[i].cwiseProduct(materialDiffuse);
+			}
+		}
+		return color.cwiseMax(Eigen::Vector3f::Zero()).cwiseMin(Eigen::Vector3f::Ones());
+	}
+
+
+	//****************************************************
+	// Lights, clips (against the near plane) and projects one triangle, appending the result(s) to 'output'
+	//***************************************************
+	void processTriangle(const RasterTriangle& triangle, std::vector<ScreenTriangle>& output) const {
+		Eigen::Vector4f clipPositions[3];
+		Eigen::Vector3f colors[3];
+		bool lit = !WIREFRAME_MODE;
+		Eigen::Matrix3f normalMatrix = modelView.block<3, 3>(0, 0);
+
+		for (int i = 0; i < 3; i++) {
+			Eigen::Vector4f eyePosition = modelView * Eigen::Vector4f(triangle.positions[i].x(), triangle.positions[i].y(), triangle.positions[i].z(), 1.0f);
+			clipPositions[i] = projection * eyePosition;
+			colors[i] = lit ? shade(eyePosition.head<3>(), normalMatrix * triangle.normals[i]) : Eigen::Vector3f::Ones();
+		}
+		Eigen::Vector3f flatColor = colors[0];
+
+		// Sutherland-Hodgman against the near plane (z > -w); the triangle becomes a polygon of up to four vertices
+		Eigen::Vector4f polygon[4];
+		Eigen::Vector3f polygonColors[4];
+		int polygonEdgeFlags[4];
+		int numberOfVertices = 0;
+		for (int i = 0; i < 3; i++) {
+			int next = (i + 1) % 3;
+			float distance = clipPositions[i].z() + clipPositions[i].w();
+			float nextDistance = clipPositions[next].z() + clipPositions[next].w();
+			bool edgeFlag = (triangle.edgeFlags >> i) & 1;
+
+			if (distance >= 0.0f) {
+				polygon[numberOfVertices] = clipPositions[i];
+				polygonColors[numberOfVertices] = colors[i];
+				polygonEdgeFlags[numberOfVertices] = edgeFlag;
+				numberOfVertices++;
+			}
+			if ((distance >= 0.0f) != (nextDistance >= 0.0f)) {
+				float t = distance / (distance - nextDistance);
+				polygon[numberOfVertices] = clipPositions[i] + t * (clipPositions[next] - clipPositions[i]);
+				polygonColors[numberOfVertices] = colors[i] + t * (colors[next] - colors[i]);
+				// The new edge along the near plane is never drawn as a line; the rest of a cut edge keeps its flag
+				polygonEdgeFlags[numberOfVertices] = (distance >= 0.0f) ? 0 : edgeFlag;
+				numberOfVertices++;
+			}
+		}
+
+		// Fan-triangulate the clipped polygon
+		for (int i = 1; i + 1 < numberOfVertices; i++) {
+			int corners[3] = {0, i, i + 1};
+			ScreenTriangle screenTriangle;
+			screenTriangle.flatColor = flatColor;
+			screenTriangle.edgeFlags = 0;
+			if (i == 1 && polygonEdgeFlags[0]) { screenTriangle.edgeFlags |= 1; }
+			if (polygonEdgeFlags[i]) { screenTriangle.edgeFlags |= 2; }
+			if (i + 2 == numberOfVertices && polygonEdgeFlags[i + 1]) { screenTriangle.edgeFlags |= 4; }
+
+			float minX = std::numeric_limits<float>::max(), minY = minX;
+			float maxX = -minX, maxY = -minX;
+			for (int k = 0; k < 3; k++) {
+				const Eigen::Vector4f& clipPosition = polygon[corners[k]];
+				float inverseW = 1.0f / clipPosition.w();
+				float x = (clipPosition.x() * inverseW + 1.0f) * 0.5f * width;
+				float y = (1.0f - clipPosition.y() * inverseW) * 0.5f * height;
+				float z = (clipPosition.z() * inverseW + 1.0f) * 0.5f;
+				screenTriangle.positions[k] = Eigen::Vector3f(x, y, z);
+				screenTriangle.inverseW[k] = inverseW;
+				screenTriangle.colors[k] = polygonColors[corners[k]];
+				minX = fmin(minX, x);
+				minY = fmin(minY, y);
+				maxX = fmax(maxX, x);
+				maxY = fmax(maxY, y);
+			}
+
+			// Lines may touch the pixel just past the bounding box, so leave one pixel of slack
+			screenTriangle.minX = std::max(0, (int) floor(minX) - 1);
+			screenTriangle.minY = std::max(0, (int) floor(minY) - 1);
+			screenTriangle.maxX = std::min(width - 1, (int) ceil(maxX) + 1);
+			screenTriangle.maxY = std::min(height - 1, (int) ceil(maxY) + 1);
+			if (screenTriangle.minX <= screenTriangle.maxX && screenTriangle.minY <= screenTriangle.maxY) {
+				output.push_back(screenTriangle);
+			}
+		}
+	}
+
+
+	// Writes 'color' at pixel (x, y) if 'depth' passes the depth test (GL_LESS)
+	void plot(int x, int y, float depth, const Eigen::Vector3f& color) {
+		int index = y * width + x;
+		if (depth < depthBuffer[index]) {
+			depthBuffer[index] = depth;
+			colorBuffer[3 * index] = (unsigned char) (color.x() * 255.0f + 0.5f);
+			colorBuffer[3 * index + 1] = (unsigned char) (color.y() * 255.0f + 0.5f);
+			colorBuffer[3 * index + 2] = (unsigned char) (color.z() * 255.0f + 0.5f);
+		}
+	}
+
+
+	//****************************************************
+	// Fills the part of 'triangle' that lies inside the tile [tileMinX, tileMaxX] x [tileMinY, tileMaxY].
+	// 'fillColor' overrides the shaded color (hidden-line mode fills in black), and 'depthOffset' pushes the
+	// triangle back like glPolygonOffset(1.0, 1.0) does.
+	//***************************************************
+	void fillTriangle(const ScreenTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY,
+			const Eigen::Vector3f* fillColor, bool depthOffset) {
+		const Eigen::Vector3f& a = triangle.positions[0];
+		const Eigen::Vector3f& b = triangle.positions[1];
+		const Eigen::Vector3f& c = triangle.positions[2];
+
+		float area = (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+		if (area == 0.0f) {
+			return;
+		}
+
+		float offset = 0.0f;
+		if (depthOffset) {
+			// Largest depth slope of the triangle's plane, plus one unit of a 24-bit depth buffer
+			float dzdx = ((b.z() - a.z()) * (c.y() - a.y()) - (c.z() - a.z()) * (b.y() - a.y())) / area;
+			float dzdy = ((c.z() - a.z()) * (b.x() - a.x()) - (b.z() - a.z()) * (c.x() - a.x())) / area;
+			offset = fmax(fabs(dzdx), fabs(dzdy)) + 1.0f / (1 << 24);
+		}
+
+		int minX = std::max(triangle.minX, tileMinX), maxX = std::min(triangle.maxX, tileMaxX);
+		int minY = std::max(triangle.minY, tileMinY), maxY = std::min(triangle.maxY, tileMaxY);
+
+		for (int y = minY; y <= maxY; y++) {
+			float py = y + 0.5f;
+			for (int x = minX; x <= maxX; x++) {
+				float px = x + 0.5f;
+
+				// Barycentric coordinates from the three edge functions
+				float weightA = ((b.x() - px) * (c.y() - py) - (b.y() - py) * (c.x() - px)) / area;
+				float weightB = ((c.x() - px) * (a.y() - py) - (c.y() - py) * (a.x() - px)) / area;
+				float weightC = 1.0f - weightA - weightB;
+				if (weightA < 0.0f || weightB < 0.0f || weightC < 0.0f) {
+					continue;
+				}
+
+				float depth = weightA * a.z() + weightB * b.z() + weightC * c.z() + offset;
+				if (fillColor != NULL) {
+					plot(x, y, depth, *fillColor);
+				} else if (!SMOOTH_SHADING) {
+					plot(x, y, depth, triangle.flatColor);
+				} else {
+					float perspectiveA = weightA * triangle.inverseW[0];
+					float perspectiveB = weightB * triangle.inverseW[1];
+					float perspectiveC = weightC * triangle.inverseW[2];
+					Eigen::Vector3f color = (perspectiveA * triangle.colors[0] + perspectiveB * triangle.colors[1]
+							+ perspectiveC * triangle.colors[2]) / (perspectiveA + perspectiveB + perspectiveC);
+					plot(x, y, depth, color);
+				}
+			}
+		}
+	}
+
+
+	// Narrows [firstT, lastT] to the part of the line from 'from' to 'to' (one coordinate of it) that lies in
+	// [slabMin, slabMax]; false if none does
+	static bool clipLineToSlab(float from, float to, float slabMin, float slabMax, float& firstT, float& lastT) {
+		float delta = to - from;
+		if (delta == 0.0f) {
+			return from >= slabMin && from <= slabMax;
+		}
+		float enterT = (slabMin - from) / delta, exitT = (slabMax - from) / delta;
+		if (enterT > exitT) {
+			std::swap(enterT, exitT);
+		}
+		firstT = fmax(firstT, enterT);
+		lastT = fmin(lastT, exitT);
+		return firstT <= lastT;
+	}
+
+
+	//****************************************************
+	// Draws the flagged edges of 'triangle' in white, restricted to the given tile
+	//***************************************************
+	void drawTriangleEdges(const ScreenTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY) {
+		Eigen::Vector3f white(1.0f, 1.0f, 1.0f);
+		// (no need to clip the edges when the whole triangle lies in the tile)
+		bool insideTile = triangle.minX >= tileMinX && triangle.maxX <= tileMaxX
+				&& triangle.minY >= tileMinY && triangle.maxY <= tileMaxY;
+		for (int i = 0; i < 3; i++) {
+			if (!((triangle.edgeFlags >> i) & 1)) {
+				continue;
+			}
+			const Eigen::Vector3f& from = triangle.positions[i];
+			const Eigen::Vector3f& to = triangle.positions[(i + 1) % 3];
+
+			int steps = (int) ceil(fmax(fabs(to.x() - from.x()), fabs(to.y() - from.y())));
+			if (steps == 0) {
+				steps = 1;
+			}
+			// Walk only the steps that can land in this tile, give or take one for rounding, rather than the whole line
+			float firstT = 0.0f, lastT = 1.0f;
+			if (!insideTile && (!clipLineToSlab(from.x(), to.x(), tileMinX, tileMaxX + 1, firstT, lastT)
+					|| !clipLineToSlab(from.y(), to.y(), tileMinY, tileMaxY + 1, firstT, lastT))) {
+				continue;
+			}
+			int firstStep = std::max(0, (int) floor(firstT * steps) - 1);
+			int lastStep = std::min(steps, (int) ceil(lastT * steps) + 1);
+			for (int step = firstStep; step <= lastStep; step++) {
+				float t = (float) step / steps;
+				int x = (int) floor(from.x() + t * (to.x() - from.x()));
+				int y = (int) floor(from.y() + t * (to.y() - from.y()));
+				if (x >= tileMinX && x <= tileMaxX && y >= tileMinY && y <= tileMaxY) {
+					plot(x, y, from.z() + t * (to.z() - from.z()), white);
+				}
+			}
+		}
+	}
+
+
+	//****************************************************
+	// Renders all triangles that were added into colorBuffer
+	//***************************************************
+	void render() {
+		colorBuffer.assign(3 * width * height, 0);
+		depthBuffer.assign(width * height, 1.0f);
+
+		// 1. Light, clip and project all triangles in parallel; every chunk keeps its own output so order is preserved
+		int numberOfChunks = numberOfWorkerThreads();
+		std::vector<std::vector<ScreenTriangle> > screenTrianglesPerChunk(numberOfChunks);
+		parallelForChunks(triangles.size(), numberOfChunks, [&](int chunk, int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				processTriangle(triangles[i], screenTrianglesPerChunk[chunk]);
+			}
+		});
+
+		std::vector<ScreenTriangle> screenTriangles;
+		for (int chunk = 0; chunk < numberOfChunks; chunk++) {
+			screenTriangles.insert(screenTriangles.end(), screenTrianglesPerChunk[chunk].begin(), screenTrianglesPerChunk[chunk].end());
+		}
+
+		// 2. Bin the triangles into the tiles they overlap, in drawing order
+		int tilesAcross = (width + TILE_SIZE - 1) / TILE_SIZE;
+		int tilesDown = (height + TILE_SIZE - 1) / TILE_SIZE;
+		std::vector<std::vector<int> > trianglesPerTile(tilesAcross * tilesDown);
+		for (std::vector<ScreenTriangle>::size_type i = 0; i < screenTriangles.size(); i++) {
+			const ScreenTriangle& triangle = screenTriangles[i];
+			for (int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++) {
+				for (int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++) {
+					trianglesPerTile[tileY * tilesAcross + tileX].push_back(i);
+				}
+			}
+		}
+
+		// 3. Rasterize the tiles in parallel; tiles never share pixels, so no locking is needed
+		Eigen::Vector3f black(0.0f, 0.0f, 0.0f);
+		parallelForEach(tilesAcross * tilesDown, [&](int tile) {
+			int tileMinX = (tile % tilesAcross) * TILE_SIZE;
+			int tileMinY = (tile / tilesAcross) * TILE_SIZE;
+			int tileMaxX = std::min(tileMinX + TILE_SIZE, width) - 1;
+			int tileMaxY = std::min(tileMinY + TILE_SIZE, height) - 1;
+			const std::vector<int>& binnedTriangles = trianglesPerTile[tile];
+
+			if (!WIREFRAME_MODE || HIDDEN_LINE_MODE) {
+				for (std::vector<int>::size_type i = 0; i < binnedTriangles.size(); i++) {
+					fillTriangle(screenTriangles[binnedTriangles[i]], tileMinX, tileMinY, tileMaxX, tileMaxY,
+							WIREFRAME_MODE ? &black : NULL, WIREFRAME_MODE);
+				}
+			}
+			if (WIREFRAME_MODE) {
+				for (std::vector<int>::size_type i = 0; i < binnedTriangles.size(); i++) {
+					drawTriangleEdges(screenTriangles[binnedTriangles[i]], tileMinX, tileMinY, tileMaxX, tileMaxY);
+				}
+			}
+		});
+	}
+
+
+	//****************************************************
+	// Writes colorBuffer as a binary PPM (P6) image. Returns false if the file could not be written.
+	//***************************************************
+	bool writePPM(const std::string& filename) const {
+		std::ofstream file(filename.c_str(), std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		file << "P6\n" << width << " " << height << "\n255\n";
+		file.write((const char*) &colorBuffer[0], colorBuffer.size());
+		return (bool) file;
+	}
+
+
+	static unsigned int crc32(const unsigned char* data, size_t length, unsigned int crc) {
+		static unsigned int table[256];
+		static bool tableInitialized = false;
+		if (!tableInitialized) {
+			for (unsigned int n = 0; n < 256; n++) {
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++) {
+					c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				}
+				table[n] = c;
+			}
+			tableInitialized = true;
+		}
+		crc = ~crc;
+		for (size_t i = 0; i < length; i++) {
+			crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	static void appendBigEndian(std::vector<unsigned char>& bytes, unsigned int value) {
+		bytes.push_back(value >> 24);
+		bytes.push_back(value >> 16);
+		bytes.push_back(value >> 8);
+		bytes.push_back(value);
+	}
+
+	static void writePNGChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data) {
+		std::vector<unsigned char> chunk;
+		appendBigEndian(chunk, data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		appendBigEndian(chunk, crc32(&chunk[4], chunk.size() - 4, 0));
+		file.write((const char*) &chunk[0], chunk.size());
+	}
+
+
+	//****************************************************
+	// Writes colorBuffer as a PNG image. To stay free of dependencies (no zlib), the image data is stored
+	// in uncompressed deflate blocks. Returns false if the file could not be written.
+	//***************************************************
+	bool writePNG(const std::string& filename) const {
+		std::ofstream file(filename.c_str(), std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		const unsigned char signature[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+		file.write((const char*) signature, 8);
+
+		std::vector<unsigned char> header;
+		appendBigEndian(header, width);
+		appendBigEndian(header, height);
+		header.push_back(8);	// bit depth
+		header.push_back(2);	// color type: RGB
+		header.push_back(0);	// compression
+		header.push_back(0);	// filter
+		header.push_back(0);	// interlace
+		writePNGChunk(file, "IHDR", header);
+
+		// Raw scanlines, each prefixed with filter type 0 (none)
+		std::vector<unsigned char> scanlines;
+		scanlines.reserve((3 * width + 1) * height);
+		for (int y = 0; y < height; y++) {
+			scanlines.push_back(0);
+			scanlines.insert(scanlines.end(), colorBuffer.begin() + 3 * width * y, colorBuffer.begin() + 3 * width * (y + 1));
+		}
+
+		// zlib stream made of stored deflate blocks
+		std::vector<unsigned char> compressed;
+		compressed.push_back(0x78);
+		compressed.push_back(0x01);
+		size_t position = 0;
+		do {
+			size_t blockLength = std::min((size_t) 65535, scanlines.size() - position);
+			bool lastBlock = position + blockLength == scanlines.size();
+			compressed.push_back(lastBlock ? 1 : 0);
+			compressed.push_back(blockLength & 0xff);
+			compressed.push_back(blockLength >> 8);
+			compressed.push_back(~blockLength & 0xff);
+			compressed.push_back((~blockLength >> 8) & 0xff);
+			compressed.insert(compressed.end(), scanlines.begin() + position, scanlines.begin() + position + blockLength);
+			position += blockLength;
+		} while (position < scanlines.size());
+
+		unsigned int adlerA = 1, adlerB = 0;
+		for (size_t i = 0; i < scanlines.size(); i++) {
+			adlerA = (adlerA + scanlines[i]) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+		}
+		appendBigEndian(compressed, (adlerB << 16) | adlerA);
+		writePNGChunk(file, "IDAT", compressed);
+
+		writePNGChunk(file, "IEND", std::vector<unsigned char>());
+		return (bool) file;
+	}
+};
+
+
+#endif /* SOFTWARERASTERIZER_H_ */
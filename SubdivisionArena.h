@@ -0,0 +1,85 @@
+/*
+ * SubdivisionArena.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SUBDIVISIONARENA_H_
+#define SUBDIVISIONARENA_H_
+
+#include <vector>
+
+// A triangle that is waiting to be tested by adaptive subdivision.
+// Instead of holding three full DifferentialGeometry copies, it only stores the indices of its
+// vertices in the owning BezierPatch's listOfDifferentialGeometries.
+class SubdivisionWorkItem {
+	public:
+		int vertex1, vertex2, vertex3;
+
+		// number of splits that produced this triangle (the two initial triangles have depth 0)
+		int depth;
+
+	SubdivisionWorkItem() {
+
+	}
+
+	SubdivisionWorkItem(int vertex1, int vertex2, int vertex3, int depth) {
+		this->vertex1 = vertex1;
+		this->vertex2 = vertex2;
+		this->vertex3 = vertex3;
+		this->depth = depth;
+	}
+};
+
+
+// Bump allocator for the work items of adaptive subdivision.
+// Items can be handed out in the order they were pushed (pop(), breadth-first, like the old std::queue)
+// or newest first (popLast(), depth-first). Breadth-first never frees individual items; depth-first gives
+// the top of the stack back, so memory stays proportional to the subdivision depth.
+// reset() drops every item at once in O(1) and keeps the underlying memory, so one arena can be reused
+// for every patch without touching the allocator again.
+class SubdivisionArena {
+	public:
+		std::vector<SubdivisionWorkItem> items;
+
+		// index of the next item to hand out
+		std::vector<SubdivisionWorkItem>::size_type front;
+
+	SubdivisionArena() {
+		front = 0;
+	}
+
+	// Discards all items. SubdivisionWorkItem is trivially destructible, so this does not loop.
+	void reset() {
+		items.clear();
+		front = 0;
+	}
+
+	void push(int vertex1, int vertex2, int vertex3, int depth) {
+		items.push_back(SubdivisionWorkItem(vertex1, vertex2, vertex3, depth));
+	}
+
+	bool empty() const {
+		return front == items.size();
+	}
+
+	// Number of items that have been pushed but not handed out yet
+	std::vector<SubdivisionWorkItem>::size_type pending() const {
+		return items.size() - front;
+	}
+
+	// Returns (by value, since a later push may reallocate) the oldest item that has not been handed out yet
+	SubdivisionWorkItem pop() {
+		return items[front++];
+	}
+
+	// Returns the newest item that has not been handed out yet, and releases its slot
+	SubdivisionWorkItem popLast() {
+		SubdivisionWorkItem last = items.back();
+		items.pop_back();
+		return last;
+	}
+};
+
+
+#endif /* SUBDIVISIONARENA_H_ */
@@ -0,0 +1,442 @@
+/*
+ * TessellationCache.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TESSELLATIONCACHE_H_
+#define TESSELLATIONCACHE_H_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <process.h>
+#endif
+
+// A whole file, read-only. Mapped into memory where the platform allows it (so that only the pages that are actually
+// read are ever loaded), and read into a buffer otherwise.
+class MappedFile {
+	public:
+		const char* data;
+		size_t size;
+
+	MappedFile() {
+		data = NULL;
+		size = 0;
+	}
+
+	~MappedFile() {
+		close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& filename) {
+		close();
+#ifndef _WIN32
+		int descriptor = ::open(filename.c_str(), O_RDONLY);
+		if (descriptor < 0) {
+			return false;
+		}
+		struct stat fileStatus;
+		if (fstat(descriptor, &fileStatus) != 0 || fileStatus.st_size == 0) {
+			::close(descriptor);
+			return false;
+		}
+		void* mapping = mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		::close(descriptor);
+		if (mapping == MAP_FAILED) {
+			return false;
+		}
+		data = (const char*) mapping;
+		size = fileStatus.st_size;
+		return true;
+#else
+		std::ifstream file(filename, std::ios::binary);
+		if (!file.good()) {
+			return false;
+		}
+		buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		data = buffer.data();
+		size = buffer.size();
+		return size > 0;
+#endif
+	}
+
+	void close() {
+#ifndef _WIN32
+		if (data != NULL) {
+			munmap((void*) data, size);
+		}
+#else
+		buffer.clear();
+#endif
+		data = NULL;
+		size = 0;
+	}
+
+	private:
+#ifdef _WIN32
+		std::vector<char> buffer;
+#endif
+};
+
+
+//****************************************************
+// On-disk cache of tessellated .bez files, so that a file that was tessellated before (with the same options)
+// needs neither parsing nor subdivision.
+//
+// Entries are content addressed: the key is a hash of the file's bytes, the tessellation options and VERSION, so an
+// edited file or changed options simply miss. Each entry is one binary file <directory>/<key>.tess, holding per patch
+// its control points and an indexed mesh (a vertex table and triangles that index into it):
+//
+//   "BEZTESS" VERSION
+//   uint32 numberOfPatches, isQuantized
+//   per patch:   uint32 degreeU, degreeV, isRational, isTriangular
+//                float controlPoints[numberOfControlPoints][3]     (row by row, see BezierPatch::listOfCurves)
+//                float weights[numberOfControlPoints]              (only if isRational)
+//                uint32 numberOfDifferentialGeometries, numberOfVertices, numberOfTriangles
+//                float vertices[numberOfVertices][8]        (position, normal, (u, v)), or if isQuantized:
+//                float origin[3], extent[3]; QuantizedVertex vertices[numberOfVertices]   (14 bytes each)
+//                uint32 triangles[numberOfTriangles][3]
+//
+// The first numberOfDifferentialGeometries vertices are the patch's listOfDifferentialGeometries, in order.
+//***************************************************
+class TessellationCache {
+	public:
+		// Bump whenever the file format or the tessellation output changes, so that old entries are no longer used
+		static const int VERSION = 6;
+
+		// Entries claiming a higher degree than this are treated as damaged
+		static const unsigned int MAX_STORED_DEGREE = 64;
+
+		std::string directory;
+
+		// Whether store() writes vertices quantized (see QuantizedMesh) instead of as floats
+		bool quantizeVertices;
+
+	TessellationCache() {
+		quantizeVertices = false;
+	}
+
+	bool isEnabled() const {
+		return !directory.empty();
+	}
+
+	// 64-bit FNV-1a hash of 'length' bytes, continuing from 'hash'
+	static unsigned long long hashBytes(const void* bytes, size_t length, unsigned long long hash = 14695981039346656037ULL) {
+		const unsigned char* current = (const unsigned char*) bytes;
+		for (size_t i = 0; i < length; i++) {
+			hash ^= current[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	// Key of the tessellation of a file with these contents, using the options described by 'options'
+	static std::string key(const std::string& fileContents, const std::string& options) {
+		std::ostringstream description;
+		description << VERSION << " " << options;
+		std::string optionString = description.str();
+
+		unsigned long long hash = hashBytes(fileContents.data(), fileContents.size());
+		hash = hashBytes(optionString.data(), optionString.size(), hash);
+
+		char hexadecimal[17];
+		snprintf(hexadecimal, sizeof(hexadecimal), "%016llx", hash);
+		return std::string(hexadecimal);
+	}
+
+	std::string pathForKey(const std::string& key) const {
+		return directory + "/" + key + ".tess";
+	}
+
+
+	//****************************************************
+	// Appends the patches stored under 'key' to 'patches'. Returns false (and leaves 'patches' alone)
+	// if there is no such entry or it is damaged.
+	//***************************************************
+	bool load(const std::string& key, std::vector<BezierPatch>& patches) const {
+		MappedFile file;
+		if (!file.open(pathForKey(key))) {
+			return false;
+		}
+
+		size_t offset = 0;
+		if (!checkMagic(file, offset)) {
+			return false;
+		}
+		unsigned int numberOfPatches, isQuantized;
+		if (!read(file, offset, &numberOfPatches, sizeof(numberOfPatches))
+				|| !read(file, offset, &isQuantized, sizeof(isQuantized))) {
+			return false;
+		}
+
+		std::vector<BezierPatch> loadedPatches(numberOfPatches);
+		std::vector<DifferentialGeometry> vertices;
+		for (unsigned int i = 0; i < numberOfPatches; i++) {
+			BezierPatch& patch = loadedPatches[i];
+
+			unsigned int degrees[4];
+			if (!read(file, offset, degrees, sizeof(degrees)) || degrees[0] < 1 || degrees[1] < 1
+					|| degrees[0] > MAX_STORED_DEGREE || degrees[1] > MAX_STORED_DEGREE
+					|| (degrees[3] && degrees[0] != degrees[1])) {
+				return false;
+			}
+			patch.triangular = degrees[3] != 0;
+			unsigned int numberOfControlPoints = 0;
+			for (unsigned int row = 0; row <= degrees[1]; row++) {
+				numberOfControlPoints += rowLength(degrees, row);
+			}
+			std::vector<float> controlPoints(3 * numberOfControlPoints);
+			std::vector<float> weights(degrees[2] ? numberOfControlPoints : 0);
+			unsigned int counts[3];
+			if (!read(file, offset, controlPoints.data(), controlPoints.size() * sizeof(float))
+					|| !read(file, offset, weights.data(), weights.size() * sizeof(float))
+					|| !read(file, offset, counts, sizeof(counts))) {
+				return false;
+			}
+			unsigned int index = 0;
+			for (unsigned int row = 0; row <= degrees[1]; row++) {
+				std::vector<Eigen::Vector3f> curve;
+				std::vector<float> curveWeights;
+				for (unsigned int column = 0; column < rowLength(degrees, row); column++, index++) {
+					const float* point = &controlPoints[3 * index];
+					curve.push_back(Eigen::Vector3f(point[0], point[1], point[2]));
+					if (degrees[2]) {
+						curveWeights.push_back(weights[index]);
+					}
+				}
+				if (degrees[2]) {
+					patch.addCurve(curve, curveWeights);
+				} else {
+					patch.addCurve(curve);
+				}
+			}
+
+			unsigned int numberOfDifferentialGeometries = counts[0], numberOfVertices = counts[1], numberOfTriangles = counts[2];
+			if (numberOfDifferentialGeometries > numberOfVertices) {
+				return false;
+			}
+			if (isQuantized) {
+				QuantizedMesh mesh;
+				if (!read(file, offset, mesh.origin, sizeof(mesh.origin)) || !read(file, offset, mesh.extent, sizeof(mesh.extent))
+						|| (file.size - offset) / sizeof(QuantizedVertex) < numberOfVertices) {
+					return false;
+				}
+				mesh.vertices.resize(numberOfVertices);
+				read(file, offset, mesh.vertices.data(), numberOfVertices * sizeof(QuantizedVertex));
+				mesh.decode(vertices);
+			} else {
+				if ((file.size - offset) / (8 * sizeof(float)) < numberOfVertices) {
+					return false;
+				}
+
+				// Sections follow each other without padding (quantized vertices are 14 bytes each), so the
+				// mapped data is copied out rather than read in place, which may be misaligned
+				vertices.resize(numberOfVertices);
+				float vertex[8];
+				for (unsigned int k = 0; k < numberOfVertices; k++) {
+					read(file, offset, vertex, sizeof(vertex));
+					vertices[k] = DifferentialGeometry(Eigen::Vector3f(vertex[0], vertex[1], vertex[2]),
+							Eigen::Vector3f(vertex[3], vertex[4], vertex[5]), Eigen::Vector2f(vertex[6], vertex[7]));
+				}
+			}
+			patch.listOfDifferentialGeometries.assign(vertices.begin(), vertices.begin() + numberOfDifferentialGeometries);
+
+			if ((file.size - offset) / (3 * sizeof(unsigned int)) < numberOfTriangles) {
+				return false;
+			}
+			patch.listOfTriangles.reserve(numberOfTriangles);
+			unsigned int triangle[3];
+			for (unsigned int k = 0; k < numberOfTriangles; k++) {
+				read(file, offset, triangle, sizeof(triangle));
+				if (triangle[0] >= numberOfVertices || triangle[1] >= numberOfVertices || triangle[2] >= numberOfVertices) {
+					return false;
+				}
+				patch.addTriangle(vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]]);
+			}
+		}
+		if (offset != file.size) {
+			return false;
+		}
+
+		for (unsigned int i = 0; i < numberOfPatches; i++) {
+			patches.push_back(std::move(loadedPatches[i]));
+		}
+		return true;
+	}
+
+
+	//****************************************************
+	// Stores the tessellated patches patches[begin, end) under 'key'. Returns false if the entry could not be written.
+	//***************************************************
+	bool store(const std::string& key, const std::vector<BezierPatch>& patches, int begin, int end) const {
+#ifndef _WIN32
+		mkdir(directory.c_str(), 0755);
+#endif
+		// Write to a temporary file first, so that another run never maps a half-written entry (named after this
+		// process, so that runs storing the same entry at the same time do not write into each other's file)
+		std::string path = pathForKey(key);
+		std::ostringstream temporaryName;
+#ifndef _WIN32
+		temporaryName << path << "." << getpid() << ".tmp";
+#else
+		temporaryName << path << "." << _getpid() << ".tmp";
+#endif
+		std::string temporaryPath = temporaryName.str();
+		std::ofstream file(temporaryPath, std::ios::binary);
+		if (!file.good()) {
+			return false;
+		}
+
+		std::ostringstream magic;
+		magic << "BEZTESS" << VERSION;
+		file.write(magic.str().data(), magic.str().size());
+		unsigned int numberOfPatches = end - begin, isQuantized = quantizeVertices;
+		file.write((const char*) &numberOfPatches, sizeof(numberOfPatches));
+		file.write((const char*) &isQuantized, sizeof(isQuantized));
+
+		std::vector<float> vertexData;
+		std::vector<unsigned int> triangleData;
+		for (int i = begin; i < end; i++) {
+			const BezierPatch& patch = patches[i];
+
+			unsigned int degrees[4] = { (unsigned int) patch.degreeU(), (unsigned int) patch.degreeV(), patch.isRational(),
+					patch.triangular };
+			std::vector<float> controlPoints;
+			std::vector<float> weights;
+			for (unsigned int row = 0; row <= degrees[1]; row++) {
+				for (unsigned int column = 0; column < rowLength(degrees, row); column++) {
+					for (int axis = 0; axis < 3; axis++) {
+						controlPoints.push_back(patch.listOfCurves[row][column][axis]);
+					}
+					if (degrees[2]) {
+						weights.push_back(patch.weights[row][column]);
+					}
+				}
+			}
+
+			// The vertex table starts with the differential geometries; triangle corners that are not among them
+			// (bit for bit) are added behind them
+			std::unordered_map<std::string, unsigned int> vertexIndices;
+			vertexData.clear();
+			triangleData.clear();
+			for (std::vector<DifferentialGeometry>::size_type k = 0; k < patch.listOfDifferentialGeometries.size(); k++) {
+				addVertex(patch.listOfDifferentialGeometries[k], vertexData, vertexIndices, true);
+			}
+			unsigned int numberOfDifferentialGeometries = patch.listOfDifferentialGeometries.size();
+			for (std::vector<Triangle>::size_type k = 0; k < patch.listOfTriangles.size(); k++) {
+				const Triangle& triangle = patch.listOfTriangles[k];
+				triangleData.push_back(addVertex(triangle.point1, vertexData, vertexIndices, false));
+				triangleData.push_back(addVertex(triangle.point2, vertexData, vertexIndices, false));
+				triangleData.push_back(addVertex(triangle.point3, vertexData, vertexIndices, false));
+			}
+
+			unsigned int counts[3] = { numberOfDifferentialGeometries, (unsigned int) (vertexData.size() / 8),
+					(unsigned int) patch.listOfTriangles.size() };
+			file.write((const char*) degrees, sizeof(degrees));
+			file.write((const char*) controlPoints.data(), controlPoints.size() * sizeof(float));
+			file.write((const char*) weights.data(), weights.size() * sizeof(float));
+			file.write((const char*) counts, sizeof(counts));
+			if (isQuantized) {
+				writeQuantized(file, vertexData);
+			} else {
+				file.write((const char*) vertexData.data(), vertexData.size() * sizeof(float));
+			}
+			file.write((const char*) triangleData.data(), triangleData.size() * sizeof(unsigned int));
+		}
+
+		file.close();
+		if (!file.good() || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+			remove(temporaryPath.c_str());
+			return false;
+		}
+		return true;
+	}
+
+
+	private:
+
+	// Number of control points in 'row' of a patch described by 'degrees' (degreeU, degreeV, isRational, isTriangular)
+	static unsigned int rowLength(const unsigned int* degrees, unsigned int row) {
+		return degrees[3] ? degrees[0] + 1 - row : degrees[0] + 1;
+	}
+
+	// Writes the vertex table 'vertexData' (8 floats per vertex) as a QuantizedMesh's bounds and vertices
+	static void writeQuantized(std::ofstream& file, const std::vector<float>& vertexData) {
+		std::vector<DifferentialGeometry> points(vertexData.size() / 8);
+		for (std::vector<DifferentialGeometry>::size_type k = 0; k < points.size(); k++) {
+			const float* vertex = &vertexData[8 * k];
+			points[k] = DifferentialGeometry(Eigen::Vector3f(vertex[0], vertex[1], vertex[2]),
+					Eigen::Vector3f(vertex[3], vertex[4], vertex[5]), Eigen::Vector2f(vertex[6], vertex[7]));
+		}
+		QuantizedMesh mesh;
+		mesh.encode(points);
+		file.write((const char*) mesh.origin, sizeof(mesh.origin));
+		file.write((const char*) mesh.extent, sizeof(mesh.extent));
+		file.write((const char*) mesh.vertices.data(), mesh.vertices.size() * sizeof(QuantizedVertex));
+	}
+
+	static bool read(const MappedFile& file, size_t& offset, void* destination, size_t length) {
+		if (file.size - offset < length) {
+			return false;
+		}
+		// (empty sections, such as the weights of polynomial patches, may have no destination at all)
+		if (length == 0) {
+			return true;
+		}
+		memcpy(destination, file.data + offset, length);
+		offset += length;
+		return true;
+	}
+
+	static bool checkMagic(const MappedFile& file, size_t& offset) {
+		std::ostringstream magic;
+		magic << "BEZTESS" << VERSION;
+		std::string expected = magic.str();
+		if (file.size < expected.size() || memcmp(file.data, expected.data(), expected.size()) != 0) {
+			return false;
+		}
+		offset = expected.size();
+		return true;
+	}
+
+	//****************************************************
+	// Returns the index of 'point' in the vertex table, adding it if it is new (or if 'alwaysAdd' is set,
+	// which keeps duplicate differential geometries in the table so that their list is restored exactly)
+	//***************************************************
+	static unsigned int addVertex(const DifferentialGeometry& point, std::vector<float>& vertexData,
+			std::unordered_map<std::string, unsigned int>& vertexIndices, bool alwaysAdd) {
+		float vertex[8] = { point.position.x(), point.position.y(), point.position.z(),
+				point.normal.x(), point.normal.y(), point.normal.z(), point.uvValues.x(), point.uvValues.y() };
+		std::string vertexBytes((const char*) vertex, sizeof(vertex));
+
+		std::unordered_map<std::string, unsigned int>::iterator existing = vertexIndices.find(vertexBytes);
+		if (existing != vertexIndices.end() && !alwaysAdd) {
+			return existing->second;
+		}
+
+		unsigned int index = vertexData.size() / 8;
+		vertexData.insert(vertexData.end(), vertex, vertex + 8);
+		if (existing == vertexIndices.end()) {
+			vertexIndices[vertexBytes] = index;
+		}
+		return index;
+	}
+};
+
+
+#endif /* TESSELLATIONCACHE_H_ */
@@ -0,0 +1,56 @@
+/*
+ * TraversalStack.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TRAVERSALSTACK_H_
+#define TRAVERSALSTACK_H_
+
+#include <vector>
+
+//****************************************************
+// Stack of node indices for the depth-first traversal of a binary tree whose leaves are at most 'depth' levels
+// below its root, where every node that is popped pushes at most its two children. That leaves at most one waiting
+// sibling per level plus the two children on the stack, so it never holds more than depth + 1 entries. Trees of
+// any sensible depth fit in the fixed array; deeper ones (a split that keeps peeling one item off) get a heap array.
+//***************************************************
+class TraversalStack {
+	public:
+		static const int FIXED_SIZE = 128;
+
+	TraversalStack(int depth) {
+		entries = fixedEntries;
+		size = 0;
+		if (depth + 1 > FIXED_SIZE) {
+			heapEntries.resize(depth + 1);
+			entries = &heapEntries[0];
+		}
+	}
+
+	// (copies would point into the original's fixed array)
+	TraversalStack(const TraversalStack&) = delete;
+	TraversalStack& operator=(const TraversalStack&) = delete;
+
+	void push(int node) {
+		entries[size++] = node;
+	}
+
+	int pop() {
+		return entries[--size];
+	}
+
+	bool empty() const {
+		return size == 0;
+	}
+
+
+	private:
+		int fixedEntries[FIXED_SIZE];
+		std::vector<int> heapEntries;
+		int* entries;
+		int size;
+};
+
+
+#endif /* TRAVERSALSTACK_H_ */
@@ -16,20 +16,20 @@ public:
 
 	}
 
-	Triangle(DifferentialGeometry v1, DifferentialGeometry v2, DifferentialGeometry v3) {
+	Triangle(const DifferentialGeometry& v1, const DifferentialGeometry& v2, const DifferentialGeometry& v3) {
 		this->point1 = v1;
 		this->point2 = v2;
 		this->point3 = v3;
 	}
 
 	// Converts float to string
-	std::string convertFloatToString(float number){
+	std::string convertFloatToString(float number) const {
 	    std::ostringstream buff;
 	    buff<<number;
 	    return buff.str();
 	}
 
-	std::string printTriangleInformation() {
+	std::string printTriangleInformation() const {
 		float ax = point1.position.x();
 		float ay = point1.position.y();
 		float az = point1.position.z();
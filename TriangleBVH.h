@@ -0,0 +1,609 @@
+/*
+ * TriangleBVH.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TRIANGLEBVH_H_
+#define TRIANGLEBVH_H_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+// A triangle of the BVH, stored the way the intersection test wants it (one vertex and two edges),
+// together with where it came from
+class BVHTriangle {
+	public:
+		Eigen::Vector3f vertex0, edge1, edge2;
+
+		// Index of the patch (or .obj face) the triangle belongs to, and of the triangle within it
+		int patchIndex;
+		int triangleIndex;
+
+	BVHTriangle() {
+
+	}
+
+	BVHTriangle(const Eigen::Vector3f& a, const Eigen::Vector3f& b, const Eigen::Vector3f& c, int patchIndex, int triangleIndex) {
+		vertex0 = a;
+		edge1 = b - a;
+		edge2 = c - a;
+		this->patchIndex = patchIndex;
+		this->triangleIndex = triangleIndex;
+	}
+};
+
+
+// Closest hit of a ray with the triangles of a TriangleBVH
+class TriangleHit {
+	public:
+		float t;
+		int patchIndex;
+		int triangleIndex;
+
+		// Barycentric coordinates of the hit with respect to the second and third vertex of the triangle
+		// (the first vertex has weight 1 - beta - gamma)
+		float beta, gamma;
+};
+
+
+// A BVH node in 32 bytes, so that two nodes fit in a cache line. Leaves store a range of triangles,
+// interior nodes store their first child (the second child directly follows it).
+class BVHNode {
+	public:
+		float boxMin[3];
+		// first triangle (leaf) or first child (interior node)
+		int firstIndex;
+		float boxMax[3];
+		// number of triangles, or 0 for interior nodes
+		int count;
+
+	bool isLeaf() const {
+		return count > 0;
+	}
+};
+
+
+//****************************************************
+// Bounding volume hierarchy over triangles, for picking and other ray queries against tessellated meshes.
+//
+// Built top-down with the surface area heuristic (evaluated on 12 bins of triangle centroids per axis). The top of the
+// tree is built on the calling thread until there are enough independent subtrees, which are then built in parallel
+// and spliced into the node array.
+//***************************************************
+class TriangleBVH {
+	public:
+		std::vector<BVHTriangle> triangles;
+		std::vector<BVHNode> nodes;
+
+		// Most levels any leaf is below the root, which sizes the traversal stacks
+		int depth;
+
+		static const int NUMBER_OF_BINS = 12;
+		static const int MAX_LEAF_SIZE = 4;
+
+		// Subtrees with fewer triangles than this are not worth a thread of their own
+		static const int PARALLEL_SUBTREE_SIZE = 4096;
+
+	TriangleBVH() {
+		depth = 0;
+	}
+
+	void clear() {
+		triangles.clear();
+		nodes.clear();
+		depth = 0;
+	}
+
+	// Triangles are added first, then build() is called once
+	void addTriangle(const Eigen::Vector3f& a, const Eigen::Vector3f& b, const Eigen::Vector3f& c, int patchIndex, int triangleIndex) {
+		triangles.push_back(BVHTriangle(a, b, c, patchIndex, triangleIndex));
+	}
+
+
+	//****************************************************
+	// Builds the tree over all triangles that were added, and reorders the triangles to match the leaves
+	//***************************************************
+	void build() {
+		nodes.clear();
+		depth = 0;
+		if (triangles.empty()) {
+			return;
+		}
+
+		// Work on triangle indices and bounds, and only shuffle the triangles themselves at the end
+		std::vector<int> order(triangles.size());
+		std::vector<Eigen::Vector3f> centroids(triangles.size()), triangleMin(triangles.size()), triangleMax(triangles.size());
+		parallelForChunks(triangles.size(), numberOfWorkerThreads(), [&](int, int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				const BVHTriangle& triangle = triangles[i];
+				Eigen::Vector3f b = triangle.vertex0 + triangle.edge1;
+				Eigen::Vector3f c = triangle.vertex0 + triangle.edge2;
+				order[i] = i;
+				triangleMin[i] = triangle.vertex0.cwiseMin(b).cwiseMin(c);
+				triangleMax[i] = triangle.vertex0.cwiseMax(b).cwiseMax(c);
+				centroids[i] = (triangleMin[i] + triangleMax[i]) * 0.5f;
+			}
+		});
+		BuildInput input = { order, centroids, triangleMin, triangleMax };
+
+		// Split the top of the tree until there is enough work for every thread
+		std::vector<BuildTask> deferredSubtrees;
+		// (compared rather than passed to std::max, which would take the constant by reference and need a definition)
+		int parallelSize = (int) triangles.size() / (4 * numberOfWorkerThreads());
+		if (parallelSize < PARALLEL_SUBTREE_SIZE) {
+			parallelSize = PARALLEL_SUBTREE_SIZE;
+		}
+		if (numberOfWorkerThreads() == 1) {
+			parallelSize = triangles.size() + 1;
+		}
+		nodes.push_back(BVHNode());
+		// (neither split bounds the depth, since skewed centroids can peel off a few triangles per level, so it is measured)
+		depth = buildNode(input, nodes, 0, 0, 0, triangles.size(), parallelSize, &deferredSubtrees);
+
+		// Build the remaining subtrees in parallel, each into its own node array, with its root at index 0
+		std::vector<std::vector<BVHNode> > subtrees(deferredSubtrees.size());
+		std::vector<int> subtreeDepths(deferredSubtrees.size());
+		parallelForEach(deferredSubtrees.size(), [&](int i) {
+			subtrees[i].push_back(BVHNode());
+			subtreeDepths[i] = buildNode(input, subtrees[i], 0, deferredSubtrees[i].level, deferredSubtrees[i].begin,
+					deferredSubtrees[i].end, 0, NULL);
+		});
+		for (std::vector<int>::size_type i = 0; i < subtreeDepths.size(); i++) {
+			depth = std::max(depth, subtreeDepths[i]);
+		}
+
+		// Splice them in: the root replaces its placeholder, the rest is appended behind the existing nodes
+		for (std::vector<BuildTask>::size_type i = 0; i < deferredSubtrees.size(); i++) {
+			const std::vector<BVHNode>& subtree = subtrees[i];
+			int offset = nodes.size() - 1;
+			for (std::vector<BVHNode>::size_type k = 0; k < subtree.size(); k++) {
+				BVHNode node = subtree[k];
+				if (!node.isLeaf()) {
+					node.firstIndex += offset;
+				}
+				if (k == 0) {
+					nodes[deferredSubtrees[i].nodeIndex] = node;
+				} else {
+					nodes.push_back(node);
+				}
+			}
+		}
+
+		std::vector<BVHTriangle> orderedTriangles(triangles.size());
+		for (std::vector<int>::size_type i = 0; i < order.size(); i++) {
+			orderedTriangles[i] = triangles[order[i]];
+		}
+		triangles.swap(orderedTriangles);
+	}
+
+
+	//****************************************************
+	// Finds the closest triangle hit by 'ray'. Returns false if there is none.
+	//***************************************************
+	bool intersect(const Ray& ray, TriangleHit& closestHit) const {
+		if (nodes.empty()) {
+			return false;
+		}
+
+		BoxTest boxTest(ray);
+		float tMax = ray.t_max;
+		bool hitSomething = false;
+
+		TraversalStack stack(depth);
+		stack.push(0);
+
+		while (!stack.empty()) {
+			const BVHNode& node = nodes[stack.pop()];
+			if (!boxTest.hits(node, tMax)) {
+				continue;
+			}
+
+			if (node.isLeaf()) {
+				for (int i = node.firstIndex; i < node.firstIndex + node.count; i++) {
+					if (intersectTriangle(ray, triangles[i], tMax, closestHit)) {
+						hitSomething = true;
+						tMax = closestHit.t;
+					}
+				}
+				continue;
+			}
+
+			// Visit the nearer child first, so that far subtrees are culled by a closer hit
+			float nearFirst, nearSecond;
+			bool hitsFirst = boxTest.hits(nodes[node.firstIndex], tMax, &nearFirst);
+			bool hitsSecond = boxTest.hits(nodes[node.firstIndex + 1], tMax, &nearSecond);
+			if (hitsFirst && hitsSecond) {
+				bool firstIsNearer = nearFirst <= nearSecond;
+				stack.push(firstIsNearer ? node.firstIndex + 1 : node.firstIndex);
+				stack.push(firstIsNearer ? node.firstIndex : node.firstIndex + 1);
+			} else if (hitsFirst) {
+				stack.push(node.firstIndex);
+			} else if (hitsSecond) {
+				stack.push(node.firstIndex + 1);
+			}
+		}
+		return hitSomething;
+	}
+
+
+	//****************************************************
+	// Returns true if 'ray' hits any triangle (cheaper than intersect(), e.g. for shadow rays)
+	//***************************************************
+	bool occluded(const Ray& ray) const {
+		if (nodes.empty()) {
+			return false;
+		}
+
+		BoxTest boxTest(ray);
+		TriangleHit hit;
+		TraversalStack stack(depth);
+		stack.push(0);
+
+		while (!stack.empty()) {
+			const BVHNode& node = nodes[stack.pop()];
+			if (!boxTest.hits(node, ray.t_max)) {
+				continue;
+			}
+			if (node.isLeaf()) {
+				for (int i = node.firstIndex; i < node.firstIndex + node.count; i++) {
+					if (intersectTriangle(ray, triangles[i], ray.t_max, hit)) {
+						return true;
+					}
+				}
+			} else {
+				stack.push(node.firstIndex + 1);
+				stack.push(node.firstIndex);
+			}
+		}
+		return false;
+	}
+
+
+	//****************************************************
+	// Distance from 'point' to the closest triangle (HUGE_VALF if there are none). Boxes further away than the closest
+	// triangle found so far are skipped, and the nearer child is visited first.
+	//***************************************************
+	float closestDistance(const Eigen::Vector3f& point) const {
+		float closestSquared = HUGE_VALF;
+		if (nodes.empty()) {
+			return closestSquared;
+		}
+
+		TraversalStack stack(depth);
+		stack.push(0);
+
+		while (!stack.empty()) {
+			const BVHNode& node = nodes[stack.pop()];
+			if (boxDistanceSquared(node, point) >= closestSquared) {
+				continue;
+			}
+
+			if (node.isLeaf()) {
+				for (int i = node.firstIndex; i < node.firstIndex + node.count; i++) {
+					closestSquared = std::min(closestSquared, triangleDistanceSquared(point, triangles[i]));
+				}
+				continue;
+			}
+
+			bool firstIsNearer = boxDistanceSquared(nodes[node.firstIndex], point) <= boxDistanceSquared(nodes[node.firstIndex + 1], point);
+			stack.push(firstIsNearer ? node.firstIndex + 1 : node.firstIndex);
+			stack.push(firstIsNearer ? node.firstIndex : node.firstIndex + 1);
+		}
+		return sqrt(closestSquared);
+	}
+
+
+	private:
+		// Where the triangle data is read from during a build
+		struct BuildInput {
+			std::vector<int>& order;
+			const std::vector<Eigen::Vector3f>& centroids;
+			const std::vector<Eigen::Vector3f>& triangleMin;
+			const std::vector<Eigen::Vector3f>& triangleMax;
+		};
+
+		// A subtree over order[begin, end) that is left for a worker thread, and the node it belongs in
+		struct BuildTask {
+			int nodeIndex;
+			// levels below the root
+			int level;
+			int begin, end;
+		};
+
+		// Box and centroid bounds of one SAH bin
+		struct Bin {
+			Eigen::Vector3f boxMin, boxMax;
+			int count;
+		};
+
+		// Slab test of a ray against node boxes. Uses SSE when it is available: the three axes are tested at once,
+		// reading each box (with the index that follows it) as four floats and ignoring the fourth.
+		struct BoxTest {
+#ifdef __SSE__
+			__m128 origin, inverseDirection;
+#else
+			Eigen::Vector3f origin, inverseDirection;
+#endif
+			float tMin;
+
+			BoxTest(const Ray& ray) {
+				Eigen::Vector3f inverse = ray.direction.cwiseInverse();
+#ifdef __SSE__
+				origin = _mm_set_ps(0.0f, ray.position.z(), ray.position.y(), ray.position.x());
+				inverseDirection = _mm_set_ps(0.0f, inverse.z(), inverse.y(), inverse.x());
+#else
+				origin = ray.position;
+				inverseDirection = inverse;
+#endif
+				tMin = ray.t_min;
+			}
+
+			bool hits(const BVHNode& node, float tMax, float* tEntry = NULL) const {
+#ifdef __SSE__
+				__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.boxMin), origin), inverseDirection);
+				__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.boxMax), origin), inverseDirection);
+				__m128 nearT = _mm_min_ps(t1, t2);
+				__m128 farT = _mm_max_ps(t1, t2);
+				// Reduce lanes x, y and z
+				nearT = _mm_max_ss(_mm_max_ss(nearT, _mm_shuffle_ps(nearT, nearT, 1)), _mm_shuffle_ps(nearT, nearT, 2));
+				farT = _mm_min_ss(_mm_min_ss(farT, _mm_shuffle_ps(farT, farT, 1)), _mm_shuffle_ps(farT, farT, 2));
+				float tNear = std::max(tMin, _mm_cvtss_f32(nearT));
+				float tFar = std::min(tMax, _mm_cvtss_f32(farT));
+#else
+				float tNear = tMin;
+				float tFar = tMax;
+				for (int axis = 0; axis < 3; axis++) {
+					float t1 = (node.boxMin[axis] - origin[axis]) * inverseDirection[axis];
+					float t2 = (node.boxMax[axis] - origin[axis]) * inverseDirection[axis];
+					tNear = std::max(tNear, std::min(t1, t2));
+					tFar = std::min(tFar, std::max(t1, t2));
+				}
+#endif
+				if (tEntry != NULL) {
+					*tEntry = tNear;
+				}
+				return tNear <= tFar;
+			}
+		};
+
+
+	static float halfSurfaceArea(const Eigen::Vector3f& boxMin, const Eigen::Vector3f& boxMax) {
+		Eigen::Vector3f extent = boxMax - boxMin;
+		return extent.x() * extent.y() + extent.y() * extent.z() + extent.z() * extent.x();
+	}
+
+
+	//****************************************************
+	// Fills in nodeList[nodeIndex], which is 'level' levels below the root, for the triangles order[begin, end) and
+	// builds its subtree. Subtrees that are smaller than 'parallelSize' are not built but added to 'deferredSubtrees'
+	// (unless that is NULL). Returns the level of the deepest leaf that was built (or of the node, if it was deferred).
+	//***************************************************
+	static int buildNode(BuildInput& input, std::vector<BVHNode>& nodeList, int nodeIndex, int level, int begin, int end,
+			int parallelSize, std::vector<BuildTask>* deferredSubtrees) {
+		Eigen::Vector3f boxMin = input.triangleMin[input.order[begin]];
+		Eigen::Vector3f boxMax = input.triangleMax[input.order[begin]];
+		Eigen::Vector3f centroidMin = input.centroids[input.order[begin]];
+		Eigen::Vector3f centroidMax = centroidMin;
+		for (int i = begin + 1; i < end; i++) {
+			int triangle = input.order[i];
+			boxMin = boxMin.cwiseMin(input.triangleMin[triangle]);
+			boxMax = boxMax.cwiseMax(input.triangleMax[triangle]);
+			centroidMin = centroidMin.cwiseMin(input.centroids[triangle]);
+			centroidMax = centroidMax.cwiseMax(input.centroids[triangle]);
+		}
+
+		for (int axis = 0; axis < 3; axis++) {
+			nodeList[nodeIndex].boxMin[axis] = boxMin[axis];
+			nodeList[nodeIndex].boxMax[axis] = boxMax[axis];
+		}
+
+		if (deferredSubtrees != NULL && end - begin < parallelSize) {
+			BuildTask task = { nodeIndex, level, begin, end };
+			deferredSubtrees->push_back(task);
+			return level;
+		}
+
+		int count = end - begin;
+		int splitAxis = -1;
+		int splitBin = 0;
+		float bestCost = count;		// cost of making this node a leaf, in triangle tests per unit of area
+		float parentArea = halfSurfaceArea(boxMin, boxMax);
+
+		for (int axis = 0; axis < 3 && count > 1; axis++) {
+			float extent = centroidMax[axis] - centroidMin[axis];
+			if (extent <= 0.0f) {
+				continue;
+			}
+			float binScale = NUMBER_OF_BINS / extent;
+
+			Bin bins[NUMBER_OF_BINS];
+			for (int b = 0; b < NUMBER_OF_BINS; b++) {
+				bins[b].count = 0;
+			}
+			for (int i = begin; i < end; i++) {
+				int triangle = input.order[i];
+				int b = std::min(NUMBER_OF_BINS - 1, (int) ((input.centroids[triangle][axis] - centroidMin[axis]) * binScale));
+				if (bins[b].count == 0) {
+					bins[b].boxMin = input.triangleMin[triangle];
+					bins[b].boxMax = input.triangleMax[triangle];
+				} else {
+					bins[b].boxMin = bins[b].boxMin.cwiseMin(input.triangleMin[triangle]);
+					bins[b].boxMax = bins[b].boxMax.cwiseMax(input.triangleMax[triangle]);
+				}
+				bins[b].count++;
+			}
+
+			// Sweep from the right to get the area and count to the right of every split, then from the left
+			float rightArea[NUMBER_OF_BINS];
+			int rightCount[NUMBER_OF_BINS];
+			Eigen::Vector3f sweepMin, sweepMax;
+			int sweepCount = 0;
+			for (int b = NUMBER_OF_BINS - 1; b > 0; b--) {
+				if (bins[b].count > 0) {
+					sweepMin = sweepCount == 0 ? bins[b].boxMin : sweepMin.cwiseMin(bins[b].boxMin);
+					sweepMax = sweepCount == 0 ? bins[b].boxMax : sweepMax.cwiseMax(bins[b].boxMax);
+					sweepCount += bins[b].count;
+				}
+				rightCount[b] = sweepCount;
+				rightArea[b] = sweepCount == 0 ? 0.0f : halfSurfaceArea(sweepMin, sweepMax);
+			}
+
+			sweepCount = 0;
+			for (int b = 0; b < NUMBER_OF_BINS - 1; b++) {
+				if (bins[b].count > 0) {
+					sweepMin = sweepCount == 0 ? bins[b].boxMin : sweepMin.cwiseMin(bins[b].boxMin);
+					sweepMax = sweepCount == 0 ? bins[b].boxMax : sweepMax.cwiseMax(bins[b].boxMax);
+					sweepCount += bins[b].count;
+				}
+				if (sweepCount == 0 || rightCount[b + 1] == 0) {
+					continue;
+				}
+
+				// One box test for the node plus the expected number of triangle tests in the children
+				float cost = 0.125f + (sweepCount * halfSurfaceArea(sweepMin, sweepMax) + rightCount[b + 1] * rightArea[b + 1])
+						/ std::max(parentArea, std::numeric_limits<float>::min());
+				if (cost < bestCost) {
+					bestCost = cost;
+					splitAxis = axis;
+					splitBin = b;
+				}
+			}
+		}
+
+		if (splitAxis < 0 && count > MAX_LEAF_SIZE) {
+			// All centroids coincide (or splitting never pays off), but the leaf would be too big: split in the middle
+			splitAxis = 0;
+			splitBin = -1;
+		}
+
+		if (splitAxis < 0) {
+			nodeList[nodeIndex].firstIndex = begin;
+			nodeList[nodeIndex].count = count;
+			return level;
+		}
+
+		int middle;
+		if (splitBin < 0) {
+			middle = (begin + end) / 2;
+		} else {
+			float extent = centroidMax[splitAxis] - centroidMin[splitAxis];
+			float binScale = NUMBER_OF_BINS / extent;
+			middle = std::partition(input.order.begin() + begin, input.order.begin() + end, [&](int triangle) {
+				return std::min(NUMBER_OF_BINS - 1, (int) ((input.centroids[triangle][splitAxis] - centroidMin[splitAxis]) * binScale))
+						<= splitBin;
+			}) - input.order.begin();
+		}
+
+		int firstChild = nodeList.size();
+		nodeList.push_back(BVHNode());
+		nodeList.push_back(BVHNode());
+		nodeList[nodeIndex].firstIndex = firstChild;
+		nodeList[nodeIndex].count = 0;
+		int firstDepth = buildNode(input, nodeList, firstChild, level + 1, begin, middle, parallelSize, deferredSubtrees);
+		int secondDepth = buildNode(input, nodeList, firstChild + 1, level + 1, middle, end, parallelSize, deferredSubtrees);
+		return std::max(firstDepth, secondDepth);
+	}
+
+
+	static float boxDistanceSquared(const BVHNode& node, const Eigen::Vector3f& point) {
+		float distanceSquared = 0.0f;
+		for (int axis = 0; axis < 3; axis++) {
+			float outside = std::max(std::max(node.boxMin[axis] - point[axis], point[axis] - node.boxMax[axis]), 0.0f);
+			distanceSquared += outside * outside;
+		}
+		return distanceSquared;
+	}
+
+
+	//****************************************************
+	// Squared distance from 'point' to the closest point of 'triangle', found by working out which of the triangle's
+	// regions (inside, one of the edges or one of the corners) the point projects into (Ericson, "Real-Time Collision
+	// Detection", 5.1.5)
+	//***************************************************
+	static float triangleDistanceSquared(const Eigen::Vector3f& point, const BVHTriangle& triangle) {
+		const Eigen::Vector3f& a = triangle.vertex0;
+		const Eigen::Vector3f& ab = triangle.edge1;
+		const Eigen::Vector3f& ac = triangle.edge2;
+		Eigen::Vector3f ap = point - a;
+		float d1 = ab.dot(ap), d2 = ac.dot(ap);
+		if (d1 <= 0.0f && d2 <= 0.0f) {
+			return ap.squaredNorm();
+		}
+
+		Eigen::Vector3f bp = ap - ab;
+		float d3 = ab.dot(bp), d4 = ac.dot(bp);
+		if (d3 >= 0.0f && d4 <= d3) {
+			return bp.squaredNorm();
+		}
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+			return (ap - (d1 / (d1 - d3)) * ab).squaredNorm();
+		}
+
+		Eigen::Vector3f cp = ap - ac;
+		float d5 = ab.dot(cp), d6 = ac.dot(cp);
+		if (d6 >= 0.0f && d5 <= d6) {
+			return cp.squaredNorm();
+		}
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+			return (ap - (d2 / (d2 - d6)) * ac).squaredNorm();
+		}
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+			return (bp - ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (ac - ab)).squaredNorm();
+		}
+
+		// Inside: the distance to the plane
+		float denominator = va + vb + vc;
+		if (!(denominator > 0.0f)) {
+			return std::min(ap.squaredNorm(), std::min(bp.squaredNorm(), cp.squaredNorm()));
+		}
+		return (ap - (vb / denominator) * ab - (vc / denominator) * ac).squaredNorm();
+	}
+
+
+	//****************************************************
+	// Moller-Trumbore ray-triangle test. On a hit closer than tMax, fills in 'hit' and returns true.
+	//***************************************************
+	static bool intersectTriangle(const Ray& ray, const BVHTriangle& triangle, float tMax, TriangleHit& hit) {
+		Eigen::Vector3f p = ray.direction.cross(triangle.edge2);
+		float determinant = triangle.edge1.dot(p);
+		if (fabs(determinant) < 1e-20f) {
+			return false;
+		}
+		float inverseDeterminant = 1.0f / determinant;
+
+		Eigen::Vector3f fromVertex = ray.position - triangle.vertex0;
+		float beta = fromVertex.dot(p) * inverseDeterminant;
+		if (beta < 0.0f || beta > 1.0f) {
+			return false;
+		}
+		Eigen::Vector3f q = fromVertex.cross(triangle.edge1);
+		float gamma = ray.direction.dot(q) * inverseDeterminant;
+		if (gamma < 0.0f || beta + gamma > 1.0f) {
+			return false;
+		}
+		float t = triangle.edge2.dot(q) * inverseDeterminant;
+		if (t < ray.t_min || t > tMax) {
+			return false;
+		}
+
+		hit.t = t;
+		hit.patchIndex = triangle.patchIndex;
+		hit.triangleIndex = triangle.triangleIndex;
+		hit.beta = beta;
+		hit.gamma = gamma;
+		return true;
+	}
+};
+
+
+#endif /* TRIANGLEBVH_H_ */
@@ -0,0 +1,104 @@
+/*
+ * VertexNormalGenerator.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VERTEXNORMALGENERATOR_H_
+#define VERTEXNORMALGENERATOR_H_
+
+#include <vector>
+#include <cmath>
+
+//****************************************************
+// Smooth vertex normals for triangle meshes given as index buffers (three indices per triangle), such as the
+// triangulated faces of .obj files.
+//
+// Every triangle contributes to each of its corners its normal weighted by both its area and the angle at that
+// corner, so long thin triangles neither dominate a vertex (as with area weights alone) nor do many small triangles
+// on one side of it (as with uniform weights). The triangles around every vertex are found through an adjacency
+// table built by counting sort, in time linear in the mesh size; the corner weights and then the normals of all
+// vertices are computed in parallel, every thread writing only its own range, so no locking is needed.
+//***************************************************
+class VertexNormalGenerator {
+	public:
+
+	// Sets normals[i], for every vertex i in [firstVertex, positions.size()), from the triangles [firstTriangle, end)
+	// of 'triangles' (which must only use those vertices). Vertices that no triangle uses get a zero normal, and
+	// vertices whose weighted triangle normals cancel out (as on a fin of two faces back to back) take the normal
+	// of their largest triangle instead, so that every vertex a triangle uses gets a unit normal.
+	static void compute(const std::vector<Eigen::Vector3f>& positions, const std::vector<unsigned int>& triangles,
+			int firstVertex, int firstTriangle, std::vector<Eigen::Vector3f>& normals) {
+		int numberOfVertices = positions.size() - firstVertex;
+		int numberOfTriangles = triangles.size() / 3 - firstTriangle;
+		const unsigned int* corners = triangles.empty() ? NULL : &triangles[3 * firstTriangle];
+		normals.resize(positions.size(), Eigen::Vector3f::Zero());
+		int numberOfThreads = numberOfWorkerThreads();
+
+		// Weighted normal of every corner
+		std::vector<Eigen::Vector3f> cornerNormals(3 * numberOfTriangles);
+		parallelForChunks(numberOfTriangles, numberOfThreads, [&](int, int begin, int end) {
+			for (int t = begin; t < end; t++) {
+				const Eigen::Vector3f* points[3] = {&positions[corners[3 * t]], &positions[corners[3 * t + 1]],
+						&positions[corners[3 * t + 2]]};
+				// Twice the area of the triangle, along its normal
+				Eigen::Vector3f areaNormal = (*points[1] - *points[0]).cross(*points[2] - *points[0]);
+				for (int k = 0; k < 3; k++) {
+					Eigen::Vector3f toNext = *points[(k + 1) % 3] - *points[k];
+					Eigen::Vector3f toPrevious = *points[(k + 2) % 3] - *points[k];
+					float angle = atan2(toNext.cross(toPrevious).norm(), toNext.dot(toPrevious));
+					cornerNormals[3 * t + k] = angle * areaNormal;
+				}
+			}
+		});
+
+		// Corners around every vertex: those of vertex i are cornersAround[firstCorner[i], firstCorner[i + 1])
+		std::vector<int> firstCorner(numberOfVertices + 1, 0);
+		for (int c = 0; c < 3 * numberOfTriangles; c++) {
+			firstCorner[corners[c] - firstVertex + 1]++;
+		}
+		for (int i = 0; i < numberOfVertices; i++) {
+			firstCorner[i + 1] += firstCorner[i];
+		}
+		std::vector<int> cornersAround(3 * numberOfTriangles);
+		std::vector<int> nextCorner(firstCorner.begin(), firstCorner.end() - 1);
+		for (int c = 0; c < 3 * numberOfTriangles; c++) {
+			cornersAround[nextCorner[corners[c] - firstVertex]++] = c;
+		}
+
+		parallelForChunks(numberOfVertices, numberOfThreads, [&](int, int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+				float totalWeight = 0.0f;
+				for (int k = firstCorner[i]; k < firstCorner[i + 1]; k++) {
+					normal += cornerNormals[cornersAround[k]];
+					totalWeight += cornerNormals[cornersAround[k]].norm();
+				}
+				if (firstCorner[i] < firstCorner[i + 1] && normal.norm() <= 1e-6f * totalWeight) {
+					normal = largestTriangleNormal(positions, corners, cornersAround, firstCorner[i], firstCorner[i + 1]);
+				}
+				normals[firstVertex + i] = normal.squaredNorm() > 0.0f ? Eigen::Vector3f(normal.normalized()) : normal;
+			}
+		});
+	}
+
+	private:
+
+	// Area normal of the largest of the triangles at corners cornersAround[begin, end); if all of them have zero
+	// area, which leaves nothing to go by, +z
+	static Eigen::Vector3f largestTriangleNormal(const std::vector<Eigen::Vector3f>& positions, const unsigned int* corners,
+			const std::vector<int>& cornersAround, int begin, int end) {
+		Eigen::Vector3f largest = Eigen::Vector3f::Zero();
+		for (int k = begin; k < end; k++) {
+			const unsigned int* triangle = &corners[cornersAround[k] / 3 * 3];
+			Eigen::Vector3f areaNormal = (positions[triangle[1]] - positions[triangle[0]]).cross(positions[triangle[2]] - positions[triangle[0]]);
+			if (areaNormal.squaredNorm() > largest.squaredNorm()) {
+				largest = areaNormal;
+			}
+		}
+		return largest.squaredNorm() > 0.0f ? largest : Eigen::Vector3f(Eigen::Vector3f::UnitZ());
+	}
+};
+
+
+#endif /* VERTEXNORMALGENERATOR_H_ */
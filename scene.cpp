@@ -22,22 +22,79 @@
 #include <time.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <bitset>
 #include <algorithm>
+#include <utility>
+#include <queue>
+#include <map>
 
 
 #include "Eigen/Geometry"
+#include "Eigen/Eigenvalues"
+#include "Eigen/Sparse"
 
 #include "CurveLocalGeometry.h"
 #include "Camera.h"
 #include "DifferentialGeometry.h"
 #include "Triangle.h"
+#include "SubdivisionArena.h"
+#include "QuantizedMesh.h"
+#include "BasisTable.h"
+#include "BezierSubpatch.h"
 #include "BezierPatch.h"
+#include "SceneInstance.h"
+#include "TessellationCache.h"
+#include "Parallel.h"
+#include "MemoryAccount.h"
+#include "MeshDecimator.h"
+#include "IndexOptimizer.h"
+#include "PolygonTriangulator.h"
+#include "VertexNormalGenerator.h"
+#include "BezierSurfaceFitter.h"
+#include "CatmullClarkPatcher.h"
+#include "PatchRetessellator.h"
+#include "ControlPointAnimation.h"
+#include "SoftwareRasterizer.h"
+#include "Ray.h"
+#include "TraversalStack.h"
+#include "PatchRayTracer.h"
+#include "TriangleBVH.h"
 
 inline float sqr(float x) { return x*x; }
 
 using namespace std;
 
+//****************************************************
+// Optional heap allocation counter (compile with -DCOUNT_ALLOCATIONS).
+// Every call to the global operator new bumps heapAllocationCount, which
+// lets myDisplay() check that drawing a frame never touches the heap.
+//****************************************************
+#ifdef COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+std::atomic<unsigned long> heapAllocationCount(0);
+
+void* operator new(std::size_t size) {
+	heapAllocationCount++;
+	void* memory = malloc(size == 0 ? 1 : size);
+	if (memory == NULL) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept {
+	free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	free(memory);
+}
+#endif
+
 //****************************************************
 // Some Classes
 //****************************************************
@@ -61,14 +118,84 @@ string filename;
 string subdivisionMethod;
 float subdivisionParameter;
 int numberOfBezierPatches;
+
+// Adaptive subdivision options: depth-first (bounded memory) traversal instead of breadth-first,
+// the maximum number of times a triangle may be split, and the maximum number of triangles per patch
+bool DEPTH_FIRST_ADAPTIVE;
+int maxSubdivisionDepth;
+int maxTrianglesPerPatch;
+
+// How adaptive subdivision decides whether to split an edge (-metric), and its name for printing
+AdaptiveSplitMetric adaptiveMetric;
+string adaptiveMetricName;
+
+// Total number of triangles that triangle-budget subdivision may produce for the whole scene
+int triangleBudget;
+
+// Decimation after tessellation (-decimate, -decimateerror): the number of triangles to simplify the whole scene
+// down to (0 for no target), and the largest error a collapse may introduce (0 for no bound)
+bool DECIMATE;
+int decimationTarget;
+float decimationError;
+
+// Vertex-cache ordering of every patch's triangles, drawn from index buffers (-optimizeindices), and triangle strips
+// for uniformly subdivided patches (-strips, which implies -optimizeindices)
+bool OPTIMIZE_INDICES;
+bool USE_TRIANGLE_STRIPS;
+
+// Keep the tessellation (in memory and in the tessellation cache) as quantized vertices (-quantize)
+bool QUANTIZE;
+
+// Memory taken by the tessellations of all patches, and the most they may take (-memorylimit, no limit by default)
+MemoryAccount tessellationAccount;
 std::vector<BezierPatch> listOfBezierPatches;
 
 std::vector<Eigen::Vector3f> objFileVertices;
-std::vector<std::vector<DifferentialGeometry> > objFilePolygonList;
+
+// The faces of all .obj files as they are given, before triangulation: face f has the corners
+// objFilePolygonCorners[objFilePolygonStarts[f], polygonEnd(f)), which are indices into objFileVertices
+std::vector<unsigned int> objFilePolygonCorners;
+std::vector<unsigned int> objFilePolygonStarts;
+
+// The faces of all .obj files, triangulated when they are loaded: three indices into objFileVertices per triangle,
+// the face each triangle belongs to, and which of its edges (flagged as in RasterTriangle::edgeFlags) are on the
+// outline of that face. objFileNormals holds the normal of every vertex (from the file's vn lines, or computed by
+// VertexNormalGenerator), and objFileOutlines the edges of every face, as pairs of indices into objFileVertices, for
+// the wireframe modes. Vertices that the file gives several different normals are duplicated, one copy per normal,
+// at the end of objFileVertices.
+std::vector<unsigned int> objFileTriangles;
+std::vector<int> objFileTriangleFaces;
+std::vector<unsigned char> objFileTriangleEdgeFlags;
+std::vector<Eigen::Vector3f> objFileNormals;
+std::vector<unsigned int> objFileOutlines;
+
+// One past the last corner of .obj face 'polygon' in objFilePolygonCorners
+unsigned int polygonEnd(int polygon) {
+	return polygon + 1 < (int) objFilePolygonStarts.size() ? objFilePolygonStarts[polygon + 1] : objFilePolygonCorners.size();
+}
 bool objMode;
 string objFilenameOutput;
 bool WRITE_OBJ;
 
+// Conversion of .obj files to .bez files (-o in .obj mode), and the size of the fitted patches relative to the
+// bounding box diagonal of the .obj file (-patchsize)
+string bezFilenameOutput;
+bool WRITE_BEZ;
+float fitPatchSize;
+
+// Turn .obj files into bicubic patches approximating their Catmull-Clark limit surfaces, which are then tessellated
+// like .bez files (-catmullclark)
+bool CATMULL_CLARK;
+
+// The scene is assembled from one or more input files: every unique file is an asset (loaded and tessellated once,
+// into a range of listOfBezierPatches or objFilePolygonStarts), and every placement of an asset is an instance.
+// A single input file is one asset with one untransformed instance.
+std::vector<SceneAsset> sceneAssets;
+std::vector<SceneInstance> sceneInstances;
+
+// On-disk cache of tessellated .bez files (disabled unless a directory is given with -cache)
+TessellationCache tessellationCache;
+
 // ***** Display-related global variables ***** //
 
 // if false, then in flat shading mode
@@ -81,6 +208,78 @@ bool HIDDEN_LINE_MODE;
 
 bool debug;
 
+// How triangle strips are drawn: with primitive restart (core since OpenGL 3.1, or the GL_NV_primitive_restart
+// extension) or with one draw call per strip. Decided in initScene(), once there is a context to ask.
+enum PrimitiveRestart { NO_PRIMITIVE_RESTART, CORE_PRIMITIVE_RESTART, NV_PRIMITIVE_RESTART };
+PrimitiveRestart primitiveRestart = NO_PRIMITIVE_RESTART;
+
+// Lighting, shared by the OpenGL viewer (initScene) and the software rasterizer
+const GLfloat AMBIENT_COLOR[] = {0.5f, 0.5f, 0.5f, 1.0f}; //Color(0.2, 0.2, 0.2)
+const GLfloat LIGHT_COLOR_0[] = {0.6f, 0.55f, 0.55f, 1.0f}; //Color (0.5, 0.5, 0.5)
+const GLfloat LIGHT_POSITION_0[] = {4.0f, 0.0f, 8.0f, 1.0f}; //Positioned at (4, 0, 8)
+const GLfloat LIGHT_COLOR_1[] = {0.6f, 0.5f, 0.4f, 1.0f}; //Color (0.5, 0.2, 0.2)
+const GLfloat LIGHT_POSITION_1[] = {-10.0f, 5.5f, 8.5f, 0.0f}; //Coming from the direction (-1, 0.5, 0.5)
+
+// ***** Headless rendering global variables ***** //
+
+// if true, render the scene with the software rasterizer into renderFilename instead of opening a window
+bool HEADLESS_RENDER;
+string renderFilename;
+int renderWidth, renderHeight;
+
+// One BVH over the tessellated triangles of each asset (shared by all of its instances),
+// used to pick the patch under the mouse in the viewer
+std::vector<TriangleBVH> pickingBVHs;
+
+// if true, trace one camera ray per pixel (of a -size image) against the exact patches and report rays per second
+bool RAY_BENCHMARK;
+
+// if > 0, measure how far the exact patches are from their tessellation, on a grid of this many samples per side of
+// every patch, report it patch by patch and quit (-errorreport n)
+int errorReportSamples;
+
+// ***** Animation global variables ***** //
+
+// if true, deform the .bez files over time (-animate twist|scale|wave), one animation per file, and bring the
+// tessellations of the patches that changed up to date every frame
+bool ANIMATE;
+string animationName;
+std::vector<ControlPointAnimation> animations;
+PatchRetessellator retessellator;
+
+// whether the tessellations changed since the picking BVHs were built
+bool pickingBVHsStale = false;
+
+#ifdef COUNT_ALLOCATIONS
+// number of frames drawn so far, used to report the allocation count of the first frame
+unsigned long framesDrawn = 0;
+#endif
+
+
+//****************************************************
+// Works out which kind of primitive restart the current OpenGL context supports, if any. Having the enums and
+// entry points in the headers we compiled against says nothing about the driver we run on.
+//***************************************************
+PrimitiveRestart detectPrimitiveRestart() {
+#ifdef GL_VERSION_3_1
+	const char* version = (const char*) glGetString(GL_VERSION);
+	int major = 0, minor = 0;
+	if (version != NULL && sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 3 || (major == 3 && minor >= 1))) {
+		return CORE_PRIMITIVE_RESTART;
+	}
+#endif
+#ifdef GL_NV_primitive_restart
+	const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+	string name = "GL_NV_primitive_restart";
+	// (whole names only, the list is separated by spaces)
+	for (const char* found = extensions; found != NULL && (found = strstr(found, name.c_str())) != NULL; found += name.size()) {
+		if ((found == extensions || found[-1] == ' ') && (found[name.size()] == ' ' || found[name.size()] == '\0')) {
+			return NV_PRIMITIVE_RESTART;
+		}
+	}
+#endif
+	return NO_PRIMITIVE_RESTART;
+}
 
 
 //****************************************************
@@ -90,26 +289,17 @@ void initScene(){
 
 	// Hard code various diffuse and specular constants
 	// NOTE: Probably should change this, I copied it from online...
+	// NOTE: The display modes (SMOOTH_SHADING etc.) are initialized in main(), so they can be set from the command line
 
-	SMOOTH_SHADING = true;
-	WIREFRAME_MODE = true;
-	HIDDEN_LINE_MODE = false;
-
-	GLfloat ambientColor[] = {0.5f, 0.5f, 0.5f, 1.0f}; //Color(0.2, 0.2, 0.2)
-	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambientColor);
+	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, AMBIENT_COLOR);
 
 	//Add directed light
-	GLfloat lightColor1[] = {0.6f, 0.5f, 0.4f, 1.0f}; //Color (0.5, 0.2, 0.2)
-	//Coming from the direction (-1, 0.5, 0.5)
-	GLfloat lightPos1[] = {-10.0f, 5.5f, 8.5f, 0.0f};
-	glLightfv(GL_LIGHT1, GL_DIFFUSE, lightColor1);
-	glLightfv(GL_LIGHT1, GL_POSITION, lightPos1);
+	glLightfv(GL_LIGHT1, GL_DIFFUSE, LIGHT_COLOR_1);
+	glLightfv(GL_LIGHT1, GL_POSITION, LIGHT_POSITION_1);
 
 	//Add positioned light
-	GLfloat lightColor0[] = {0.6f, 0.55f, 0.55f, 1.0f}; //Color (0.5, 0.5, 0.5)
-	GLfloat lightPos0[] = {4.0f, 0.0f, 8.0f, 1.0f}; //Positioned at (4, 0, 8)
-	glLightfv(GL_LIGHT0, GL_DIFFUSE, lightColor0);
-	glLightfv(GL_LIGHT0, GL_POSITION, lightPos0);
+	glLightfv(GL_LIGHT0, GL_DIFFUSE, LIGHT_COLOR_0);
+	glLightfv(GL_LIGHT0, GL_POSITION, LIGHT_POSITION_0);
 
 	glEnable(GL_LIGHTING);
 	glEnable(GL_LIGHT0);
@@ -117,6 +307,15 @@ void initScene(){
 	glEnable(GL_DEPTH_TEST);
 //	glEnable(GL_CULL_FACE);
 
+	// Scaled instances scale their normals too
+	glEnable(GL_NORMALIZE);
+
+	primitiveRestart = detectPrimitiveRestart();
+	if (debug) {
+		const char* names[] = {"none (one draw call per strip)", "OpenGL 3.1", "GL_NV_primitive_restart"};
+		std::cout << "  Primitive restart: " << names[primitiveRestart] << ".\n";
+	}
+
 }
 
 
@@ -142,52 +341,144 @@ void myReshape(int w, int h) {
 
 
 //****************************************************
-// function that does the actual drawing of stuff
+// Draws the triangulated faces of the .obj file 'asset' in the current display mode, with one draw call per pass
+// (the wireframe modes draw the outlines of the faces rather than their triangles)
 //***************************************************
-void myDisplay() {
-
-	// clear the color buffer
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glMatrixMode(GL_PROJECTION);
-
-	// make sure transformation is "zero'd"
-	glLoadIdentity();
-
-	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
+void drawObjPolygons(const SceneAsset& asset) {
+	if (asset.numberOfObjTriangles == 0) {
+		return;
+	}
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(Eigen::Vector3f), objFileVertices[0].data());
+	glNormalPointer(GL_FLOAT, sizeof(Eigen::Vector3f), objFileNormals[0].data());
+	const unsigned int* triangles = &objFileTriangles[3 * asset.firstObjTriangle];
+
+	if (WIREFRAME_MODE) {
+		glDisable(GL_LIGHTING);
+		glColor3f(1.0f, 1.0f, 1.0f);
+		glDrawElements(GL_LINES, asset.numberOfOutlineIndices, GL_UNSIGNED_INT, &objFileOutlines[asset.firstOutlineIndex]);
+
+		// Hide the lines behind the faces by filling them in black, slightly further back
+		if (HIDDEN_LINE_MODE) {
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			glEnable(GL_POLYGON_OFFSET_FILL);
+			glPolygonOffset(1.0, 1.0);
+			glColor3f(0.0, 0.0, 0.0);
+			glDrawElements(GL_TRIANGLES, 3 * asset.numberOfObjTriangles, GL_UNSIGNED_INT, triangles);
+			glDisable(GL_POLYGON_OFFSET_FILL);
+		}
+	} else {
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glEnable(GL_LIGHTING);
+		glDrawElements(GL_TRIANGLES, 3 * asset.numberOfObjTriangles, GL_UNSIGNED_INT, triangles);
+	}
 
-	// set OpenGL viewport
-	glViewport(0, 0, viewport.w, viewport.h);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
 
-	gluPerspective(camera.FIELD_OF_VIEW * camera.ZOOM_AMOUNT, aspect_ratio, camera.zNear, camera.zFar);
 
-	// set shading of model to smooth or flat, based on our global variable
-	if (SMOOTH_SHADING) {
-		glShadeModel(GL_SMOOTH);
+//****************************************************
+// Draws a patch from its index buffers with vertex arrays, straight out of listOfDifferentialGeometries (or out of
+// 'decodedVertices', for compressed patches): as triangle strips with primitive restart if it has them, as indexed
+// triangles (in their cache-optimized order) otherwise
+//***************************************************
+void drawIndexedBezierPatch(const BezierPatch& patch, const std::vector<DifferentialGeometry>& decodedVertices) {
+	const DifferentialGeometry& first = patch.isCompressed() ? decodedVertices[0] : patch.listOfDifferentialGeometries[0];
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(DifferentialGeometry), first.position.data());
+	glNormalPointer(GL_FLOAT, sizeof(DifferentialGeometry), first.normal.data());
+
+	if (!patch.triangleStrips.empty()) {
+		switch (primitiveRestart) {
+#ifdef GL_VERSION_3_1
+		case CORE_PRIMITIVE_RESTART:
+			glEnable(GL_PRIMITIVE_RESTART);
+			glPrimitiveRestartIndex(IndexOptimizer::RESTART_INDEX);
+			glDrawElements(GL_TRIANGLE_STRIP, patch.triangleStrips.size(), GL_UNSIGNED_INT, &patch.triangleStrips[0]);
+			glDisable(GL_PRIMITIVE_RESTART);
+			break;
+#endif
+#ifdef GL_NV_primitive_restart
+		case NV_PRIMITIVE_RESTART:
+			glEnableClientState(GL_PRIMITIVE_RESTART_NV);
+			glPrimitiveRestartIndexNV(IndexOptimizer::RESTART_INDEX);
+			glDrawElements(GL_TRIANGLE_STRIP, patch.triangleStrips.size(), GL_UNSIGNED_INT, &patch.triangleStrips[0]);
+			glDisableClientState(GL_PRIMITIVE_RESTART_NV);
+			break;
+#endif
+		default:
+			// No primitive restart: one draw call per strip (all strips have the same length)
+			int stripLength = 2 * (patch.uniformSteps + 1);
+			for (std::vector<unsigned int>::size_type k = 0; k < patch.triangleStrips.size(); k += stripLength + 1) {
+				glDrawElements(GL_TRIANGLE_STRIP, stripLength, GL_UNSIGNED_INT, &patch.triangleStrips[k]);
+			}
+			break;
+		}
 	} else {
-		glShadeModel(GL_FLAT);
+		glDrawElements(GL_TRIANGLES, patch.indices.size(), GL_UNSIGNED_INT, &patch.indices[0]);
 	}
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
 
-	// Set camera, via the following:
-	// void gluLookAt(GLdouble eyeX, GLdouble eyeY, GLdouble eyeZ, GLdouble centerX, GLdouble centerY,
-	//                GLdouble centerZ, GLdouble upX, GLdouble upY, GLdouble upZ);
-	gluLookAt(camera.position.x(), camera.position.y(), camera.position.z(), camera.lookAt.x(), camera.lookAt.y(),
-			camera.lookAt.z(), camera.up.x(), camera.up.y(), camera.up.z());
 
-	// Handle rotations
-	glRotatef(camera.X_ROTATION_AMOUNT, 1, 0, 0);
-	glRotatef(camera.Y_ROTATION_AMOUNT, 0, 1, 0);
-	glRotatef(camera.Z_ROTATION_AMOUNT, 0, 0, 1);
+//****************************************************
+// Draws the triangles of the Bezier patches listOfBezierPatches[begin, end) in the current display mode
+//***************************************************
+void drawBezierPatches(int begin, int end) {
+	/*
+	Begin drawing all of the triangles
+	PSUEDOCODE:
+
+	for each BezierPatch in the scene's list of Bezier patches:
+		for each Triangle in the current Bezier patch's list of triangles
+			Grab the three vertices of the triangle and render the triangle
+
+	 */
+
+	// Iterate through each of our BezierPatches...
+	static std::vector<DifferentialGeometry> decodedVertices;
+	for (int i = begin; i < end; i++) {
+		const BezierPatch& currentBezierPatch = listOfBezierPatches[i];
+
+		// Patches with index buffers are drawn with one call per pass (compressed patches are decoded first)
+		if (!currentBezierPatch.indices.empty()) {
+			if (currentBezierPatch.isCompressed()) {
+				currentBezierPatch.compressedMesh.decode(decodedVertices);
+			}
+			if (WIREFRAME_MODE) {
+				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+				glDisable(GL_LIGHTING);
+				glColor3f(1.0f, 1.0f, 1.0f);
+				drawIndexedBezierPatch(currentBezierPatch, decodedVertices);
 
-	// Handle translations
-	glTranslatef(camera.X_TRANSLATION_AMOUNT, camera.Y_TRANSLATION_AMOUNT, camera.Z_TRANSLATION_AMOUNT);
+				// Hide the lines behind the patch by filling it in black, slightly further back
+				if (HIDDEN_LINE_MODE) {
+					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+					glEnable(GL_POLYGON_OFFSET_FILL);
+					glPolygonOffset(1.0, 1.0);
+					glColor3f(0.0, 0.0, 0.0);
+					drawIndexedBezierPatch(currentBezierPatch, decodedVertices);
+					glDisable(GL_POLYGON_OFFSET_FILL);
+				}
+			} else {
+				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+				glEnable(GL_LIGHTING);
+				drawIndexedBezierPatch(currentBezierPatch, decodedVertices);
+			}
+			continue;
+		}
+
+		for (std::vector<Triangle>::size_type j = 0; j < currentBezierPatch.listOfTriangles.size(); j++) {
+			const Triangle& currentTriangleToDraw = currentBezierPatch.listOfTriangles[j];
 
-	if (objMode) {
-		for (std::vector<std::vector<DifferentialGeometry> >::size_type j = 0; j < objFilePolygonList.size(); j++) {
-			std::vector<DifferentialGeometry> currentPolygonToDraw = objFilePolygonList[j];
+			const DifferentialGeometry& point1 = currentTriangleToDraw.point1;
+			const DifferentialGeometry& point2 = currentTriangleToDraw.point2;
+			const DifferentialGeometry& point3 = currentTriangleToDraw.point3;
 
 			if (WIREFRAME_MODE) {
 				if (HIDDEN_LINE_MODE) {
@@ -200,11 +491,15 @@ void myDisplay() {
 
 					glBegin(GL_POLYGON);
 
-					for (std::vector<DifferentialGeometry>::size_type k = 0; k < currentPolygonToDraw.size(); k++) {
-						glVertex3f(currentPolygonToDraw[k].position.x(),
-								currentPolygonToDraw[k].position.y(),
-								currentPolygonToDraw[k].position.z());
-					}
+					// Set vertex and normals of all three points of the current triangle
+					glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
+					glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
+					glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
+					glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
+					glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
+					glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
+
+					glEnd();
 
 					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 					glEnable(GL_POLYGON_OFFSET_FILL);
@@ -213,15 +508,16 @@ void myDisplay() {
 					glColor3f(0.0, 0.0, 0.0);
 
 					glBegin(GL_POLYGON);
-					for (std::vector<DifferentialGeometry>::size_type k = 0; k < currentPolygonToDraw.size(); k++) {
-						glVertex3f(currentPolygonToDraw[k].position.x(),
-								currentPolygonToDraw[k].position.y(),
-								currentPolygonToDraw[k].position.z());
-					}
+					glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
+					glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
+					glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
+					glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
+					glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
+					glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
+
 					glEnd();
 					glDisable(GL_POLYGON_OFFSET_FILL);
 
-
 				} else {
 					// Draw objects in wireframe mode
 					glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
@@ -233,11 +529,13 @@ void myDisplay() {
 
 					glBegin(GL_POLYGON);
 
-					for (std::vector<DifferentialGeometry>::size_type k = 0; k < currentPolygonToDraw.size(); k++) {
-						glVertex3f(currentPolygonToDraw[k].position.x(),
-								currentPolygonToDraw[k].position.y(),
-								currentPolygonToDraw[k].position.z());
-					}
+					// Set vertex and normals of all three points of the current triangle
+					glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
+					glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
+					glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
+					glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
+					glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
+					glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
 
 					glEnd();
 				}
@@ -252,124 +550,178 @@ void myDisplay() {
 
 				glBegin(GL_POLYGON);
 
-				// TODO: Account for normals in non-wireframe mode
-				for (std::vector<DifferentialGeometry>::size_type k = 0; k < currentPolygonToDraw.size(); k++) {
-					glVertex3f(currentPolygonToDraw[k].position.x(),
-							currentPolygonToDraw[k].position.y(),
-							currentPolygonToDraw[k].position.z());
+				// Set vertex and normals of all three points of the current triangle
+				glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
+				glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
+				glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
+				glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
+				glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
+				glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
+
+				glEnd();
+			}
+		}
+	}
+}
+
+
+
+//****************************************************
+// Sets up one animation (of the kind named by animationName) per .bez file, with the file's current control points
+// as the rest pose, and prepares its patches for retessellation
+//***************************************************
+void setUpAnimations() {
+	animations.resize(sceneAssets.size());
+	for (std::vector<SceneAsset>::size_type k = 0; k < sceneAssets.size(); k++) {
+		const SceneAsset& asset = sceneAssets[k];
+		if (asset.objMode) {
+			continue;
+		}
+		ControlPointAnimation& animation = animations[k];
+		animation.setRestPose(listOfBezierPatches, asset.firstPatch, asset.firstPatch + asset.numberOfPatches);
+		if (animationName == "twist") {
+			animation.twistDegrees = 90.0f;
+		} else if (animationName == "scale") {
+			animation.scaleAmount = 0.25f;
+		} else if (animationName == "wave") {
+			// A bump travelling along x, up and down along z, as keyframes over one period (the last one equals
+			// the first, so it loops)
+			Eigen::Vector3f minimum = Eigen::Vector3f::Constant(HUGE_VALF), maximum = Eigen::Vector3f::Constant(-HUGE_VALF);
+			for (std::vector<Eigen::Vector3f>::size_type j = 0; j < animation.restPose.size(); j++) {
+				minimum = minimum.cwiseMin(animation.restPose[j]);
+				maximum = maximum.cwiseMax(animation.restPose[j]);
+			}
+			float width = std::max(maximum.x() - minimum.x(), 1e-6f);
+			float amplitude = 0.1f * (maximum - minimum).norm();
+			const int numberOfKeyframes = 8;
+			for (int key = 0; key <= numberOfKeyframes; key++) {
+				float phase = 2.0 * M_PI * key / numberOfKeyframes;
+				std::vector<Eigen::Vector3f> offsets(animation.restPose.size());
+				for (std::vector<Eigen::Vector3f>::size_type j = 0; j < offsets.size(); j++) {
+					float x = (animation.restPose[j].x() - minimum.x()) / width;
+					offsets[j] = Eigen::Vector3f(0.0f, 0.0f, amplitude * sin(2.0 * M_PI * x - phase));
 				}
+				animation.addKeyframe(animation.period * key / numberOfKeyframes, offsets);
+			}
+		}
+
+		for (int i = asset.firstPatch; i < asset.firstPatch + asset.numberOfPatches; i++) {
+			retessellator.prepare(listOfBezierPatches[i]);
+		}
+	}
+}
 
 
-				glEnd();
+//****************************************************
+// Moves every animated file's control points to where they are 'time' seconds into its animation, and retessellates
+// the patches that changed, in parallel (one patch at a time per thread), keeping their triangles and index buffers
+//***************************************************
+void animateBezierPatches(float time) {
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+
+	static std::vector<int> changedPatches;
+	changedPatches.clear();
+	for (std::vector<SceneAsset>::size_type k = 0; k < sceneAssets.size(); k++) {
+		if (sceneAssets[k].objMode) {
+			continue;
+		}
+		animations[k].apply(listOfBezierPatches, time);
+		for (int i = sceneAssets[k].firstPatch; i < sceneAssets[k].firstPatch + sceneAssets[k].numberOfPatches; i++) {
+			if (listOfBezierPatches[i].controlPointsChanged) {
+				changedPatches.push_back(i);
 			}
 		}
+	}
+	if (changedPatches.empty()) {
+		return;
+	}
 
+	parallelForEach(changedPatches.size(), [&](int k) {
+		BezierPatch& patch = listOfBezierPatches[changedPatches[k]];
+		retessellator.retessellate(patch);
+		patch.controlPointsChanged = false;
+	});
+	pickingBVHsStale = true;
+
+	// Report the average update time now and then
+	static int framesAnimated = 0;
+	static double millisecondsAnimating = 0.0;
+	gettimeofday(&end, NULL);
+	millisecondsAnimating += (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+	if (debug && ++framesAnimated % 100 == 0) {
+		cout << "Animation: " << changedPatches.size() << " patches retessellated per frame, "
+				<< millisecondsAnimating / framesAnimated << " ms per frame on average.\n";
+	}
+}
 
-	} else {
 
-		/*
-		Begin drawing all of the triangles
-		PSUEDOCODE:
+//****************************************************
+// function that does the actual drawing of stuff
+//***************************************************
+void myDisplay() {
 
-		for each BezierPatch in the scene's list of Bezier patches:
-			for each Triangle in the current Bezier patch's list of triangles
-				Grab the three vertices of the triangle and render the triangle
+#ifdef COUNT_ALLOCATIONS
+	unsigned long allocationsBeforeFrame = heapAllocationCount;
+#endif
 
-		 */
+	if (ANIMATE) {
+		animateBezierPatches(glutGet(GLUT_ELAPSED_TIME) / 1000.0f);
+	}
 
-		// Iterate through each of our BezierPatches...
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			BezierPatch currentBezierPatch = listOfBezierPatches[i];
-			for (std::vector<Triangle>::size_type j = 0; j < currentBezierPatch.listOfTriangles.size(); j++) {
-				Triangle currentTriangleToDraw = currentBezierPatch.listOfTriangles[j];
-
-				DifferentialGeometry point1, point2, point3;
-				point1 = currentTriangleToDraw.point1;
-				point2 = currentTriangleToDraw.point2;
-				point3 = currentTriangleToDraw.point3;
-
-				if (WIREFRAME_MODE) {
-					if (HIDDEN_LINE_MODE) {
-						glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
-
-						glDisable(GL_LIGHTING);
-						glClearColor(0.0, 0.0, 0.0, 0.0);
-						// Default the drawing color to white
-						glColor3f(1.0f, 1.0f, 1.0f);
-
-						glBegin(GL_POLYGON);
-
-						// Set vertex and normals of all three points of the current triangle
-						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
-						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
-						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
-						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
-						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
-						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
-
-						glEnd();
-
-						glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-						glEnable(GL_POLYGON_OFFSET_FILL);
-						glPolygonOffset(1.0, 1.0);
-						glClearColor(0.0, 0.0, 0.0, 0.0);
-						glColor3f(0.0, 0.0, 0.0);
-
-						glBegin(GL_POLYGON);
-						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
-						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
-						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
-						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
-						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
-						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
-
-						glEnd();
-						glDisable(GL_POLYGON_OFFSET_FILL);
-
-					} else {
-						// Draw objects in wireframe mode
-						glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
-
-						glDisable(GL_LIGHTING);
-						glClearColor(0.0, 0.0, 0.0, 0.0);
-						// Default the drawing color to white
-						glColor3f(1.0f, 1.0f, 1.0f);
-
-						glBegin(GL_POLYGON);
-
-						// Set vertex and normals of all three points of the current triangle
-						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
-						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
-						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
-						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
-						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
-						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
-
-						glEnd();
-					}
+	// clear the color buffer
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	glMatrixMode(GL_PROJECTION);
 
-				} else {
-					// Draw objects in filled mode
-					glPolygonMode( GL_FRONT, GL_FILL);
-					glPolygonMode( GL_BACK, GL_FILL);
-					glClearColor(0.0, 0.0, 0.0, 0.0);
-					glEnable(GL_LIGHTING);
+	// make sure transformation is "zero'd"
+	glLoadIdentity();
 
-					glBegin(GL_POLYGON);
+	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
 
-					// Set vertex and normals of all three points of the current triangle
-					glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
-					glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
-					glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
-					glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
-					glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
-					glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
+	// set OpenGL viewport
+	glViewport(0, 0, viewport.w, viewport.h);
 
-					glEnd();
-				}
-			}
+	gluPerspective(camera.FIELD_OF_VIEW * camera.ZOOM_AMOUNT, aspect_ratio, camera.zNear, camera.zFar);
+
+	// set shading of model to smooth or flat, based on our global variable
+	if (SMOOTH_SHADING) {
+		glShadeModel(GL_SMOOTH);
+	} else {
+		glShadeModel(GL_FLAT);
+	}
+
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	// Set camera, via the following:
+	// void gluLookAt(GLdouble eyeX, GLdouble eyeY, GLdouble eyeZ, GLdouble centerX, GLdouble centerY,
+	//                GLdouble centerZ, GLdouble upX, GLdouble upY, GLdouble upZ);
+	gluLookAt(camera.position.x(), camera.position.y(), camera.position.z(), camera.lookAt.x(), camera.lookAt.y(),
+			camera.lookAt.z(), camera.up.x(), camera.up.y(), camera.up.z());
+
+	// Handle rotations
+	glRotatef(camera.X_ROTATION_AMOUNT, 1, 0, 0);
+	glRotatef(camera.Y_ROTATION_AMOUNT, 0, 1, 0);
+	glRotatef(camera.Z_ROTATION_AMOUNT, 0, 0, 1);
+
+	// Handle translations
+	glTranslatef(camera.X_TRANSLATION_AMOUNT, camera.Y_TRANSLATION_AMOUNT, camera.Z_TRANSLATION_AMOUNT);
+
+	// Draw every instance of every asset, reusing the asset's tessellation under the instance's transformation
+	GLfloat instanceMatrix[16];
+	for (std::vector<SceneInstance>::size_type i = 0; i < sceneInstances.size(); i++) {
+		const SceneAsset& asset = sceneAssets[sceneInstances[i].assetIndex];
+		sceneInstances[i].openGLMatrix(instanceMatrix);
+
+		glPushMatrix();
+		glMultMatrixf(instanceMatrix);
+		if (asset.objMode) {
+			drawObjPolygons(asset);
+		} else {
+			drawBezierPatches(asset.firstPatch, asset.firstPatch + asset.numberOfPatches);
 		}
+		glPopMatrix();
 	}
 
 
@@ -377,6 +729,15 @@ void myDisplay() {
 
 	glFlush();
 	glutSwapBuffers();					// swap buffers (we earlier set double buffer)
+
+#ifdef COUNT_ALLOCATIONS
+	// Drawing a frame should never allocate; report the first frame, and any frame that does allocate
+	unsigned long allocationsDuringFrame = heapAllocationCount - allocationsBeforeFrame;
+	if (debug && (framesDrawn == 0 || allocationsDuringFrame != 0)) {
+		cout << "Frame " << framesDrawn << " performed " << allocationsDuringFrame << " heap allocations.\n";
+	}
+	framesDrawn++;
+#endif
 }
 
 
@@ -516,35 +877,155 @@ void handleSpecialKeypress(int key, int x, int y) {
 
 
 //****************************************************
-// function that prints all of our command line option variables
-//***************************************************
-void printCommandLineOptionVariables( )
-{
-	if (debug)
-	{
-		cout << "\nBezier file: " << filename << "\n";
-		cout << "Subdivision Parameter: " << subdivisionParameter << "\n";
-		cout << "Subdivision Method: " << subdivisionMethod << "\n\n";
+// Returns the camera ray through the point (ndcX, ndcY) of the screen (in normalized device coordinates, so -1 to 1),
+// going from the near plane (t = 0) to the far plane (t = 1). 'inverseViewProjection' is the inverse of the
+// camera's projection * model view matrix.
+//****************************************************
+Ray cameraRay(const Eigen::Matrix4f& inverseViewProjection, float ndcX, float ndcY) {
+	Eigen::Vector4f nearPoint = inverseViewProjection * Eigen::Vector4f(ndcX, ndcY, -1.0f, 1.0f);
+	Eigen::Vector4f farPoint = inverseViewProjection * Eigen::Vector4f(ndcX, ndcY, 1.0f, 1.0f);
+	Eigen::Vector3f origin = nearPoint.head<3>() / nearPoint.w();
+	Eigen::Vector3f direction = farPoint.head<3>() / farPoint.w() - origin;
+	return Ray(origin, direction, 0.0f, 1.0f);
+}
 
-		cout << "We currently have " << listOfBezierPatches.size() << " Bezier patches.\n\n";
-		// Iterate through Bezier Patches
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			cout << "  Bezier patch " << (i + 1) << ":\n\n";
-			std::vector<std::vector <Eigen::Vector3f> > curves = listOfBezierPatches[i].listOfCurves;
 
-			// Iterate through curves in each Bezier patch
-			for (std::vector<std::vector <Eigen::Vector3f> >::size_type j = 0; j < curves.size(); j++) {
-				std::vector<Eigen::Vector3f> listOfPointsForCurrentCurve = curves[j];
+// (defined below, with the other BVH code)
+void buildTriangleBVH(TriangleBVH& bvh, const SceneAsset& asset);
 
-				cout << "    Curve " << (j + 1) << ":\n";
 
-				// Iterate through points in current curve and print them
-				for (std::vector<Eigen::Vector3f>::size_type k = 0; k < listOfPointsForCurrentCurve.size(); k++) {
-					printf("    (%f, %f, %f)\n", listOfPointsForCurrentCurve[k].x(), listOfPointsForCurrentCurve[k].y(), listOfPointsForCurrentCurve[k].z());
-				}
-				cout << "\n\n";
-			}
-		}
+//****************************************************
+// function that handles mouse clicks: a left click picks the surface under the mouse and
+// prints which patch (and which (u, v) on it) was hit
+//***************************************************
+void handleMouseClick(int button, int state, int x, int y) {
+	if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN) {
+		return;
+	}
+
+	// Same camera as myDisplay(); GLUT measures y from the top of the window
+	Eigen::Matrix4f inverseViewProjection = (camera.projectionMatrix(((float) viewport.w) / ((float) viewport.h))
+			* camera.modelViewMatrix()).inverse();
+	float ndcX = 2.0f * (x + 0.5f) / viewport.w - 1.0f;
+	float ndcY = 1.0f - 2.0f * (y + 0.5f) / viewport.h;
+
+	Ray ray = cameraRay(inverseViewProjection, ndcX, ndcY);
+
+	// Animated patches moved since the BVHs were built
+	if (pickingBVHsStale) {
+		for (std::vector<SceneAsset>::size_type i = 0; i < sceneAssets.size(); i++) {
+			if (!sceneAssets[i].objMode) {
+				buildTriangleBVH(pickingBVHs[i], sceneAssets[i]);
+			}
+		}
+		pickingBVHsStale = false;
+	}
+
+	// Find the closest hit over all instances, by intersecting the ray (moved into each instance's own coordinates,
+	// which keeps its parameter t) with the BVH of the instance's asset
+	TriangleHit hit;
+	int hitInstance = -1;
+	for (std::vector<SceneInstance>::size_type i = 0; i < sceneInstances.size(); i++) {
+		const SceneInstance& instance = sceneInstances[i];
+		Eigen::Matrix3f inverseLinear = instance.linear.inverse();
+		Ray localRay(inverseLinear * (ray.position - instance.translation), inverseLinear * ray.direction, ray.t_min, ray.t_max);
+		if (pickingBVHs[instance.assetIndex].intersect(localRay, hit)) {
+			ray.t_max = hit.t;
+			hitInstance = i;
+		}
+	}
+	if (hitInstance < 0) {
+		cout << "Picked nothing.\n";
+		return;
+	}
+
+	const SceneInstance& instance = sceneInstances[hitInstance];
+	const SceneAsset& asset = sceneAssets[instance.assetIndex];
+	if (sceneInstances.size() > 1) {
+		cout << "Picked instance " << hitInstance << " of " << asset.filename << ", ";
+	} else {
+		cout << "Picked ";
+	}
+
+	// Patches and faces are numbered from the start of their own file
+	if (asset.objMode) {
+		cout << "face " << (hit.patchIndex - asset.firstPolygon) << ".\n";
+		return;
+	}
+
+	Triangle triangle = listOfBezierPatches[hit.patchIndex].triangle(hit.triangleIndex);
+	Eigen::Vector2f uv = (1.0f - hit.beta - hit.gamma) * triangle.point1.uvValues + hit.beta * triangle.point2.uvValues
+			+ hit.gamma * triangle.point3.uvValues;
+	Eigen::Vector3f position = instance.transformPoint(listOfBezierPatches[hit.patchIndex].evaluateDifferentialGeometry(uv.x(), uv.y()).position);
+	cout << "patch " << (hit.patchIndex - asset.firstPatch) << " at (u, v) = (" << uv.x() << ", " << uv.y() << "), point ("
+			<< position.x() << ", " << position.y() << ", " << position.z() << ").\n";
+}
+
+
+//****************************************************
+// function that prints all of our command line option variables
+//***************************************************
+void printCommandLineOptionVariables( )
+{
+	if (debug)
+	{
+		cout << "\nBezier file: " << filename << "\n";
+		cout << "Subdivision Parameter: " << subdivisionParameter << "\n";
+		cout << "Subdivision Method: " << subdivisionMethod << "\n";
+		if (subdivisionMethod == "FLATNESS") {
+			cout << "Maximum subdivision depth: " << maxSubdivisionDepth << "\n";
+		}
+		if (subdivisionMethod == "BUDGET") {
+			cout << "Triangle budget: " << triangleBudget << "\n";
+		}
+		if (subdivisionMethod == "ADAPTIVE") {
+			cout << "Adaptive traversal: " << (DEPTH_FIRST_ADAPTIVE ? "depth-first" : "breadth-first") << "\n";
+			cout << "Adaptive split metric: " << adaptiveMetricName << "\n";
+			cout << "Maximum subdivision depth: " << maxSubdivisionDepth << "\n";
+			cout << "Maximum triangles per patch: " << maxTrianglesPerPatch << "\n";
+		}
+		if (tessellationAccount.isLimited()) {
+			cout << "Tessellation memory limit: " << tessellationAccount.limit / 1024 << " KB\n";
+		}
+		if (DECIMATE) {
+			cout << "Decimation target: " << decimationTarget << " triangles, maximum error: " << decimationError << "\n";
+		}
+		cout << "\n";
+
+		if (sceneInstances.size() > 1) {
+			cout << "Scene: " << sceneInstances.size() << " instances of " << sceneAssets.size() << " files.\n";
+			for (std::vector<SceneAsset>::size_type i = 0; i < sceneAssets.size(); i++) {
+				cout << "  " << sceneAssets[i].filename << ": ";
+				if (sceneAssets[i].objMode) {
+					cout << sceneAssets[i].numberOfPolygons << " polygons (" << sceneAssets[i].numberOfObjTriangles << " triangles)\n";
+				} else {
+					cout << sceneAssets[i].numberOfPatches << " Bezier patches\n";
+				}
+			}
+			cout << "\n";
+		}
+
+		cout << "We currently have " << listOfBezierPatches.size() << " Bezier patches.\n\n";
+		// Iterate through Bezier Patches
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+			cout << "  Bezier patch " << (i + 1) << " (" << (listOfBezierPatches[i].triangular ? "triangular, " : "") << "degree "
+					<< listOfBezierPatches[i].degreeU() << " x " << listOfBezierPatches[i].degreeV()
+					<< (listOfBezierPatches[i].isRational() ? ", rational" : "") << "):\n\n";
+			const std::vector<std::vector <Eigen::Vector3f> >& curves = listOfBezierPatches[i].listOfCurves;
+
+			// Iterate through curves in each Bezier patch
+			for (std::vector<std::vector <Eigen::Vector3f> >::size_type j = 0; j < curves.size(); j++) {
+				const std::vector<Eigen::Vector3f>& listOfPointsForCurrentCurve = curves[j];
+
+				cout << "    Curve " << (j + 1) << ":\n";
+
+				// Iterate through points in current curve and print them
+				for (std::vector<Eigen::Vector3f>::size_type k = 0; k < listOfPointsForCurrentCurve.size(); k++) {
+					printf("    (%f, %f, %f)\n", listOfPointsForCurrentCurve[k].x(), listOfPointsForCurrentCurve[k].y(), listOfPointsForCurrentCurve[k].z());
+				}
+				cout << "\n\n";
+			}
+		}
 
 		cout << "Display options:\n";
 		if (SMOOTH_SHADING) {
@@ -555,10 +1036,17 @@ void printCommandLineOptionVariables( )
 
 		if (WIREFRAME_MODE) {
 			cout << "  Wireframe mode is ON.\n";
+			if (HIDDEN_LINE_MODE) {
+				cout << "  Hidden-line mode is ON.\n";
+			}
 		} else {
 			cout << "  Filled mode is ON. (i.e. Wireframe mode is OFF)\n";
 		}
 
+		if (HEADLESS_RENDER) {
+			cout << "  Rendering " << renderWidth << "x" << renderHeight << " image to " << renderFilename << " without a window.\n";
+		}
+
 	}
 }
 
@@ -570,11 +1058,12 @@ void printTrianglesInBezierPatches() {
 	if (debug) {
 		// Iterate through Bezier Patches
 		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			cout << "  Bezier patch " << (i + 1) << ":\n\n";
+			cout << "  Bezier patch " << (i + 1) << " (degree " << listOfBezierPatches[i].degreeU() << " x "
+					<< listOfBezierPatches[i].degreeV() << (listOfBezierPatches[i].isRational() ? ", rational" : "") << "):\n\n";
 
 			// Iterate through Triangles in the current Bezier patch
 			for (std::vector<Triangle>::size_type j = 0; j < listOfBezierPatches[i].listOfTriangles.size(); j++) {
-				Triangle currentTriangle = listOfBezierPatches[i].listOfTriangles[j];
+				const Triangle& currentTriangle = listOfBezierPatches[i].listOfTriangles[j];
 				cout << "    Triangle " << (j + 1) << ":\n";
 				cout << "      " << currentTriangle.printTriangleInformation();
 			}
@@ -591,13 +1080,14 @@ void printDifferentialGeometriesInBezierPatches() {
 	if (debug) {
 		// Iterate through Bezier Patches
 		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			cout << "  Bezier patch " << (i + 1) << ":\n\n";
+			cout << "  Bezier patch " << (i + 1) << " (degree " << listOfBezierPatches[i].degreeU() << " x "
+					<< listOfBezierPatches[i].degreeV() << (listOfBezierPatches[i].isRational() ? ", rational" : "") << "):\n\n";
 
 			// Iterate through Triangles in the current Bezier patch
 			for (std::vector<DifferentialGeometry>::size_type j = 0; j < listOfBezierPatches[i].listOfDifferentialGeometries.size(); j++) {
-				DifferentialGeometry currentDifferentialGeometry = listOfBezierPatches[i].listOfDifferentialGeometries[j];
+				const DifferentialGeometry& currentDifferentialGeometry = listOfBezierPatches[i].listOfDifferentialGeometries[j];
 				cout << "    DifferentialGeometry " << (j + 1) << ":\n";
-				Eigen::Vector3f currentPosition = currentDifferentialGeometry.position;
+				const Eigen::Vector3f& currentPosition = currentDifferentialGeometry.position;
 				cout << "      (" << currentPosition.x() << " , " << currentPosition.y() << " , " << currentPosition.z() << ")\n";
 			}
 
@@ -613,8 +1103,9 @@ void printStatistics() {
 		cout << "\n  Statistics:\n\n";
 		// Iterate through Bezier Patches
 		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			cout << "    Bezier patch " << (i + 1) << " has " << listOfBezierPatches[i].listOfDifferentialGeometries.size()
-					<< " differential geometries and " << listOfBezierPatches[i].listOfTriangles.size() << " triangles.\n";
+			cout << "    Bezier patch " << (i + 1) << " has " << listOfBezierPatches[i].numberOfPoints()
+					<< " differential geometries and " << listOfBezierPatches[i].numberOfTriangles() << " triangles ("
+					<< listOfBezierPatches[i].tessellationMemory() << " bytes).\n";
 		}
 	}
 }
@@ -637,86 +1128,523 @@ void printCameraInformation() {
 }
 
 
+//****************************************************
+// Most triangles the next patch may be subdivided into without going over the memory limit, or 'maxTriangles'
+// if that is fewer ('limitedByMemory' tells which). Every triangle is counted with about one point (each split
+// adds as many points as triangles), and twice over for the slack the lists keep while they grow.
+//***************************************************
+int affordableTriangles(int maxTriangles, bool& limitedByMemory) {
+	limitedByMemory = false;
+	if (!tessellationAccount.isLimited()) {
+		return maxTriangles;
+	}
+	size_t room = tessellationAccount.fits(0) ? tessellationAccount.limit - tessellationAccount.currentBytes() : 0;
+	size_t triangles = room / (2 * (sizeof(Triangle) + sizeof(DifferentialGeometry)));
+	if (triangles < (size_t) maxTriangles) {
+		limitedByMemory = true;
+		return triangles;
+	}
+	return maxTriangles;
+}
+
+//****************************************************
+// Adds the memory listOfBezierPatches[i] takes to tessellationAccount (dropping the lists' slack first, if there
+// is a limit), and returns false if that goes over the limit
+//***************************************************
+bool accountForPatch(int i) {
+	if (tessellationAccount.isLimited()) {
+		listOfBezierPatches[i].shrinkTessellation();
+	}
+	tessellationAccount.add(listOfBezierPatches[i].tessellationMemory());
+	return !tessellationAccount.isOverLimit();
+}
+
 //****************************************************
 // Method that populates each BezierPatch's list of DifferentialGeometries
 // and list of Triangles, based on what kind of subdivision (i.e. adaptive or uniform)
-// we are performing
+// we are performing, for the patches listOfBezierPatches[begin, end), with 'parameter'
+// as the step size or the error
+//
+// The memory every patch takes is added to tessellationAccount, and no patch gets more triangles
+// than the room left under its limit holds. Returns false as soon as a patch does not fit (leaving
+// the patches tessellated so far as they are), so the caller can retry more coarsely.
 //***************************************************
-void perform_subdivision(bool adaptive_subdivision) {
+bool perform_subdivision(bool adaptive_subdivision, int begin, int end, float parameter) {
+	// Work queue storage for adaptive subdivision, shared by (and reset between) all patches
+	SubdivisionArena subdivisionArena;
+
+	// Every uniform grid has the same size (and its lists are allocated at exactly that size), so it can be
+	// checked before it is allocated (in doubles, since tiny step sizes would overflow)
+	double steps = floor((1.0 + 0.001) / parameter);
+	double gridMemory = (steps + 1) * (steps + 1) * sizeof(DifferentialGeometry) + 2 * steps * steps * sizeof(Triangle);
+
 	// Iterate through each of the Bezier patches...
-	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+	for (int i = begin; i < end; i++) {
 		if (adaptive_subdivision) {
-			listOfBezierPatches[i].performAdaptiveSubdivision(subdivisionParameter);
+			bool limitedByMemory;
+			int maxTriangles = affordableTriangles(maxTrianglesPerPatch, limitedByMemory);
+			bool complete = listOfBezierPatches[i].performAdaptiveSubdivision(parameter, subdivisionArena,
+					DEPTH_FIRST_ADAPTIVE, maxSubdivisionDepth, maxTriangles, adaptiveMetric);
+			if (!complete && limitedByMemory) {
+				return false;
+			}
 		} else {
-			listOfBezierPatches[i].performUniformSubdivision(subdivisionParameter);
+			if (tessellationAccount.isLimited() && tessellationAccount.currentBytes() + gridMemory > tessellationAccount.limit) {
+				return false;
+			}
+			listOfBezierPatches[i].performUniformSubdivision(parameter);
+
+		}
 
+		if (!accountForPatch(i)) {
+			return false;
 		}
 	}
 
+	return true;
 }
 
 
 
 
 //****************************************************
-// Writes an .obj file that represents this BezierPatch
+// Method that populates each BezierPatch's list of DifferentialGeometries
+// and list of Triangles by splitting the patches themselves until they are flat
+// ('parameter' is the maximum distance between the surface and its triangles),
+// for the patches listOfBezierPatches[begin, end)
+//
+// Accounts for memory like perform_subdivision.
 //***************************************************
-void generateObjFile(std::string filename) {
-	std::ofstream myfile;
-	myfile.open(filename);
+bool perform_flatness_subdivision(int begin, int end, float parameter) {
+	for (int i = begin; i < end; i++) {
+		bool limitedByMemory;
+		int maxTriangles = affordableTriangles(numeric_limits<int>::max(), limitedByMemory);
+		bool complete = listOfBezierPatches[i].performFlatnessSubdivision(parameter, maxSubdivisionDepth, maxTriangles);
+		if ((!complete && limitedByMemory) || !accountForPatch(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 
-	std::vector<Triangle> aggregateTriangleList;
+//****************************************************
+// Sets tessellationAccount to the memory all patches take now (after steps that change the
+// tessellations of many patches at once, such as decimation or quantization)
+//***************************************************
+void recountTessellationMemory() {
+	size_t bytes = 0;
 	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-		for (std::vector<Triangle>::size_type j = 0; j < listOfBezierPatches[i].listOfTriangles.size(); j++) {
-			aggregateTriangleList.push_back(listOfBezierPatches[i].listOfTriangles[j]);
+		bytes += listOfBezierPatches[i].tessellationMemory();
+	}
+	tessellationAccount.set(bytes);
+}
+
+
+//****************************************************
+// Method that populates each BezierPatch's list of DifferentialGeometries
+// and list of Triangles so that the patches listOfBezierPatches[begin, end) (normally the whole scene)
+// use at most triangleBudget triangles
+//
+// Every patch starts out as one subpatch (i.e. two triangles). All subpatches of the scene go into one
+// priority queue, ordered by their flatness error (which grows with both size and curvature), and the
+// worst one is split in half until another split would exceed the budget. The triangles therefore go
+// wherever the error is largest, regardless of which patch that is.
+//
+// The queue holds one kind of subpatch for the whole scene, so the small BicubicSubpatch is only used when
+// every patch is a polynomial bicubic one.
+//
+// Under a memory limit, splitting also stops once the queue and the triangles and points it turns into would
+// no longer fit; both are allocated at their final size up front, so they never take more than that. Returns
+// false if this stopped splitting before the budget did.
+//***************************************************
+template<class Subpatch>
+bool perform_budget_subdivision(int begin, int end) {
+	typedef PrioritizedSubpatch<Subpatch> QueueEntry;
+	long numberOfPatches = end - begin;
+
+	// Most subpatches the queue may hold. Every patch starts with one entry, two triangles and four points, and
+	// every split adds an entry, two triangles and at most two points (the new corners along the split).
+	long maxSubpatches = std::max((long) triangleBudget / 2, numberOfPatches);
+	bool limitedByMemory = false;
+	if (tessellationAccount.isLimited()) {
+		size_t room = tessellationAccount.fits(0) ? tessellationAccount.limit - tessellationAccount.currentBytes() : 0;
+		size_t patchMemory = numberOfPatches * (sizeof(QueueEntry) + 2 * sizeof(Triangle) + 4 * sizeof(DifferentialGeometry));
+		size_t splitMemory = sizeof(QueueEntry) + 2 * sizeof(Triangle) + 2 * sizeof(DifferentialGeometry);
+		long affordableSubpatches = numberOfPatches + (room > patchMemory ? (room - patchMemory) / splitMemory : 0);
+		if (affordableSubpatches < maxSubpatches) {
+			maxSubpatches = affordableSubpatches;
+			limitedByMemory = true;
+		}
+	}
+
+	// (without a limit the queue just grows: a huge budget may never be used up, if the error reaches 0 first)
+	std::vector<QueueEntry> queueStorage;
+	if (tessellationAccount.isLimited()) {
+		queueStorage.reserve(maxSubpatches);
+	}
+	size_t queueMemory = queueStorage.capacity() * sizeof(QueueEntry);
+	tessellationAccount.add(queueMemory);
+	std::priority_queue<QueueEntry> queueOfSubpatches(std::less<QueueEntry>(), std::move(queueStorage));
+	for (int i = begin; i < end; i++) {
+		queueOfSubpatches.push(QueueEntry(Subpatch(listOfBezierPatches[i].listOfCurves, listOfBezierPatches[i].weights, i)));
+	}
+
+	// Every subpatch becomes two triangles, so each split costs two more triangles
+	long numberOfTriangles = 2 * (long) queueOfSubpatches.size();
+	if (numberOfTriangles > triangleBudget) {
+		cerr << "Triangle budget of " << triangleBudget << " is too small for " << (end - begin)
+				<< " patches, using " << numberOfTriangles << " triangles.\n";
+	}
+
+	std::vector<int> subpatchesOfPatch(listOfBezierPatches.size(), 1);
+	Subpatch firstHalf, secondHalf;
+	while (numberOfTriangles + 2 <= triangleBudget && (long) queueOfSubpatches.size() < maxSubpatches
+			&& !queueOfSubpatches.empty() && queueOfSubpatches.top().error > 0.0f) {
+		Subpatch worstSubpatch = queueOfSubpatches.top().subpatch;
+		queueOfSubpatches.pop();
+
+		worstSubpatch.split(firstHalf, secondHalf);
+		queueOfSubpatches.push(QueueEntry(firstHalf));
+		queueOfSubpatches.push(QueueEntry(secondHalf));
+		numberOfTriangles += 2;
+		subpatchesOfPatch[worstSubpatch.patchIndex]++;
+	}
+
+	bool cutShort = limitedByMemory && numberOfTriangles + 2 <= triangleBudget && !queueOfSubpatches.empty()
+			&& queueOfSubpatches.top().error > 0.0f;
+	if (cutShort) {
+		cerr << "Triangle budget of " << triangleBudget << " does not fit in the memory limit of "
+				<< tessellationAccount.limit / 1024 << " KB, using " << numberOfTriangles << " triangles.\n";
+	}
+
+	if (debug && !queueOfSubpatches.empty()) {
+		cout << "Largest remaining flatness error: " << fmax(queueOfSubpatches.top().error, 0.0f) << "\n";
+	}
+
+	// Emit the remaining subpatches, sharing corner vertices within each patch
+	for (int i = begin; i < end && tessellationAccount.isLimited(); i++) {
+		BezierPatch& patch = listOfBezierPatches[i];
+		patch.listOfTriangles.reserve(patch.listOfTriangles.size() + 2 * subpatchesOfPatch[i]);
+		patch.listOfDifferentialGeometries.reserve(patch.listOfDifferentialGeometries.size() + 2 * subpatchesOfPatch[i] + 2);
+	}
+	std::vector<std::map<std::pair<long, long>, int> > vertexIndexByUV(listOfBezierPatches.size());
+	while (!queueOfSubpatches.empty()) {
+		const Subpatch& subpatch = queueOfSubpatches.top().subpatch;
+		listOfBezierPatches[subpatch.patchIndex].addSubpatchTriangles(subpatch, vertexIndexByUV[subpatch.patchIndex]);
+		queueOfSubpatches.pop();
+	}
+
+	// (the queue's memory is only given back when it goes out of scope, after the triangles were made)
+	for (int i = begin; i < end; i++) {
+		tessellationAccount.add(listOfBezierPatches[i].tessellationMemory());
+	}
+	tessellationAccount.release(queueMemory);
+	return !cutShort;
+}
+
+bool perform_budget_subdivision(int begin, int end) {
+	bool allBicubic = true;
+	for (int i = begin; i < end && allBicubic; i++) {
+		allBicubic = listOfBezierPatches[i].isPolynomialBicubic();
+	}
+	if (allBicubic) {
+		return perform_budget_subdivision<BicubicSubpatch>(begin, end);
+	}
+	return perform_budget_subdivision<BezierSubpatch>(begin, end);
+}
+
+
+//****************************************************
+// Simplifies the tessellated patches listOfBezierPatches[begin, end) with quadric error metric decimation, in parallel
+// (one patch at a time per thread). Each patch gets its share of decimationTarget in proportion to its number of
+// triangles; with no target, patches are simplified as far as decimationError allows. Patch boundaries are kept,
+// which puts a floor under the number of triangles a patch can be reduced to; a note is printed when that floor (or
+// decimationError) keeps the scene above its target.
+//***************************************************
+void perform_decimation(int begin, int end) {
+	long numberOfTriangles = 0;
+	for (int i = begin; i < end; i++) {
+		numberOfTriangles += listOfBezierPatches[i].listOfTriangles.size();
+	}
+	if (numberOfTriangles == 0) {
+		return;
+	}
+	float maxError = decimationError > 0.0f ? decimationError : HUGE_VALF;
+
+	std::atomic<long> removedTriangles(0), patchTargets(0);
+	parallelForEach(end - begin, [&](int k) {
+		BezierPatch& patch = listOfBezierPatches[begin + k];
+		int target = 0;
+		if (decimationTarget > 0) {
+			target = (int) ceil((double) decimationTarget * patch.listOfTriangles.size() / numberOfTriangles);
+			patchTargets += target;
+		}
+		MeshDecimator decimator;
+		removedTriangles += decimator.decimate(patch, target, maxError);
+	});
+
+	long remainingTriangles = numberOfTriangles - removedTriangles;
+	if (debug) {
+		cout << "Decimation: " << numberOfTriangles << " -> " << remainingTriangles << " triangles\n";
+	}
+	// (the patches' shares of the target are rounded up, so only count what is left over beyond them)
+	if (decimationTarget > 0 && remainingTriangles > patchTargets) {
+		cout << "Note: decimation stopped at " << remainingTriangles << " triangles, short of the target of "
+				<< decimationTarget << ": patch boundaries are kept"
+				<< (decimationError > 0.0f ? ", and -decimateerror limits the collapses" : "") << ".\n";
+	}
+}
+
+
+//****************************************************
+// Builds the index buffers of the asset's patches, reorders their triangles for the vertex cache (with Tipsify, in
+// parallel, one patch at a time per thread) and, with -strips, covers uniform grids with triangle strips. Reports the
+// asset's average cache miss ratio (vertices transformed per triangle) before and after.
+//***************************************************
+void optimizeIndices(const SceneAsset& asset) {
+	std::vector<double> missesBefore(asset.numberOfPatches), missesAfter(asset.numberOfPatches);
+	parallelForEach(asset.numberOfPatches, [&](int k) {
+		BezierPatch& patch = listOfBezierPatches[asset.firstPatch + k];
+		patch.buildIndices();
+		int numberOfVertices = patch.listOfDifferentialGeometries.size();
+		int numberOfTriangles = patch.listOfTriangles.size();
+		missesBefore[k] = IndexOptimizer::averageCacheMissRatio(patch.indices, numberOfVertices) * numberOfTriangles;
+		IndexOptimizer::tipsify(patch.indices, numberOfVertices);
+		patch.trianglesFromIndices();
+		missesAfter[k] = IndexOptimizer::averageCacheMissRatio(patch.indices, numberOfVertices) * numberOfTriangles;
+
+		patch.triangleStrips.clear();
+		if (USE_TRIANGLE_STRIPS && patch.uniformSteps > 0) {
+			IndexOptimizer::gridStrips(patch.uniformSteps, patch.triangleStrips);
+		}
+	});
+
+	long numberOfTriangles = 0, numberOfStripPatches = 0;
+	double totalMissesBefore = 0.0, totalMissesAfter = 0.0;
+	for (int k = 0; k < asset.numberOfPatches; k++) {
+		const BezierPatch& patch = listOfBezierPatches[asset.firstPatch + k];
+		numberOfTriangles += patch.listOfTriangles.size();
+		numberOfStripPatches += patch.triangleStrips.empty() ? 0 : 1;
+		totalMissesBefore += missesBefore[k];
+		totalMissesAfter += missesAfter[k];
+	}
+	if (numberOfTriangles > 0) {
+		cout << asset.filename << ": ACMR " << totalMissesBefore / numberOfTriangles << " -> " << totalMissesAfter / numberOfTriangles
+				<< " (" << numberOfTriangles << " triangles, FIFO cache of " << IndexOptimizer::CACHE_SIZE << " vertices)\n";
+	}
+	if (USE_TRIANGLE_STRIPS) {
+		cout << asset.filename << ": " << numberOfStripPatches << " of " << asset.numberOfPatches << " patches drawn as triangle strips\n";
+	}
+}
+
+
+//****************************************************
+// Replaces the tessellation of the asset's patches with quantized vertices (see QuantizedMesh) and index buffers,
+// in parallel, and reports the memory saved and the largest errors this introduced
+//***************************************************
+void compressBezierPatches(const SceneAsset& asset) {
+	size_t memoryBefore = 0, memoryAfter = 0;
+	for (int i = asset.firstPatch; i < asset.firstPatch + asset.numberOfPatches; i++) {
+		memoryBefore += listOfBezierPatches[i].tessellationMemory();
+	}
+
+	std::vector<QuantizationError> errors(asset.numberOfPatches);
+	parallelForEach(asset.numberOfPatches, [&](int k) {
+		errors[k] = listOfBezierPatches[asset.firstPatch + k].compress();
+	});
+
+	QuantizationError error;
+	Eigen::Vector3f lowest = Eigen::Vector3f::Constant(HUGE_VALF), highest = Eigen::Vector3f::Constant(-HUGE_VALF);
+	for (int k = 0; k < asset.numberOfPatches; k++) {
+		const BezierPatch& patch = listOfBezierPatches[asset.firstPatch + k];
+		memoryAfter += patch.tessellationMemory();
+		error.add(errors[k]);
+		for (int axis = 0; axis < 3; axis++) {
+			lowest[axis] = std::min(lowest[axis], patch.compressedMesh.origin[axis]);
+			highest[axis] = std::max(highest[axis], patch.compressedMesh.origin[axis] + patch.compressedMesh.extent[axis]);
 		}
 	}
+	float diagonal = (highest - lowest).norm();
+
+	cout << asset.filename << ": quantized vertices, tessellation memory " << memoryBefore / 1024 << " KB -> "
+			<< memoryAfter / 1024 << " KB\n";
+	cout << asset.filename << ": largest quantization error: position " << error.position;
+	if (diagonal > 0.0f) {
+		cout << " (" << error.position / diagonal << " of the bounding box diagonal)";
+	}
+	cout << ", normal " << error.normalDegrees << " degrees, (u, v) " << error.uv << "\n";
+}
+
 
-	// Generate all vertex lines in file
-	for (std::vector<Triangle>::size_type i = 0; i < aggregateTriangleList.size(); i++) {
-		DifferentialGeometry point1 = aggregateTriangleList[i].point1;
-		DifferentialGeometry point2 = aggregateTriangleList[i].point2;
-		DifferentialGeometry point3 = aggregateTriangleList[i].point3;
+//****************************************************
+// Writes an .obj file that represents the tessellated Bezier patches of every instance in the scene
+//***************************************************
+void generateObjFile(const std::string& filename) {
+	std::ofstream myfile;
+	myfile.open(filename);
 
-		myfile << "v " << point1.position.x() << " " << point1.position.y() << " " << point1.position.z() << "\n";
-		myfile << "v " << point2.position.x() << " " << point2.position.y() << " " << point2.position.z() << "\n";
-		myfile << "v " << point3.position.x() << " " << point3.position.y() << " " << point3.position.z() << "\n";
+	// Generate all vertex lines in file, reading the triangles in place from each patch
+	std::vector<Triangle>::size_type numberOfTriangles = 0;
+	for (std::vector<SceneInstance>::size_type k = 0; k < sceneInstances.size(); k++) {
+		const SceneInstance& instance = sceneInstances[k];
+		const SceneAsset& asset = sceneAssets[instance.assetIndex];
+		for (int i = asset.firstPatch; i < asset.firstPatch + asset.numberOfPatches; i++) {
+			for (std::vector<Triangle>::size_type j = 0; j < listOfBezierPatches[i].listOfTriangles.size(); j++) {
+				Eigen::Vector3f point1 = instance.transformPoint(listOfBezierPatches[i].listOfTriangles[j].point1.position);
+				Eigen::Vector3f point2 = instance.transformPoint(listOfBezierPatches[i].listOfTriangles[j].point2.position);
+				Eigen::Vector3f point3 = instance.transformPoint(listOfBezierPatches[i].listOfTriangles[j].point3.position);
+
+				myfile << "v " << point1.x() << " " << point1.y() << " " << point1.z() << "\n";
+				myfile << "v " << point2.x() << " " << point2.y() << " " << point2.z() << "\n";
+				myfile << "v " << point3.x() << " " << point3.y() << " " << point3.z() << "\n";
+				numberOfTriangles++;
+			}
+		}
 	}
 
 
-	for (std::vector<Triangle>::size_type i = 0; i < aggregateTriangleList.size(); i++) {
+	for (std::vector<Triangle>::size_type i = 0; i < numberOfTriangles; i++) {
 		myfile << "f " << (3 * i) + 1 << " " << (3 * i) + 2 << " " << (3 * i) + 3 << "\n";
 	}
 }
 
 
 
+//****************************************************
+// Writes one patch (control point rows as in BezierPatch::listOfCurves, and their weights if it is rational) of
+// 'instance' to a .bez file, preceded by a degree or triangle line if it differs in kind from the patch before it,
+// which is 'currentKind' (the line that applies, initially "degree 3 3")
+//***************************************************
+void writeBezPatch(std::ofstream& file, const std::vector<std::vector<Eigen::Vector3f> >& rows,
+		const std::vector<std::vector<float> >& weights, bool triangular, const SceneInstance& instance, string& currentKind) {
+	std::ostringstream kind;
+	if (triangular) {
+		kind << "triangle " << rows[0].size() - 1;
+	} else {
+		kind << "degree " << rows[0].size() - 1 << " " << rows.size() - 1;
+	}
+	if (!weights.empty()) {
+		kind << " rational";
+	}
+	if (kind.str() != currentKind) {
+		currentKind = kind.str();
+		file << currentKind << "\n";
+	}
+
+	for (std::vector<std::vector<Eigen::Vector3f> >::size_type row = 0; row < rows.size(); row++) {
+		for (std::vector<Eigen::Vector3f>::size_type column = 0; column < rows[row].size(); column++) {
+			Eigen::Vector3f point = instance.transformPoint(rows[row][column]);
+			file << point.x() << " " << point.y() << " " << point.z();
+			if (!weights.empty()) {
+				file << " " << weights[row][column];
+			}
+			file << "   ";
+		}
+		file << "\n";
+	}
+	file << "\n";
+}
+
+
+//****************************************************
+// Writes a .bez file of the patches of every instance in the scene: bicubic patches fitted (by BezierSurfaceFitter)
+// to its .obj files, and the patches of its .bez files and -catmullclark .obj files as they are. Every .obj file is
+// fitted once, with patches of about fitPatchSize times its bounding box diagonal.
+//***************************************************
+void generateBezFile(const std::string& filename) {
+	std::vector<BezierSurfaceFitter> fitters(sceneAssets.size());
+	for (std::vector<SceneAsset>::size_type k = 0; k < sceneAssets.size(); k++) {
+		const SceneAsset& asset = sceneAssets[k];
+		if (!asset.objMode || asset.numberOfObjTriangles == 0) {
+			continue;
+		}
+		struct timeval start, end;
+		gettimeofday(&start, NULL);
+
+		const unsigned int* triangles = &objFileTriangles[3 * asset.firstObjTriangle];
+		Eigen::Vector3f minimum = Eigen::Vector3f::Constant(HUGE_VALF), maximum = Eigen::Vector3f::Constant(-HUGE_VALF);
+		for (int i = 0; i < 3 * asset.numberOfObjTriangles; i++) {
+			minimum = minimum.cwiseMin(objFileVertices[triangles[i]]);
+			maximum = maximum.cwiseMax(objFileVertices[triangles[i]]);
+		}
+		float diagonal = (maximum - minimum).norm();
+
+		BezierSurfaceFitter& fitter = fitters[k];
+		fitter.patchSize = fitPatchSize * diagonal;
+		fitter.fit(objFileVertices, triangles, asset.numberOfObjTriangles);
+		gettimeofday(&end, NULL);
+
+		cout << asset.filename << ": " << asset.numberOfObjTriangles << " triangles -> " << fitter.patches.size()
+				<< " Bezier patches in " << fitter.numberOfRegions << " regions, error " << fitter.maxError / diagonal
+				<< " (largest), " << fitter.rmsError / diagonal << " (root mean square) of the bounding box diagonal\n";
+		if (debug) {
+			cout << "Fitted in " << ((end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0) << " ms.\n";
+		}
+	}
+
+	std::vector<std::vector<std::vector<Eigen::Vector3f> > >::size_type numberOfPatches = 0;
+	for (std::vector<SceneInstance>::size_type k = 0; k < sceneInstances.size(); k++) {
+		numberOfPatches += fitters[sceneInstances[k].assetIndex].patches.size() + sceneAssets[sceneInstances[k].assetIndex].numberOfPatches;
+	}
+
+	std::ofstream myfile;
+	myfile.open(filename);
+	myfile.precision(7);
+	myfile << numberOfPatches << "\n";
+	string currentKind = "degree 3 3";
+	const std::vector<std::vector<float> > noWeights;
+	for (std::vector<SceneInstance>::size_type k = 0; k < sceneInstances.size(); k++) {
+		const SceneInstance& instance = sceneInstances[k];
+		const std::vector<std::vector<std::vector<Eigen::Vector3f> > >& patches = fitters[instance.assetIndex].patches;
+		for (std::vector<std::vector<std::vector<Eigen::Vector3f> > >::size_type i = 0; i < patches.size(); i++) {
+			writeBezPatch(myfile, patches[i], noWeights, false, instance, currentKind);
+		}
+		const SceneAsset& asset = sceneAssets[instance.assetIndex];
+		for (int i = asset.firstPatch; i < asset.firstPatch + asset.numberOfPatches; i++) {
+			const BezierPatch& patch = listOfBezierPatches[i];
+			writeBezPatch(myfile, patch.listOfCurves, patch.weights, patch.triangular, instance, currentKind);
+		}
+	}
+}
+
+
 //****************************************************
 // function that parses an input .bez file and initializes
 // a list of Bezier patches
 //
+// By default every patch is bicubic: 4 lines of 4 points (12 numbers) each. A line
+//
+//   degree du dv
+//
+// switches all following patches to degree du in u and dv in v, i.e. dv + 1 lines of du + 1 points each, and
+//
+//   degree du dv rational
+//
+// additionally gives every point a weight, written after its coordinates (x y z w). 'degree 3 3' switches back.
+// Similarly,
+//
+//   triangle n
+//   triangle n rational
+//
+// switches to triangular patches of degree n: n + 1 lines, the first of n + 1 points and every following one
+// of one point less. Line j holds the points P(i, j, n - i - j), i = 0 .. n - j (see BezierPatch::triangular).
+//
 // psuedocode for parsing .bez file
 
 /*
 
 BezierPatch currentBezierPatch
-for each collection of 4 rows that correspond to one Bezier patch:
-    for i between 1 and 4 (ie. each of the 4 rows for the current patch):
-        Vect3 point1 = first row
-        Vect3 point2 = second row
-        Vect3 point3 = third row
-        Vect3 point4 = fourth row
-        vector<Vect3> curveI;
-        curveI.push_back(point1);
-        curveI.push_back(point2);
-        curveI.push_back(point3);
-        curveI.push_back(point4);
+for each collection of (degree v + 1) rows that correspond to one Bezier patch:
+    for each row of the current patch:
+        vector<Vect3> curveI = the (degree u + 1) points of the row
+        (and their weights, for rational patches)
         currentBezierPatch.addCurve(curveI);
     all_bezier_patches.addPatch(currentBezierPatch);
 
 */
 //****************************************************
-void parseBezierFile(string filename) {
+void parseBezierFile(const string& filename) {
 
 	ifstream file(filename);
 	// current line
@@ -728,11 +1656,13 @@ void parseBezierFile(string filename) {
 	// index of the line
 	int i = 0;
 
-	// index of a word on each specific line
-	int j = 0;
+	// degrees of the patches that are being read, whether they are triangular, and whether their points have weights
+	int degreeU = 3, degreeV = 3;
+	bool triangular = false;
+	bool rational = false;
 
-	// coordinates for each set of four points (i.e. one line)
-	float p1x, p1y, p1z, p2x, p2y, p2z, p3x, p3y, p3z, p4x, p4y, p4z;
+	// numbers on the current line
+	vector<float> values;
 
 	// number of lines that have already been processed for the current Bezier patch
 	int curvesParsedForCurrentPatch = 0;
@@ -742,8 +1672,8 @@ void parseBezierFile(string filename) {
 	bool readyForNextPatch = false;
 
 	while (getline(file, str)) {
-		// If we encounter a new line, then we know that the next 4 consecutive lines represent
-		// 4 curves that will make up a Bezier patch, so we reset our current Bezier patch
+		// If we encounter a new line, then we know that the next consecutive lines represent
+		// the curves that will make up a Bezier patch, so we reset our current Bezier patch
 		if (str.length() == 0) {
 			curvesParsedForCurrentPatch = 0;
 			currentBezierPatch = BezierPatch();
@@ -757,7 +1687,6 @@ void parseBezierFile(string filename) {
 			currentBezierPatch = BezierPatch();
 		}
 
-		j = 0;
 		if (i == 0) {
 			numberOfBezierPatches = stoi(str);
 			i++;
@@ -765,88 +1694,445 @@ void parseBezierFile(string filename) {
 		}
 
 		istringstream iss(str);
+		values.clear();
 		// Iterate through words on a single line...
 		while (iss >> currentWord) {
-			if (j == 0) { p1x = stof(currentWord); }
-			if (j == 1) { p1y = stof(currentWord); }
-			if (j == 2) { p1z = stof(currentWord); }
-			if (j == 3) { p2x = stof(currentWord); }
-			if (j == 4) { p2y = stof(currentWord); }
-			if (j == 5) { p2z = stof(currentWord); }
-			if (j == 6) { p3x = stof(currentWord); }
-			if (j == 7) { p3y = stof(currentWord); }
-			if (j == 8) { p3z = stof(currentWord); }
-			if (j == 9) { p4x = stof(currentWord); }
-			if (j == 10) { p4y = stof(currentWord); }
-			if (j == 11) { p4z = stof(currentWord); }
-			j++;
-		}
-
-		Eigen::Vector3f point1(p1x, p1y, p1z);
-		Eigen::Vector3f point2(p2x, p2y, p2z);
-		Eigen::Vector3f point3(p3x, p3y, p3z);
-		Eigen::Vector3f point4(p4x, p4y, p4z);
-
-		// 1 of the 4 curves for the currentBezierPatch
+			if (values.empty() && (currentWord == "degree" || currentWord == "triangle")) {
+				string rationalWord;
+				triangular = currentWord == "triangle";
+				if (!(iss >> degreeU) || (!triangular && !(iss >> degreeV)) || degreeU < 1 || degreeV < 1) {
+					cerr << "Invalid degree line in " << filename << ": " << str << "\n";
+					exit(1);
+				}
+				if (triangular) {
+					degreeV = degreeU;
+				}
+				rational = (iss >> rationalWord) && rationalWord == "rational";
+				curvesParsedForCurrentPatch = 0;
+				currentBezierPatch = BezierPatch();
+				break;
+			}
+			values.push_back(stof(currentWord));
+		}
+		if (values.empty()) {
+			i++;
+			continue;
+		}
+
+		// Rows of triangular patches get shorter by one point each
+		int numberOfPoints = triangular ? degreeU + 1 - curvesParsedForCurrentPatch : degreeU + 1;
+		int numbersPerPoint = rational ? 4 : 3;
+		if ((int) values.size() < numberOfPoints * numbersPerPoint) {
+			cerr << "Expected " << numberOfPoints << " points on line " << (i + 1) << " of " << filename << ".\n";
+			exit(1);
+		}
+
+		// 1 of the (degreeV + 1) curves for the currentBezierPatch
 		vector<Eigen::Vector3f> currentCurve;
-		currentCurve.push_back(point1);
-		currentCurve.push_back(point2);
-		currentCurve.push_back(point3);
-		currentCurve.push_back(point4);
+		vector<float> currentWeights;
+		for (int k = 0; k < numberOfPoints; k++) {
+			const float* point = &values[k * numbersPerPoint];
+			currentCurve.push_back(Eigen::Vector3f(point[0], point[1], point[2]));
+			if (rational) {
+				if (point[3] <= 0.0f) {
+					cerr << "Weights must be positive (line " << (i + 1) << " of " << filename << ").\n";
+					exit(1);
+				}
+				currentWeights.push_back(point[3]);
+			}
+		}
 
-		currentBezierPatch.addCurve(currentCurve);
+		if (rational) {
+			currentBezierPatch.addCurve(currentCurve, currentWeights);
+		} else {
+			currentBezierPatch.addCurve(currentCurve);
+		}
 		curvesParsedForCurrentPatch++;
 
-		// We have parsed all four curves for our current patch
-		if (curvesParsedForCurrentPatch == 4) {
+		// We have parsed all curves for our current patch
+		if (curvesParsedForCurrentPatch == degreeV + 1) {
 
-			listOfBezierPatches.push_back(currentBezierPatch);
+			currentBezierPatch.triangular = triangular;
+			listOfBezierPatches.push_back(std::move(currentBezierPatch));
 			readyForNextPatch = true;
 		}
 
 		i++;
 	}
+}
 
-	// Perform subdivision of BezierPatches, based on whether we want to adaptively or uniformly subdivide
-	if (subdivisionMethod == "ADAPTIVE") {
-		perform_subdivision(true);
-	} else if (subdivisionMethod == "UNIFORM") {
-		perform_subdivision(false);
-	} else {
-		cout << "Invalid subdivision method, terminating program.";
-		exit(1);
-	}
 
-	// We want to write our Bezier patches to an .obj file
-	if (WRITE_OBJ) {
-		generateObjFile(objFilenameOutput);
+//****************************************************
+// Patch-level subdivision (and the patch ray tracer) split patches with BezierSubpatch, which only handles
+// degrees up to BezierSubpatch::MAX_DEGREE, and no triangular patches. Exits with an error naming 'option' if a patch
+// is not supported.
+//****************************************************
+void requireSubpatchDegrees(const std::string& option) {
+	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+		const BezierPatch& patch = listOfBezierPatches[i];
+		if (patch.triangular) {
+			cerr << option << " does not support triangular patches (patch " << (i + 1) << "), use uniform or adaptive tessellation.\n";
+			exit(1);
+		}
+		if (!BezierSubpatch::supportsDegrees(patch.degreeU(), patch.degreeV())) {
+			cerr << option << " supports patches of degree up to " << BezierSubpatch::MAX_DEGREE << ", but patch "
+					<< (i + 1) << " has degree " << patch.degreeU() << " x " << patch.degreeV() << ".\n";
+			exit(1);
+		}
 	}
-
 }
 
+
 //****************************************************
-// Parsing .OBJ file specified in scene file
+// Checks the tessellated vertices of every .bez file (and the vertices of every .obj file) for NaN or infinite
+// positions and normals, and for normals that could not be determined (zero vectors), and reports any it finds
+// (in debug mode, also reports files that passed). The normals of .obj files, which are drawn as they are, must
+// also be unit length, and there must be one for every vertex.
 //****************************************************
-void parseObjFile(string filename) {
+void validateTessellation() {
+	for (std::vector<SceneAsset>::size_type i = 0; i < sceneAssets.size(); i++) {
+		const SceneAsset& asset = sceneAssets[i];
+		long numberOfVertices = 0, badPositions = 0, badNormals = 0, zeroNormals = 0, nonUnitNormals = 0;
+		int firstBadPatch = -1;
+
+		if (asset.objMode) {
+			if (objFileNormals.size() != objFileVertices.size()) {
+				cerr << asset.filename << ": " << objFileNormals.size() << " normals for " << objFileVertices.size()
+						<< " .obj vertices.\n";
+				continue;
+			}
+			// (only the vertices that triangles use: the others are never drawn, and have no normal to check)
+			std::vector<bool> used(asset.numberOfObjVertices, false);
+			for (int k = 3 * asset.firstObjTriangle; k < 3 * (asset.firstObjTriangle + asset.numberOfObjTriangles); k++) {
+				used[objFileTriangles[k] - asset.firstObjVertex] = true;
+			}
+			for (int j = asset.firstObjVertex; j < asset.firstObjVertex + asset.numberOfObjVertices; j++) {
+				if (!used[j - asset.firstObjVertex]) {
+					continue;
+				}
+				numberOfVertices++;
+				badPositions += !objFileVertices[j].allFinite();
+				if (!objFileNormals[j].allFinite()) {
+					badNormals++;
+				} else if (objFileNormals[j].isZero()) {
+					zeroNormals++;
+				} else if (fabs(objFileNormals[j].squaredNorm() - 1.0f) > 1e-4f) {
+					nonUnitNormals++;
+				}
+			}
+		}
+		for (int j = asset.firstPatch; j < asset.firstPatch + asset.numberOfPatches; j++) {
+			const std::vector<DifferentialGeometry>& vertices = listOfBezierPatches[j].listOfDifferentialGeometries;
+			long badBefore = badPositions + badNormals + zeroNormals;
+			for (std::vector<DifferentialGeometry>::size_type k = 0; k < vertices.size(); k++) {
+				numberOfVertices++;
+				if (!vertices[k].position.allFinite()) {
+					badPositions++;
+				}
+				if (!vertices[k].normal.allFinite()) {
+					badNormals++;
+				} else if (vertices[k].normal.isZero()) {
+					zeroNormals++;
+				}
+			}
+			if (firstBadPatch < 0 && badPositions + badNormals + zeroNormals > badBefore) {
+				firstBadPatch = j - asset.firstPatch;
+			}
+		}
 
-	string str;
-	ifstream file(filename);
+		if (badPositions + badNormals + zeroNormals + nonUnitNormals > 0) {
+			cerr << asset.filename << ": " << badPositions << " of " << numberOfVertices << " vertices have NaN or infinite positions, "
+					<< badNormals << " have NaN or infinite normals, " << zeroNormals << " have no normal and "
+					<< nonUnitNormals << " have normals that are not unit length";
+			if (firstBadPatch >= 0) {
+				cerr << " (first in patch " << (firstBadPatch + 1) << ")";
+			}
+			cerr << ".\n";
+		} else if (debug) {
+			cout << asset.filename << ": all " << numberOfVertices << " vertices are finite.\n";
+		}
+	}
+}
 
-	// The identifier that we're currently parsing
-	string currentlyParsing;
 
-	// current word that we're parsing on a line
-	string currentWord;
+//****************************************************
+// Tessellates all Bezier patches of the scene (each one only once, no matter how many instances use it),
+// and writes them to an .obj file if requested
+//****************************************************
+void tessellateBezierPatches() {
+	if (subdivisionMethod != "ADAPTIVE" && subdivisionMethod != "UNIFORM" && subdivisionMethod != "FLATNESS"
+			&& subdivisionMethod != "BUDGET") {
+		cout << "Invalid subdivision method, terminating program.";
+		exit(1);
+	}
+	if (subdivisionMethod == "FLATNESS" || subdivisionMethod == "BUDGET") {
+		requireSubpatchDegrees(subdivisionMethod == "FLATNESS" ? "-f" : "-t");
+	}
+
+	// Files loaded from the cache are already tessellated
+	recountTessellationMemory();
+	size_t limitKB = tessellationAccount.limit / 1024;
+
+	// The triangle budget is shared by all patches of the scene, so they are tessellated together
+	// (files loaded from the cache are already tessellated, which only happens for single-file scenes)
+	bool budgetReduced = false;
+	if (subdivisionMethod == "BUDGET") {
+		bool allLoadedFromCache = true;
+		for (std::vector<SceneAsset>::size_type i = 0; i < sceneAssets.size(); i++) {
+			allLoadedFromCache = allLoadedFromCache && (sceneAssets[i].objMode || sceneAssets[i].loadedFromCache);
+		}
+		if (!allLoadedFromCache) {
+			budgetReduced = !perform_budget_subdivision(0, listOfBezierPatches.size());
+			recountTessellationMemory();
+		}
+	}
+
+	// How many times a file's subdivision parameter may be doubled to fit within the memory limit,
+	// after which it is tessellated regardless of the limit
+	const int maxCoarsenings = 16;
+
+	for (std::vector<SceneAsset>::size_type i = 0; i < sceneAssets.size(); i++) {
+		const SceneAsset& asset = sceneAssets[i];
+		if (asset.objMode || asset.loadedFromCache) {
+			continue;
+		}
+		int begin = asset.firstPatch;
+		int end = asset.firstPatch + asset.numberOfPatches;
+
+		// Perform subdivision of BezierPatches, based on whether we want to adaptively or uniformly subdivide.
+		// If the result does not fit within the memory limit, it is thrown away and the file is tessellated
+		// again, twice as coarsely, instead of running out of memory.
+		size_t memoryBefore = tessellationAccount.currentBytes();
+		float parameter = subdivisionParameter;
+		bool fits = false;
+		for (int coarsenings = 0; !fits; coarsenings++) {
+			// Uniform subdivision can get no coarser than a single step
+			bool lastTry = coarsenings == maxCoarsenings || (subdivisionMethod == "UNIFORM" && parameter >= 1.0f);
+			size_t limit = tessellationAccount.limit;
+			if (lastTry) {
+				tessellationAccount.limit = 0;
+			}
+
+			if (subdivisionMethod == "ADAPTIVE") {
+				fits = perform_subdivision(true, begin, end, parameter);
+			} else if (subdivisionMethod == "UNIFORM") {
+				fits = perform_subdivision(false, begin, end, parameter);
+			} else if (subdivisionMethod == "FLATNESS") {
+				fits = perform_flatness_subdivision(begin, end, parameter);
+			} else {
+				// Triangle-budget subdivision was done above, for the whole scene
+				fits = true;
+			}
+
+			tessellationAccount.limit = limit;
+			if (lastTry) {
+				break;
+			}
+			if (!fits) {
+				for (int k = begin; k < end; k++) {
+					listOfBezierPatches[k].releaseTessellation();
+				}
+				tessellationAccount.set(memoryBefore);
+				parameter = subdivisionMethod == "UNIFORM" ? std::min(2.0f * parameter, 1.0f) : 2.0f * parameter;
+			}
+		}
+
+		if (tessellationAccount.isOverLimit()) {
+			cerr << asset.filename << ": the memory limit of " << limitKB << " KB cannot be met, its tessellation with subdivision parameter "
+					<< parameter << " takes " << (tessellationAccount.currentBytes() - memoryBefore) / 1024 << " KB.\n";
+		} else if (parameter != subdivisionParameter) {
+			cerr << asset.filename << ": tessellated with subdivision parameter " << parameter << " instead of "
+					<< subdivisionParameter << " to fit in the memory limit of " << limitKB << " KB.\n";
+		}
+
+		// (A coarsened tessellation does not match the options the cache key was made from)
+		if (!asset.cacheKey.empty() && parameter == subdivisionParameter && !budgetReduced
+				&& !tessellationCache.store(asset.cacheKey, listOfBezierPatches, begin, end)) {
+			cerr << "Could not write " << tessellationCache.pathForKey(asset.cacheKey) << " to the tessellation cache.\n";
+		}
+	}
+
+	// Decimate every file (including the ones that came from the cache, which stores the full tessellation)
+	if (DECIMATE) {
+		perform_decimation(0, listOfBezierPatches.size());
+		recountTessellationMemory();
+	}
+
+	if (OPTIMIZE_INDICES) {
+		for (std::vector<SceneAsset>::size_type k = 0; k < sceneAssets.size(); k++) {
+			if (!sceneAssets[k].objMode) {
+				optimizeIndices(sceneAssets[k]);
+			}
+		}
+		recountTessellationMemory();
+	}
+
+	validateTessellation();
+
+	// We want to write our Bezier patches to an .obj file (or fit Bezier patches to our .obj files)
+	if (WRITE_OBJ) {
+		generateObjFile(objFilenameOutput);
+	}
+	if (WRITE_BEZ) {
+		generateBezFile(bezFilenameOutput);
+	}
+
+	// From here on, keep only the quantized tessellation
+	if (QUANTIZE) {
+		for (std::vector<SceneAsset>::size_type k = 0; k < sceneAssets.size(); k++) {
+			if (!sceneAssets[k].objMode) {
+				compressBezierPatches(sceneAssets[k]);
+			}
+		}
+		recountTessellationMemory();
+	}
+
+	if (tessellationAccount.isLimited() || debug) {
+		cout << "Tessellation memory: " << tessellationAccount.currentBytes() / 1024 << " KB (peak "
+				<< tessellationAccount.peakBytes() / 1024 << " KB";
+		if (tessellationAccount.isLimited()) {
+			cout << ", limit " << limitKB << " KB";
+		}
+		cout << ")\n";
+	}
+}
+
+//****************************************************
+// Adds the face with corners objFileVertices[corners] to objFilePolygonCorners, triangulates it, and adds its
+// triangles and its outline to objFileTriangles and objFileOutlines. 'cornerNormals' holds the index of the vn line
+// given for every corner (-1 for none), which is appended to 'triangleCornerNormals' for every triangle corner.
+//****************************************************
+void addObjFace(const std::vector<unsigned int>& corners, const std::vector<int>& cornerNormals,
+		std::vector<int>& triangleCornerNormals) {
+	std::vector<Eigen::Vector3f> positions(corners.size());
+	for (std::vector<unsigned int>::size_type k = 0; k < corners.size(); k++) {
+		positions[k] = objFileVertices[corners[k]];
+	}
+	std::vector<int> triangles;
+	PolygonTriangulator::triangulate(positions, triangles);
+
+	int face = objFilePolygonStarts.size();
+	objFilePolygonStarts.push_back(objFilePolygonCorners.size());
+	objFilePolygonCorners.insert(objFilePolygonCorners.end(), corners.begin(), corners.end());
+
+	int numberOfCorners = corners.size();
+	for (std::vector<int>::size_type k = 0; k < triangles.size(); k += 3) {
+		unsigned char edgeFlags = 0;
+		for (int edge = 0; edge < 3; edge++) {
+			objFileTriangles.push_back(corners[triangles[k + edge]]);
+			triangleCornerNormals.push_back(cornerNormals[triangles[k + edge]]);
+
+			// Edges between consecutive corners of the face are on its outline
+			int from = triangles[k + edge], to = triangles[k + (edge + 1) % 3];
+			if ((from + 1) % numberOfCorners == to || (to + 1) % numberOfCorners == from) {
+				edgeFlags |= 1 << edge;
+			}
+		}
+		objFileTriangleFaces.push_back(face);
+		objFileTriangleEdgeFlags.push_back(edgeFlags);
+	}
+
+	for (int k = 0; k < numberOfCorners && numberOfCorners > 1; k++) {
+		objFileOutlines.push_back(corners[k]);
+		objFileOutlines.push_back(corners[(k + 1) % numberOfCorners]);
+	}
+}
+
+
+//****************************************************
+// Gives the vertices objFileVertices[firstVertex, end) of an .obj file normals (in objFileNormals), with the
+// triangles [firstTriangle, end) of the file. Corners that the file gives a normal (normals[triangleCornerNormals[k]]
+// for the k-th corner, if that is not -1) keep it: the first normal given for a vertex becomes the vertex's, and
+// every other one gets its own copy of the vertex. All other vertices get smooth normals computed from the triangles.
+//****************************************************
+void assignObjNormals(std::vector<Eigen::Vector3f>::size_type firstVertex, std::vector<int>::size_type firstTriangle,
+		const std::vector<Eigen::Vector3f>& normals, const std::vector<int>& triangleCornerNormals) {
+	int numberOfFileVertices = objFileVertices.size() - firstVertex;
+	objFileNormals.resize(objFileVertices.size(), Eigen::Vector3f::Zero());
+
+	// The vn line each vertex of the file took its normal from (-1: computed), and its copies for the other ones
+	std::vector<int> givenNormal(numberOfFileVertices, -1);
+	std::unordered_map<unsigned long long, unsigned int> copies;
+	int numberOfGivenNormals = 0;
+	for (std::vector<int>::size_type k = 0; k < triangleCornerNormals.size(); k++) {
+		int normalIndex = triangleCornerNormals[k];
+		unsigned int& vertex = objFileTriangles[3 * firstTriangle + k];
+		if (normalIndex < 0 || normalIndex >= (int) normals.size() || normals[normalIndex].squaredNorm() == 0.0f) {
+			continue;
+		}
+		Eigen::Vector3f normal = normals[normalIndex].normalized();
+		int& vertexNormal = givenNormal[vertex - firstVertex];
+		if (vertexNormal < 0) {
+			vertexNormal = normalIndex;
+			objFileNormals[vertex] = normal;
+			numberOfGivenNormals++;
+		} else if (vertexNormal != normalIndex && objFileNormals[vertex] != normal) {
+			unsigned long long key = ((unsigned long long) vertex << 32) | (unsigned int) normalIndex;
+			std::unordered_map<unsigned long long, unsigned int>::iterator copy = copies.find(key);
+			if (copy == copies.end()) {
+				Eigen::Vector3f position = objFileVertices[vertex];
+				objFileVertices.push_back(position);
+				objFileNormals.push_back(normal);
+				copy = copies.insert(std::make_pair(key, (unsigned int) (objFileVertices.size() - 1))).first;
+			}
+			vertex = copy->second;
+		}
+	}
+
+	if (numberOfGivenNormals == 0) {
+		VertexNormalGenerator::compute(objFileVertices, objFileTriangles, firstVertex, firstTriangle, objFileNormals);
+	} else if (numberOfGivenNormals < numberOfFileVertices) {
+		std::vector<Eigen::Vector3f> computedNormals;
+		VertexNormalGenerator::compute(objFileVertices, objFileTriangles, firstVertex, firstTriangle, computedNormals);
+		for (int i = 0; i < numberOfFileVertices; i++) {
+			if (givenNormal[i] < 0) {
+				objFileNormals[firstVertex + i] = computedNormals[firstVertex + i];
+			}
+		}
+	}
+
+	if (debug && numberOfGivenNormals > 0) {
+		cout << numberOfGivenNormals << " of " << numberOfFileVertices << " vertices have normals from the file ("
+				<< copies.size() << " duplicated for additional normals).\n";
+	}
+}
+
+
+//****************************************************
+// Parsing .OBJ file specified in scene file
+//****************************************************
+void parseObjFile(const string& filename) {
+
+	string str;
+	ifstream file(filename);
+
+	// The identifier that we're currently parsing
+	string currentlyParsing;
+
+	// current word that we're parsing on a line
+	string currentWord;
 
 	bool validLine = true;
 
+	// Face indices count from the first vertex of this file, which matters when a scene loads several .obj files
+	std::vector<Eigen::Vector3f>::size_type firstVertex = objFileVertices.size();
+	std::vector<int>::size_type firstTriangle = objFileTriangleFaces.size();
+
+	// Normals of the file's vn lines, and the one given for every corner of its triangles (-1 for none)
+	std::vector<Eigen::Vector3f> normals;
+	std::vector<int> triangleCornerNormals;
+
 	while (getline(file, str)) {
 		// str represents the current line of the file
 
 		validLine = true;
 		int i = 0;
 
-		std::vector<DifferentialGeometry> currentPolygonPoints;
+		std::vector<unsigned int> currentPolygonIndices;
+		std::vector<int> currentPolygonNormals;
+
+		// coordinates of a vertex line; declared out here so they keep their values from one word to the next
+		float xCoor = 0, yCoor = 0, zCoor = 0;
 
 		istringstream iss(str);
 		while (iss >> currentWord) {
@@ -854,11 +2140,15 @@ void parseObjFile(string filename) {
 			// ********** Figure out what the first word of each line is ********** //
 			// We currently support:
 			// (1) v ... (vertex definitions)
-			// (2) f ... (face definitions)
+			// (2) vn ... (vertex normal definitions)
+			// (3) f ... (face definitions, whose corners are v, v/vt, v//vn or v/vt/vn)
 
 			if ((i == 0) && (currentWord == "v")) {
 				currentlyParsing = currentWord;
 
+			} else if ((i == 0) && (currentWord == "vn")) {
+				currentlyParsing = currentWord;
+
 			} else if ((i == 0) && (currentWord == "f")) {
 				currentlyParsing = currentWord;
 
@@ -876,8 +2166,7 @@ void parseObjFile(string filename) {
 			// ********** After we've figured out the first word in each line, parse the rest of the line ********** //
 			// If we've hit here, then we're NOT on the first word of the line anymore
 
-			if (currentlyParsing == "v") {
-				float xCoor, yCoor, zCoor;
+			if (currentlyParsing == "v" || currentlyParsing == "vn") {
 				if (i == 0) { }
 				else if (i == 1) { xCoor = stof(currentWord); }
 				else if (i == 2) { yCoor = stof(currentWord); }
@@ -885,8 +2174,10 @@ void parseObjFile(string filename) {
 				else if (i > 3) {
 					cerr << "Extra parameters for " << currentlyParsing << ". Ignoring them.\n";
 				}
-				if (i == 3) {
+				if (i == 3 && currentlyParsing == "v") {
 					objFileVertices.push_back(Eigen::Vector3f(xCoor, yCoor, zCoor));
+				} else if (i == 3) {
+					normals.push_back(Eigen::Vector3f(xCoor, yCoor, zCoor));
 				}
 
 			} else if (currentlyParsing == "f") {
@@ -896,10 +2187,19 @@ void parseObjFile(string filename) {
 					i++;
 					continue;
 				}
-				int currentIndexOfVertex = stoi(currentWord) - 1;
-
-				if (currentIndexOfVertex < objFileVertices.size()) {
-					currentPolygonPoints.push_back(DifferentialGeometry(objFileVertices[currentIndexOfVertex]));
+				// (negative indices count back from the last vertex read so far)
+				int vertexNumber = stoi(currentWord);
+				int currentIndexOfVertex = vertexNumber < 0 ? objFileVertices.size() + vertexNumber : firstVertex + vertexNumber - 1;
+
+				if (currentIndexOfVertex >= (int) firstVertex && currentIndexOfVertex < (int) objFileVertices.size()) {
+					currentPolygonIndices.push_back(currentIndexOfVertex);
+
+					// The normal index follows the second slash
+					std::string::size_type firstSlash = currentWord.find('/');
+					std::string::size_type secondSlash = firstSlash == std::string::npos ? firstSlash : currentWord.find('/', firstSlash + 1);
+					bool hasNormal = secondSlash != std::string::npos && secondSlash + 1 < currentWord.size();
+					int normalNumber = hasNormal ? stoi(currentWord.substr(secondSlash + 1)) : 0;
+					currentPolygonNormals.push_back(normalNumber < 0 ? normals.size() + normalNumber : normalNumber - 1);
 				}
 
 			}
@@ -909,10 +2209,59 @@ void parseObjFile(string filename) {
 
 		// Finished parsing current line
 		if (currentlyParsing == "f") {
-			objFilePolygonList.push_back(currentPolygonPoints);
+			addObjFace(currentPolygonIndices, currentPolygonNormals, triangleCornerNormals);
 		}
 	}
+
+	assignObjNormals(firstVertex, firstTriangle, normals, triangleCornerNormals);
 }
+//****************************************************
+// Adds bicubic patches approximating the Catmull-Clark limit surface of the .obj file 'filename' (see
+// CatmullClarkPatcher) to listOfBezierPatches
+//****************************************************
+void parseCatmullClarkPatches(const string& filename) {
+	// Read the faces the usual way, then take them back out of the .obj mesh
+	std::vector<Eigen::Vector3f>::size_type firstVertex = objFileVertices.size();
+	std::vector<int>::size_type firstTriangle = objFileTriangleFaces.size();
+	std::vector<unsigned int>::size_type firstOutlineIndex = objFileOutlines.size();
+	std::vector<unsigned int>::size_type firstPolygon = objFilePolygonStarts.size();
+	std::vector<unsigned int>::size_type firstPolygonCorner = objFilePolygonCorners.size();
+	parseObjFile(filename);
+
+	std::vector<std::vector<Eigen::Vector3f> > polygons(objFilePolygonStarts.size() - firstPolygon);
+	for (std::vector<std::vector<Eigen::Vector3f> >::size_type f = 0; f < polygons.size(); f++) {
+		for (unsigned int k = objFilePolygonStarts[firstPolygon + f]; k < polygonEnd(firstPolygon + f); k++) {
+			polygons[f].push_back(objFileVertices[objFilePolygonCorners[k]]);
+		}
+	}
+	objFileVertices.resize(firstVertex);
+	objFileNormals.resize(firstVertex);
+	objFileTriangles.resize(3 * firstTriangle);
+	objFileTriangleFaces.resize(firstTriangle);
+	objFileTriangleEdgeFlags.resize(firstTriangle);
+	objFileOutlines.resize(firstOutlineIndex);
+	objFilePolygonStarts.resize(firstPolygon);
+	objFilePolygonCorners.resize(firstPolygonCorner);
+
+	CatmullClarkPatcher patcher;
+	patcher.setPolygons(polygons);
+	std::vector<std::vector<std::vector<Eigen::Vector3f> > > patches;
+	patcher.buildPatches(patches);
+	for (std::vector<std::vector<std::vector<Eigen::Vector3f> > >::size_type i = 0; i < patches.size(); i++) {
+		BezierPatch patch;
+		for (int row = 0; row < 4; row++) {
+			patch.addCurve(patches[i][row]);
+		}
+		listOfBezierPatches.push_back(std::move(patch));
+	}
+
+	if (debug) {
+		cout << filename << ": " << polygons.size() << " faces -> " << patches.size() << " Bezier patches ("
+				<< patcher.numberOfExtraordinaryVertices << " extraordinary vertices)\n";
+	}
+}
+
+
 //****************************************************
 // function that determines if full string ends with ending
 //***************************************************
@@ -925,6 +2274,181 @@ static bool hasEnding (std::string const &fullString, std::string const &ending)
     }
 }
 
+//****************************************************
+// Describes every option that changes how a .bez file is tessellated, for the tessellation cache's keys
+//***************************************************
+string tessellationOptions() {
+	std::ostringstream options;
+	options.precision(9);
+	options << subdivisionMethod << " " << subdivisionParameter;
+	if (subdivisionMethod == "ADAPTIVE" || subdivisionMethod == "FLATNESS") {
+		options << " maxdepth " << maxSubdivisionDepth;
+	}
+	if (subdivisionMethod == "ADAPTIVE") {
+		options << " maxtriangles " << maxTrianglesPerPatch << " metric " << adaptiveMetricName;
+		// (the traversal order decides which triangles the depth and triangle limits cut short)
+		if (DEPTH_FIRST_ADAPTIVE) {
+			options << " dfs";
+		}
+	}
+	if (subdivisionMethod == "BUDGET") {
+		options << " budget " << triangleBudget;
+	}
+	if (QUANTIZE) {
+		options << " quantized";
+	}
+	return options.str();
+}
+
+
+//****************************************************
+// Loads the .bez or .obj file 'assetFilename' into the scene (without tessellating it)
+// and returns its index in sceneAssets
+//***************************************************
+int loadSceneAsset(const string& assetFilename) {
+	if (!ifstream(assetFilename).good()) {
+		std::cout << "Could not open " << assetFilename << ".";
+		exit(1);
+	}
+
+	SceneAsset asset;
+	asset.filename = assetFilename;
+	asset.firstPatch = listOfBezierPatches.size();
+	asset.firstPolygon = objFilePolygonStarts.size();
+	asset.firstObjTriangle = objFileTriangleFaces.size();
+	asset.firstOutlineIndex = objFileOutlines.size();
+	asset.firstObjVertex = objFileVertices.size();
+
+	if (hasEnding(assetFilename, ".bez") && tessellationCache.isEnabled()) {
+		// Files that were tessellated before with the same options are read from the cache instead of parsed
+		ifstream file(assetFilename, std::ios::binary);
+		std::string fileContents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		asset.cacheKey = TessellationCache::key(fileContents, tessellationOptions());
+		asset.loadedFromCache = tessellationCache.load(asset.cacheKey, listOfBezierPatches);
+		if (!asset.loadedFromCache) {
+			parseBezierFile(assetFilename);
+		}
+		if (debug) {
+			cout << (asset.loadedFromCache ? "Loaded " : "Caching ") << assetFilename << " (tessellation cache entry "
+					<< tessellationCache.pathForKey(asset.cacheKey) << ")\n";
+		}
+	} else if (hasEnding(assetFilename, ".bez")) {
+		parseBezierFile(assetFilename);
+	} else if (hasEnding(assetFilename, ".obj") && CATMULL_CLARK) {
+		parseCatmullClarkPatches(assetFilename);
+	} else if (hasEnding(assetFilename, ".obj")) {
+		asset.objMode = true;
+		parseObjFile(assetFilename);
+	} else {
+		std::cout << "Unrecognized input file format: " << assetFilename << ".";
+		exit(1);
+	}
+
+	asset.numberOfPatches = listOfBezierPatches.size() - asset.firstPatch;
+	asset.numberOfPolygons = objFilePolygonStarts.size() - asset.firstPolygon;
+	asset.numberOfObjTriangles = objFileTriangleFaces.size() - asset.firstObjTriangle;
+	asset.numberOfOutlineIndices = objFileOutlines.size() - asset.firstOutlineIndex;
+	asset.numberOfObjVertices = objFileVertices.size() - asset.firstObjVertex;
+	sceneAssets.push_back(asset);
+	return sceneAssets.size() - 1;
+}
+
+
+//****************************************************
+// function that parses a .scene file, which places any number of .bez and .obj files in one scene.
+// Every line places one instance of a file:
+//
+//   instance teapot.bez translate 0 0 0
+//   instance teacup.bez scale 0.5 0.5 0.5 rotate 90 1 0 0 translate 4 0 0
+//
+// The transformations (translate x y z, rotate angleInDegrees axisX axisY axisZ, scale x y z) are applied to the
+// file's geometry in the order they are listed. Relative file names are relative to the .scene file, lines starting
+// with '#' are comments, and a file that is used several times is still loaded and tessellated only once.
+//***************************************************
+void parseSceneFile(const string& sceneFilename) {
+	ifstream file(sceneFilename);
+	if (!file.good()) {
+		std::cout << "Could not open " << sceneFilename << ".";
+		exit(1);
+	}
+
+	string directory;
+	string::size_type lastSlash = sceneFilename.find_last_of('/');
+	if (lastSlash != string::npos) {
+		directory = sceneFilename.substr(0, lastSlash + 1);
+	}
+
+	// Index in sceneAssets of every file that has been loaded so far
+	std::map<string, int> assetIndexByFilename;
+
+	string str;
+	int lineNumber = 0;
+	while (getline(file, str)) {
+		lineNumber++;
+		istringstream iss(str);
+		string keyword;
+		if (!(iss >> keyword) || keyword[0] == '#') {
+			continue;
+		}
+
+		string assetFilename;
+		if (keyword != "instance" || !(iss >> assetFilename)) {
+			std::cout << sceneFilename << ":" << lineNumber << ": expected 'instance filename [transformations]'.";
+			exit(1);
+		}
+		if (assetFilename[0] != '/') {
+			assetFilename = directory + assetFilename;
+		}
+
+		if (assetIndexByFilename.find(assetFilename) == assetIndexByFilename.end()) {
+			assetIndexByFilename[assetFilename] = loadSceneAsset(assetFilename);
+		}
+		SceneInstance instance(assetIndexByFilename[assetFilename]);
+
+		string transformation;
+		while (iss >> transformation) {
+			float x, y, z, angle;
+			if (transformation == "translate" && (iss >> x >> y >> z)) {
+				instance.translate(Eigen::Vector3f(x, y, z));
+			} else if (transformation == "rotate" && (iss >> angle >> x >> y >> z)) {
+				instance.rotate(angle, Eigen::Vector3f(x, y, z));
+			} else if (transformation == "scale" && (iss >> x >> y >> z)) {
+				instance.scale(Eigen::Vector3f(x, y, z));
+			} else {
+				std::cout << sceneFilename << ":" << lineNumber << ": invalid transformation '" << transformation << "'.";
+				exit(1);
+			}
+		}
+		sceneInstances.push_back(instance);
+	}
+}
+
+
+//****************************************************
+// The parameter 'argument' of the command line option 'flag' as a number (all of it, or the program
+// exits with an error, instead of with an exception from stof/stoi)
+//***************************************************
+float numberArgument(const string& flag, const char* argument) {
+	char* end;
+	float value = strtof(argument, &end);
+	if (end == argument || *end != '\0' || !std::isfinite(value)) {
+		std::cout << "Invalid parameter " << argument << " for " << flag << ", expected a number.";
+		exit(1);
+	}
+	return value;
+}
+
+int integerArgument(const string& flag, const char* argument) {
+	char* end;
+	long value = strtol(argument, &end, 10);
+	if (end == argument || *end != '\0' || value < numeric_limits<int>::min() || value > numeric_limits<int>::max()) {
+		std::cout << "Invalid parameter " << argument << " for " << flag << ", expected a whole number.";
+		exit(1);
+	}
+	return value;
+}
+
+
 //****************************************************
 // function that parses command line options,
 // given number of command line arguments (argc)
@@ -935,8 +2459,24 @@ static bool hasEnding (std::string const &fullString, std::string const &ending)
 void parseCommandLineOptions(int argc, char *argv[])
 {
 	subdivisionMethod = "UNIFORM";
+	DEPTH_FIRST_ADAPTIVE = false;
+	maxSubdivisionDepth = numeric_limits<int>::max();
+	maxTrianglesPerPatch = numeric_limits<int>::max();
+	adaptiveMetric = CHORD_METRIC;
+	adaptiveMetricName = "chord";
+	DECIMATE = false;
+	decimationTarget = 0;
+	decimationError = 0.0f;
+	OPTIMIZE_INDICES = false;
+	USE_TRIANGLE_STRIPS = false;
+	QUANTIZE = false;
+	ANIMATE = false;
+	errorReportSamples = 0;
 	string flag;
 
+	// File given with -o
+	string outputFilename;
+
 	int i = 1;
 	while (i <= argc - 1) {
 		flag = argv[i];
@@ -947,6 +2487,8 @@ void parseCommandLineOptions(int argc, char *argv[])
 				objMode = false;
 			} else if (hasEnding(flag, ".obj")) {
 				objMode = true;
+			} else if (hasEnding(flag, ".scene")) {
+				objMode = false;
 			} else {
 				std::cout << "Unrecognized input file format.";
 				exit(1);
@@ -959,13 +2501,170 @@ void parseCommandLineOptions(int argc, char *argv[])
 				std::cout << "Invalid number of parameters for -o.";
 				exit(1);
 			}
-			if (!objMode) {
-				WRITE_OBJ = true;
-				objFilenameOutput = argv[i+1];
+			// (what is written depends on the mode, which -catmullclark may still change)
+			outputFilename = argv[i+1];
+			i += 1;
+		} else if (flag == "-render") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -render.";
+				exit(1);
+			}
+			HEADLESS_RENDER = true;
+			renderFilename = argv[i+1];
+			i += 1;
+		} else if (flag == "-cache") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -cache.";
+				exit(1);
+			}
+			tessellationCache.directory = argv[i+1];
+			i += 1;
+		} else if (flag == "-patchsize") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -patchsize.";
+				exit(1);
+			}
+			fitPatchSize = numberArgument(flag, argv[i+1]);
+			if (fitPatchSize <= 0.0f) {
+				std::cout << "The patch size must be positive.";
+				exit(1);
+			}
+			i += 1;
+		} else if (flag == "-decimate" || flag == "-decimateerror") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for " << flag << ".";
+				exit(1);
+			}
+			DECIMATE = true;
+			// (0 stands for no target or no error bound, so neither may be given as 0)
+			if (flag == "-decimate") {
+				decimationTarget = integerArgument(flag, argv[i+1]);
+				if (decimationTarget <= 0) {
+					std::cout << "-decimate needs a positive number of triangles.";
+					exit(1);
+				}
 			} else {
-				std::cout << "Error: cannot write to .obj file if in .obj mode.";
+				decimationError = numberArgument(flag, argv[i+1]);
+				if (decimationError <= 0.0f) {
+					std::cout << "-decimateerror needs a positive error.";
+					exit(1);
+				}
+			}
+			i += 1;
+		} else if (flag == "-optimizeindices") {
+			OPTIMIZE_INDICES = true;
+		} else if (flag == "-quantize") {
+			QUANTIZE = true;
+			tessellationCache.quantizeVertices = true;
+		} else if (flag == "-strips") {
+			OPTIMIZE_INDICES = true;
+			USE_TRIANGLE_STRIPS = true;
+		} else if (flag == "-metric") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -metric.";
+				exit(1);
+			}
+			adaptiveMetricName = argv[i+1];
+			if (adaptiveMetricName == "chord") {
+				adaptiveMetric = CHORD_METRIC;
+			} else if (adaptiveMetricName == "normal") {
+				adaptiveMetric = NORMAL_METRIC;
+			} else if (adaptiveMetricName == "curvature") {
+				adaptiveMetric = CURVATURE_METRIC;
+			} else {
+				std::cout << "Unknown adaptive metric " << adaptiveMetricName << " (use chord, normal or curvature).";
+				exit(1);
+			}
+			i += 1;
+		} else if (flag == "-animate") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -animate.";
+				exit(1);
+			}
+			animationName = argv[i+1];
+			if (animationName != "twist" && animationName != "scale" && animationName != "wave") {
+				std::cout << "Unknown animation " << animationName << " (use twist, scale or wave).";
+				exit(1);
+			}
+			ANIMATE = true;
+			i += 1;
+		} else if (flag == "-errorreport") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -errorreport.";
+				exit(1);
+			}
+			errorReportSamples = integerArgument(flag, argv[i+1]);
+			if (errorReportSamples < 1) {
+				std::cout << "-errorreport needs at least 1 sample per side.";
+				exit(1);
+			}
+			i += 1;
+		} else if (flag == "-raybench") {
+			RAY_BENCHMARK = true;
+		} else if (flag == "-size") {
+			if ((i + 2) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -size.";
+				exit(1);
+			}
+			renderWidth = integerArgument(flag, argv[i+1]);
+			renderHeight = integerArgument(flag, argv[i+2]);
+			if (renderWidth <= 0 || renderHeight <= 0) {
+				std::cout << "-size needs a positive width and height.";
+				exit(1);
+			}
+			i += 2;
+		} else if (flag == "-catmullclark") {
+			CATMULL_CLARK = true;
+		} else if (flag == "-memorylimit") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -memorylimit.";
+				exit(1);
+			}
+			float megabytes = numberArgument(flag, argv[i+1]);
+			if (megabytes <= 0.0f) {
+				std::cout << "-memorylimit needs a positive number of megabytes.";
+				exit(1);
+			}
+			tessellationAccount.limit = (size_t) (megabytes * 1024 * 1024);
+			i += 1;
+		} else if (flag == "-filled") {
+			WIREFRAME_MODE = false;
+		} else if (flag == "-flat") {
+			SMOOTH_SHADING = false;
+		} else if (flag == "-hiddenline") {
+			HIDDEN_LINE_MODE = true;
+		} else if (flag == "-f") {
+			subdivisionMethod = "FLATNESS";
+		} else if (flag == "-dfs") {
+			DEPTH_FIRST_ADAPTIVE = true;
+		} else if (flag == "-maxdepth" || flag == "-maxtriangles" || flag == "-t") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for " << flag << ".";
 				exit(1);
 			}
+			int limit = integerArgument(flag, argv[i+1]);
+			if (limit < 0) {
+				std::cout << flag << " cannot be negative.";
+				exit(1);
+			}
+			if (flag == "-maxdepth") {
+				maxSubdivisionDepth = limit;
+			} else if (flag == "-maxtriangles") {
+				maxTrianglesPerPatch = limit;
+			} else {
+				subdivisionMethod = "BUDGET";
+				triangleBudget = limit;
+			}
 			i += 1;
 		}
 
@@ -976,10 +2675,46 @@ void parseCommandLineOptions(int argc, char *argv[])
 		i++;
 	}
 
-	if (hasEnding(filename, ".bez")) {
-		parseBezierFile(filename);
-	} else if (hasEnding(filename, ".obj")) {
-		parseObjFile(filename);
+	// Smoothed .obj files are Bezier patches, tessellated (and written to .obj files with -o) like .bez files, but
+	// their patches can also be written out to a .bez file
+	if (CATMULL_CLARK) {
+		objMode = false;
+	}
+	if (!outputFilename.empty()) {
+		if (CATMULL_CLARK && hasEnding(outputFilename, ".bez")) {
+			WRITE_BEZ = true;
+			bezFilenameOutput = outputFilename;
+		} else if (!objMode) {
+			WRITE_OBJ = true;
+			objFilenameOutput = outputFilename;
+		} else if (hasEnding(outputFilename, ".bez")) {
+			WRITE_BEZ = true;
+			bezFilenameOutput = outputFilename;
+		} else {
+			std::cout << "Error: cannot write to .obj file if in .obj mode (use a .bez file to convert to).";
+			exit(1);
+		}
+	}
+
+	if (hasEnding(filename, ".scene")) {
+		// One triangle budget for several files cannot be cached file by file
+		if (subdivisionMethod == "BUDGET") {
+			tessellationCache.directory.clear();
+		}
+		parseSceneFile(filename);
+	} else {
+		sceneInstances.push_back(SceneInstance(loadSceneAsset(filename)));
+	}
+
+	if (ANIMATE && QUANTIZE) {
+		std::cout << "Error: -animate needs the float tessellation, so it cannot be combined with -quantize.";
+		exit(1);
+	}
+
+	tessellateBezierPatches();
+
+	if (ANIMATE) {
+		setUpAnimations();
 	}
 }
 
@@ -1001,69 +2736,57 @@ void initializeCamera() {
 	xMax = yMax = zMax = numeric_limits<int>::min();
 
 
-	if (objMode) {
-		for (std::vector<std::vector<DifferentialGeometry> >::size_type i = 0; i < objFilePolygonList.size(); i++) {
-			std::vector<DifferentialGeometry> currentPolygon = objFilePolygonList[i];
+	// Iterate through all instances in the scene, and the points of the asset each of them places
+	for (std::vector<SceneInstance>::size_type k = 0; k < sceneInstances.size(); k++) {
+		const SceneInstance& instance = sceneInstances[k];
+		const SceneAsset& asset = sceneAssets[instance.assetIndex];
 
-			for (std::vector<DifferentialGeometry>::size_type j = 0; j < currentPolygon.size(); j++) {
-				Eigen::Vector3f currentDifferentialGeometryPosition = currentPolygon[j].position;
-
-				// Update min's, if applicable
-				if (currentDifferentialGeometryPosition.x() < xMin) {
-					xMin = currentDifferentialGeometryPosition.x();
-				}
-				if (currentDifferentialGeometryPosition.y() < yMin) {
-					yMin = currentDifferentialGeometryPosition.y();
-				}
-				if (currentDifferentialGeometryPosition.z() < zMin) {
-					zMin = currentDifferentialGeometryPosition.z();
+		std::vector<Eigen::Vector3f> assetPoints;
+		if (asset.objMode) {
+			for (int i = asset.firstPolygon; i < asset.firstPolygon + asset.numberOfPolygons; i++) {
+				for (unsigned int j = objFilePolygonStarts[i]; j < polygonEnd(i); j++) {
+					assetPoints.push_back(objFileVertices[objFilePolygonCorners[j]]);
 				}
-
-				// Update max's, if applicable
-				if (currentDifferentialGeometryPosition.x() > xMax) {
-					xMax = currentDifferentialGeometryPosition.x();
-				}
-				if (currentDifferentialGeometryPosition.y() > yMax) {
-					yMax = currentDifferentialGeometryPosition.y();
+			}
+		} else {
+			// Iterate through each BezierPatch's DifferentialGeometries...
+			for (int i = asset.firstPatch; i < asset.firstPatch + asset.numberOfPatches; i++) {
+				const BezierPatch& currentBezierPatch = listOfBezierPatches[i];
+				std::vector<DifferentialGeometry> decodedPoints;
+				if (currentBezierPatch.isCompressed()) {
+					currentBezierPatch.compressedMesh.decode(decodedPoints);
 				}
-				if (currentDifferentialGeometryPosition.z() > zMax) {
-					zMax = currentDifferentialGeometryPosition.z();
+				const std::vector<DifferentialGeometry>& points = currentBezierPatch.isCompressed() ? decodedPoints
+						: currentBezierPatch.listOfDifferentialGeometries;
+				for (std::vector<DifferentialGeometry>::size_type j = 0; j < points.size(); j++) {
+					assetPoints.push_back(points[j].position);
 				}
 			}
 		}
 
-	} else {
-
-		// Iterate through all BezierPatches...
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			BezierPatch currentBezierPatch = listOfBezierPatches[i];
+		for (std::vector<Eigen::Vector3f>::size_type j = 0; j < assetPoints.size(); j++) {
+			Eigen::Vector3f currentDifferentialGeometryPosition = instance.transformPoint(assetPoints[j]);
 
-			// Iterate through each BezierPatch's DifferentialGeometries...
-			for (std::vector<DifferentialGeometry>::size_type j = 0; j < currentBezierPatch.listOfDifferentialGeometries.size(); j++) {
-				Eigen::Vector3f currentDifferentialGeometryPosition = currentBezierPatch.listOfDifferentialGeometries[j].position;
-
-				// Update min's, if applicable
-				if (currentDifferentialGeometryPosition.x() < xMin) {
-					xMin = currentDifferentialGeometryPosition.x();
-				}
-				if (currentDifferentialGeometryPosition.y() < yMin) {
-					yMin = currentDifferentialGeometryPosition.y();
-				}
-				if (currentDifferentialGeometryPosition.z() < zMin) {
-					zMin = currentDifferentialGeometryPosition.z();
-				}
-
-				// Update max's, if applicable
-				if (currentDifferentialGeometryPosition.x() > xMax) {
-					xMax = currentDifferentialGeometryPosition.x();
-				}
-				if (currentDifferentialGeometryPosition.y() > yMax) {
-					yMax = currentDifferentialGeometryPosition.y();
-				}
-				if (currentDifferentialGeometryPosition.z() > zMax) {
-					zMax = currentDifferentialGeometryPosition.z();
-				}
+			// Update min's, if applicable
+			if (currentDifferentialGeometryPosition.x() < xMin) {
+				xMin = currentDifferentialGeometryPosition.x();
+			}
+			if (currentDifferentialGeometryPosition.y() < yMin) {
+				yMin = currentDifferentialGeometryPosition.y();
+			}
+			if (currentDifferentialGeometryPosition.z() < zMin) {
+				zMin = currentDifferentialGeometryPosition.z();
+			}
 
+			// Update max's, if applicable
+			if (currentDifferentialGeometryPosition.x() > xMax) {
+				xMax = currentDifferentialGeometryPosition.x();
+			}
+			if (currentDifferentialGeometryPosition.y() > yMax) {
+				yMax = currentDifferentialGeometryPosition.y();
+			}
+			if (currentDifferentialGeometryPosition.z() > zMax) {
+				zMax = currentDifferentialGeometryPosition.z();
 			}
 		}
 	}
@@ -1094,6 +2817,279 @@ void initializeCamera() {
 
 
 
+//****************************************************
+// Renders the scene with the software rasterizer, using the same camera, lights and display modes
+// as the OpenGL viewer, and writes the image to renderFilename (PNG if it ends in .png, PPM otherwise)
+//
+// NOTE: This method MUST be called AFTER initializeCamera()
+//****************************************************
+void renderHeadless() {
+	SoftwareRasterizer rasterizer(renderWidth, renderHeight);
+	rasterizer.SMOOTH_SHADING = SMOOTH_SHADING;
+	rasterizer.WIREFRAME_MODE = WIREFRAME_MODE;
+	rasterizer.HIDDEN_LINE_MODE = HIDDEN_LINE_MODE;
+	rasterizer.modelView = camera.modelViewMatrix();
+	rasterizer.projection = camera.projectionMatrix(((float) renderWidth) / ((float) renderHeight));
+	rasterizer.setGlobalAmbientColor(AMBIENT_COLOR);
+	rasterizer.addLight(LIGHT_COLOR_0, LIGHT_POSITION_0);
+	rasterizer.addLight(LIGHT_COLOR_1, LIGHT_POSITION_1);
+
+	for (std::vector<SceneInstance>::size_type n = 0; n < sceneInstances.size(); n++) {
+		const SceneInstance& instance = sceneInstances[n];
+		const SceneAsset& asset = sceneAssets[instance.assetIndex];
+		std::vector<RasterTriangle>::size_type firstTriangle = rasterizer.triangles.size();
+
+		if (asset.objMode) {
+			// The triangles the viewer draws, with the edges on the outlines of the faces flagged
+			for (int i = asset.firstObjTriangle; i < asset.firstObjTriangle + asset.numberOfObjTriangles; i++) {
+				RasterTriangle triangle;
+				for (int k = 0; k < 3; k++) {
+					triangle.positions[k] = objFileVertices[objFileTriangles[3 * i + k]];
+					triangle.normals[k] = objFileNormals[objFileTriangles[3 * i + k]];
+				}
+				triangle.edgeFlags = objFileTriangleEdgeFlags[i];
+				rasterizer.addTriangle(triangle);
+			}
+		} else {
+			for (int i = asset.firstPatch; i < asset.firstPatch + asset.numberOfPatches; i++) {
+				const BezierPatch& patch = listOfBezierPatches[i];
+				for (int j = 0; j < patch.numberOfTriangles(); j++) {
+					Triangle triangle = patch.triangle(j);
+					rasterizer.addTriangle(RasterTriangle(triangle.point1, triangle.point2, triangle.point3));
+				}
+			}
+		}
+
+		// Move this instance's copy of the asset into place (the OpenGL viewer does this with glMultMatrixf)
+		if (!instance.isIdentity()) {
+			for (std::vector<RasterTriangle>::size_type j = firstTriangle; j < rasterizer.triangles.size(); j++) {
+				for (int k = 0; k < 3; k++) {
+					rasterizer.triangles[j].positions[k] = instance.transformPoint(rasterizer.triangles[j].positions[k]);
+					rasterizer.triangles[j].normals[k] = instance.transformNormal(rasterizer.triangles[j].normals[k]);
+				}
+			}
+		}
+	}
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	rasterizer.render();
+	gettimeofday(&end, NULL);
+
+	bool written = hasEnding(renderFilename, ".png") ? rasterizer.writePNG(renderFilename) : rasterizer.writePPM(renderFilename);
+	if (!written) {
+		std::cout << "Could not write " << renderFilename << ".";
+		exit(1);
+	}
+
+	if (debug) {
+		cout << "\nRendered " << rasterizer.triangles.size() << " triangles to " << renderFilename << " in "
+				<< ((end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0) << " ms.\n";
+	}
+}
+
+//****************************************************
+// Adds every tessellated triangle of 'asset' to 'bvh' (for .obj files, the triangles of every face, with the
+// face index in place of the patch index) and builds it. The BVH is in the asset's own coordinates.
+//****************************************************
+void buildTriangleBVH(TriangleBVH& bvh, const SceneAsset& asset) {
+	bvh.clear();
+	if (asset.objMode) {
+		for (int i = asset.firstObjTriangle; i < asset.firstObjTriangle + asset.numberOfObjTriangles; i++) {
+			bvh.addTriangle(objFileVertices[objFileTriangles[3 * i]], objFileVertices[objFileTriangles[3 * i + 1]],
+					objFileVertices[objFileTriangles[3 * i + 2]], objFileTriangleFaces[i], i);
+		}
+	} else {
+		for (int i = asset.firstPatch; i < asset.firstPatch + asset.numberOfPatches; i++) {
+			const BezierPatch& patch = listOfBezierPatches[i];
+			for (int j = 0; j < patch.numberOfTriangles(); j++) {
+				Triangle triangle = patch.triangle(j);
+				bvh.addTriangle(triangle.point1.position, triangle.point2.position, triangle.point3.position, i, j);
+			}
+		}
+	}
+	bvh.build();
+}
+
+
+//****************************************************
+// Shoots one camera ray through the middle of every pixel of a renderWidth x renderHeight image, in parallel rows,
+// and returns how many of them 'intersect' reports as hits. The time it took (in ms) is stored in 'traceTime'.
+//****************************************************
+template <typename Intersect>
+long traceBenchmarkRays(const Eigen::Matrix4f& inverseViewProjection, Intersect intersect, double& traceTime) {
+	std::vector<int> hitsPerRow(renderHeight, 0);
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	parallelForEach(renderHeight, [&](int y) {
+		for (int x = 0; x < renderWidth; x++) {
+			float ndcX = 2.0f * (x + 0.5f) / renderWidth - 1.0f;
+			float ndcY = 1.0f - 2.0f * (y + 0.5f) / renderHeight;
+			if (intersect(cameraRay(inverseViewProjection, ndcX, ndcY))) {
+				hitsPerRow[y]++;
+			}
+		}
+	});
+	gettimeofday(&end, NULL);
+	traceTime = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+
+	long numberOfHits = 0;
+	for (int y = 0; y < renderHeight; y++) {
+		numberOfHits += hitsPerRow[y];
+	}
+	return numberOfHits;
+}
+
+
+//****************************************************
+// Shoots one ray through the middle of every pixel of a renderWidth x renderHeight image (using the viewer's camera),
+// first at the exact Bezier patches and then at their tessellated triangles, and reports how long building each
+// acceleration structure took and how many rays per second each of them traces
+//
+// NOTE: This method MUST be called AFTER initializeCamera()
+//****************************************************
+void runRayBenchmark() {
+	struct timeval start, end;
+	requireSubpatchDegrees("-raybench");
+
+	gettimeofday(&start, NULL);
+	PatchRayTracer rayTracer;
+	rayTracer.build(listOfBezierPatches);
+	gettimeofday(&end, NULL);
+	double patchBuildTime = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+
+	gettimeofday(&start, NULL);
+	TriangleBVH bvh;
+	buildTriangleBVH(bvh, sceneAssets[0]);
+	gettimeofday(&end, NULL);
+	double triangleBuildTime = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+
+	// Maps normalized device coordinates back to world space
+	Eigen::Matrix4f inverseViewProjection = (camera.projectionMatrix(((float) renderWidth) / ((float) renderHeight))
+			* camera.modelViewMatrix()).inverse();
+	long numberOfRays = (long) renderWidth * renderHeight;
+	double traceTime;
+
+	long numberOfHits = traceBenchmarkRays(inverseViewProjection, [&](const Ray& ray) {
+		PatchIntersection hit;
+		return rayTracer.intersect(ray, hit);
+	}, traceTime);
+	cout << "\nRay tracer: " << rayTracer.nodes.size() << " nodes over " << listOfBezierPatches.size()
+			<< " patches, built in " << patchBuildTime << " ms.\n";
+	cout << "Traced " << numberOfRays << " rays (" << numberOfHits << " hits) in " << traceTime << " ms on "
+			<< numberOfWorkerThreads() << " thread(s): " << (numberOfRays / (traceTime / 1000.0)) << " rays/sec.\n";
+
+	numberOfHits = traceBenchmarkRays(inverseViewProjection, [&](const Ray& ray) {
+		TriangleHit hit;
+		return bvh.intersect(ray, hit);
+	}, traceTime);
+	cout << "\nTriangle BVH: " << bvh.nodes.size() << " nodes over " << bvh.triangles.size()
+			<< " triangles, built in " << triangleBuildTime << " ms.\n";
+	cout << "Traced " << numberOfRays << " rays (" << numberOfHits << " hits) in " << traceTime << " ms on "
+			<< numberOfWorkerThreads() << " thread(s): " << (numberOfRays / (traceTime / 1000.0)) << " rays/sec.\n";
+}
+
+
+//****************************************************
+// Measures the true geometric error of the tessellation: for every patch, samples the exact surface on a grid of
+// (errorReportSamples + 1)^2 parameter values (half of them for triangular patches) and finds each sample's distance
+// to the closest tessellated triangle of its file, with one BVH per file and the patches measured in parallel.
+// Prints the largest and mean distance of every patch, and a histogram of its distances in decades of the file's
+// bounding box diagonal.
+//***************************************************
+void runErrorReport() {
+	const int NUMBER_OF_BINS = 6;
+	const float FIRST_BIN_LIMIT = 1e-6f;
+
+	struct PatchError {
+		float maximum;
+		double sum;
+		long numberOfSamples;
+		long histogram[NUMBER_OF_BINS];
+	};
+
+	for (std::vector<SceneAsset>::size_type a = 0; a < sceneAssets.size(); a++) {
+		const SceneAsset& asset = sceneAssets[a];
+		if (asset.objMode) {
+			continue;
+		}
+		struct timeval start, end;
+		gettimeofday(&start, NULL);
+
+		TriangleBVH bvh;
+		buildTriangleBVH(bvh, asset);
+		if (bvh.nodes.empty()) {
+			continue;
+		}
+		const BVHNode& root = bvh.nodes[0];
+		float diagonal = Eigen::Vector3f(root.boxMax[0] - root.boxMin[0], root.boxMax[1] - root.boxMin[1],
+				root.boxMax[2] - root.boxMin[2]).norm();
+
+		std::vector<PatchError> errors(asset.numberOfPatches);
+		parallelForEach(asset.numberOfPatches, [&](int k) {
+			const BezierPatch& patch = listOfBezierPatches[asset.firstPatch + k];
+			PatchError& error = errors[k];
+			error.maximum = 0.0f;
+			error.sum = 0.0;
+			error.numberOfSamples = 0;
+			std::fill(error.histogram, error.histogram + NUMBER_OF_BINS, 0L);
+
+			int n = errorReportSamples;
+			for (int i = 0; i <= n; i++) {
+				for (int j = 0; j <= (patch.triangular ? n - i : n); j++) {
+					Eigen::Vector3f position = patch.evaluateDifferentialGeometry((float) i / n, (float) j / n).position;
+					float distance = bvh.closestDistance(position);
+					error.maximum = std::max(error.maximum, distance);
+					error.sum += distance;
+					error.numberOfSamples++;
+
+					int bin = 0;
+					for (float limit = FIRST_BIN_LIMIT * diagonal; bin < NUMBER_OF_BINS - 1 && distance >= limit; limit *= 10.0f) {
+						bin++;
+					}
+					error.histogram[bin]++;
+				}
+			}
+		});
+		gettimeofday(&end, NULL);
+
+		printf("\nTessellation error of %s: distance from %d x %d samples of each exact patch to the closest triangle\n",
+				asset.filename.c_str(), errorReportSamples + 1, errorReportSamples + 1);
+		printf("(bounding box diagonal d = %g; histogram bins are decades of d, starting below %g d)\n\n", diagonal, FIRST_BIN_LIMIT);
+		printf("%7s %12s %12s   %s\n", "patch", "max", "mean", "<1e-6  <1e-5  <1e-4  <1e-3  <1e-2  >=1e-2");
+
+		PatchError total;
+		total.maximum = 0.0f;
+		total.sum = 0.0;
+		total.numberOfSamples = 0;
+		std::fill(total.histogram, total.histogram + NUMBER_OF_BINS, 0L);
+		for (int k = 0; k < asset.numberOfPatches; k++) {
+			const PatchError& error = errors[k];
+			// (numbered from 1, in the order of the file)
+			printf("%7d %12.6g %12.6g  ", k + 1, error.maximum, error.sum / std::max(error.numberOfSamples, 1L));
+			for (int bin = 0; bin < NUMBER_OF_BINS; bin++) {
+				printf(" %6ld", error.histogram[bin]);
+				total.histogram[bin] += error.histogram[bin];
+			}
+			printf("\n");
+			total.maximum = std::max(total.maximum, error.maximum);
+			total.sum += error.sum;
+			total.numberOfSamples += error.numberOfSamples;
+		}
+		printf("%7s %12.6g %12.6g  ", "all", total.maximum, total.sum / std::max(total.numberOfSamples, 1L));
+		for (int bin = 0; bin < NUMBER_OF_BINS; bin++) {
+			printf(" %6ld", total.histogram[bin]);
+		}
+		printf("\n");
+
+		if (debug) {
+			cout << "\nMeasured " << total.numberOfSamples << " samples in "
+					<< ((end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0) << " ms.\n";
+		}
+	}
+}
+
+
 //****************************************************
 // psuedocode for... everything
 //****************************************************
@@ -1142,9 +3138,18 @@ int main(int argc, char *argv[]) {
 	// Turns debug mode ON or OFF
 	debug = true;
 	WRITE_OBJ = false;
+	WRITE_BEZ = false;
+	CATMULL_CLARK = false;
+	fitPatchSize = 0.05f;
 
-	// This initializes glut
-	glutInit(&argc, argv);
+	// Default display modes (can be changed from the command line)
+	SMOOTH_SHADING = true;
+	WIREFRAME_MODE = true;
+	HIDDEN_LINE_MODE = false;
+
+	HEADLESS_RENDER = false;
+	RAY_BENCHMARK = false;
+	renderWidth = renderHeight = 1000;
 
 	// Parse command line options
 	parseCommandLineOptions(argc, argv);
@@ -1160,6 +3165,48 @@ int main(int argc, char *argv[]) {
 	// Initialize position, lookAt, and up vectors of camera so that we may feed them into OpenGL rendering system later
 	initializeCamera();
 
+	if (RAY_BENCHMARK) {
+		if (sceneInstances.size() != 1 || sceneAssets[0].objMode) {
+			std::cout << "Error: -raybench needs a single .bez file.";
+			exit(1);
+		}
+		runRayBenchmark();
+		return 0;
+	}
+
+	if (errorReportSamples > 0) {
+		runErrorReport();
+		return 0;
+	}
+
+	// Without a window, render a single image (of the animation's most deformed pose) and quit
+	if (HEADLESS_RENDER) {
+		if (ANIMATE) {
+			animateBezierPatches(0.25f * animations[0].period);
+		}
+		printCameraInformation();
+		renderHeadless();
+		return 0;
+	}
+
+	// Build the BVHs used for picking with the mouse, one per asset
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	pickingBVHs.resize(sceneAssets.size());
+	std::vector<BVHNode>::size_type numberOfNodes = 0;
+	for (std::vector<SceneAsset>::size_type i = 0; i < sceneAssets.size(); i++) {
+		buildTriangleBVH(pickingBVHs[i], sceneAssets[i]);
+		numberOfNodes += pickingBVHs[i].nodes.size();
+	}
+	gettimeofday(&end, NULL);
+	if (debug) {
+		cout << "\nBuilt picking BVHs (" << numberOfNodes << " nodes for " << sceneAssets.size() << " asset(s)) in "
+				<< ((end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0) << " ms.\n";
+	}
+
+	// This initializes glut
+	glutInit(&argc, argv);
+
 	//This tells glut to use a double-buffered window with red, green, and blue channels
 	glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGB);
 
@@ -1183,6 +3230,7 @@ int main(int argc, char *argv[]) {
 	// Handles key presses
 	glutKeyboardFunc( keyPressed );
 	glutSpecialFunc( handleSpecialKeypress );
+	glutMouseFunc( handleMouseClick );
 
 	glutMainLoop();							// infinite loop that will keep drawing and resizing
 	// and whatever else